@@ -0,0 +1,369 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "AABBTree.h"
+
+namespace
+{
+	AABB Union(const AABB& a, const AABB& b)
+	{
+		return AABB(
+			Vector3(Math::Min(a.mMin.x, b.mMin.x), Math::Min(a.mMin.y, b.mMin.y),
+				Math::Min(a.mMin.z, b.mMin.z)),
+			Vector3(Math::Max(a.mMax.x, b.mMax.x), Math::Max(a.mMax.y, b.mMax.y),
+				Math::Max(a.mMax.z, b.mMax.z)));
+	}
+
+	float SurfaceArea(const AABB& box)
+	{
+		Vector3 d = box.mMax - box.mMin;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	bool ContainsBox(const AABB& outer, const AABB& inner)
+	{
+		return outer.mMin.x <= inner.mMin.x && outer.mMin.y <= inner.mMin.y &&
+			outer.mMin.z <= inner.mMin.z && outer.mMax.x >= inner.mMax.x &&
+			outer.mMax.y >= inner.mMax.y && outer.mMax.z >= inner.mMax.z;
+	}
+}
+
+const size_t AABBTree::cMaxPacketSize;
+
+AABBTree::AABBTree(float margin)
+	:mRoot(cNull)
+	,mFreeList(cNull)
+	,mNumLeaves(0)
+	,mMargin(margin)
+{
+}
+
+int AABBTree::Insert(const AABB& box, const SlotHandle& userData)
+{
+	int leaf = AllocateNode();
+	Node& node = mNodes[leaf];
+	Vector3 margin(mMargin, mMargin, mMargin);
+	node.mBox = AABB(box.mMin - margin, box.mMax + margin);
+	node.mUserData = userData;
+	node.mHeight = 0;
+	InsertLeaf(leaf);
+	mNumLeaves++;
+	return leaf;
+}
+
+void AABBTree::Remove(int proxy)
+{
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	mNumLeaves--;
+}
+
+bool AABBTree::Update(int proxy, const AABB& box)
+{
+	// Still inside the fat box, so nothing to do
+	if (ContainsBox(mNodes[proxy].mBox, box))
+	{
+		return false;
+	}
+
+	RemoveLeaf(proxy);
+	Vector3 margin(mMargin, mMargin, mMargin);
+	mNodes[proxy].mBox = AABB(box.mMin - margin, box.mMax + margin);
+	InsertLeaf(proxy);
+	return true;
+}
+
+void AABBTree::Clear()
+{
+	mNodes.clear();
+	mRoot = cNull;
+	mFreeList = cNull;
+	mNumLeaves = 0;
+}
+
+int AABBTree::GetHeight() const
+{
+	return mRoot == cNull ? -1 : mNodes[mRoot].mHeight;
+}
+
+float AABBTree::GetAreaRatio() const
+{
+	if (mRoot == cNull)
+	{
+		return 0.0f;
+	}
+
+	float total = 0.0f;
+	for (const Node& node : mNodes)
+	{
+		// Skip free nodes and leaves
+		if (node.mHeight > 0)
+		{
+			total += SurfaceArea(node.mBox);
+		}
+	}
+	float rootArea = SurfaceArea(mNodes[mRoot].mBox);
+	return rootArea > 0.0f ? total / rootArea : 0.0f;
+}
+
+#ifdef MATH_SIMD
+void AABBTree::MakePacket(const LineSegment* segments, size_t count, RayPacket& outPacket)
+{
+	alignas(16) float start[3][cMaxPacketSize];
+	alignas(16) float invDir[3][cMaxPacketSize];
+	for (size_t i = 0; i < cMaxPacketSize; i++)
+	{
+		// Unused lanes copy the last ray (their maxT keeps them out)
+		Ray ray = MakeRay(segments[Math::Min(i, count - 1)]);
+		start[0][i] = ray.mStart.x;
+		start[1][i] = ray.mStart.y;
+		start[2][i] = ray.mStart.z;
+		invDir[0][i] = ray.mInvDir.x;
+		invDir[1][i] = ray.mInvDir.y;
+		invDir[2][i] = ray.mInvDir.z;
+		outPacket.mMaxT[i] = i < count ? 1.0f : -1.0f;
+	}
+
+	outPacket.mNumGroups = (count + 3) / 4;
+	for (size_t g = 0; g < outPacket.mNumGroups; g++)
+	{
+		outPacket.mStartX[g] = _mm_load_ps(start[0] + 4 * g);
+		outPacket.mStartY[g] = _mm_load_ps(start[1] + 4 * g);
+		outPacket.mStartZ[g] = _mm_load_ps(start[2] + 4 * g);
+		outPacket.mInvDirX[g] = _mm_load_ps(invDir[0] + 4 * g);
+		outPacket.mInvDirY[g] = _mm_load_ps(invDir[1] + 4 * g);
+		outPacket.mInvDirZ[g] = _mm_load_ps(invDir[2] + 4 * g);
+	}
+}
+#endif
+
+int AABBTree::AllocateNode()
+{
+	if (mFreeList == cNull)
+	{
+		mNodes.emplace_back();
+		return static_cast<int>(mNodes.size()) - 1;
+	}
+
+	int index = mFreeList;
+	mFreeList = mNodes[index].mParent;
+	mNodes[index] = Node();
+	return index;
+}
+
+void AABBTree::FreeNode(int index)
+{
+	mNodes[index].mParent = mFreeList;
+	mNodes[index].mHeight = -1;
+	mFreeList = index;
+}
+
+void AABBTree::InsertLeaf(int leaf)
+{
+	if (mRoot == cNull)
+	{
+		mRoot = leaf;
+		mNodes[leaf].mParent = cNull;
+		return;
+	}
+
+	// Walk down to the best sibling. At each node, either pair the
+	// leaf with this node, or go into the child that costs less.
+	AABB leafBox = mNodes[leaf].mBox;
+	int index = mRoot;
+	while (!mNodes[index].IsLeaf())
+	{
+		const Node& node = mNodes[index];
+		float area = SurfaceArea(node.mBox);
+		float combinedArea = SurfaceArea(Union(node.mBox, leafBox));
+		// Making a new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+		// Every ancestor below here grows by this much as well
+		float inheritedCost = 2.0f * (combinedArea - area);
+
+		auto childCost = [&](int child) {
+			const Node& c = mNodes[child];
+			float grown = SurfaceArea(Union(c.mBox, leafBox));
+			if (c.IsLeaf())
+			{
+				return grown + inheritedCost;
+			}
+			return grown - SurfaceArea(c.mBox) + inheritedCost;
+		};
+		float cost1 = childCost(node.mChild1);
+		float cost2 = childCost(node.mChild2);
+
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
+		index = cost1 < cost2 ? node.mChild1 : node.mChild2;
+	}
+	int sibling = index;
+
+	// New parent for the sibling and the leaf
+	int oldParent = mNodes[sibling].mParent;
+	int newParent = AllocateNode();
+	Node& parent = mNodes[newParent];
+	parent.mParent = oldParent;
+	parent.mBox = Union(leafBox, mNodes[sibling].mBox);
+	parent.mHeight = mNodes[sibling].mHeight + 1;
+	parent.mChild1 = sibling;
+	parent.mChild2 = leaf;
+	mNodes[sibling].mParent = newParent;
+	mNodes[leaf].mParent = newParent;
+
+	if (oldParent == cNull)
+	{
+		mRoot = newParent;
+	}
+	else if (mNodes[oldParent].mChild1 == sibling)
+	{
+		mNodes[oldParent].mChild1 = newParent;
+	}
+	else
+	{
+		mNodes[oldParent].mChild2 = newParent;
+	}
+
+	Refit(oldParent);
+}
+
+void AABBTree::RemoveLeaf(int leaf)
+{
+	if (leaf == mRoot)
+	{
+		mRoot = cNull;
+		return;
+	}
+
+	// The sibling takes the parent's place
+	int parent = mNodes[leaf].mParent;
+	int grandParent = mNodes[parent].mParent;
+	int sibling = mNodes[parent].mChild1 == leaf ?
+		mNodes[parent].mChild2 : mNodes[parent].mChild1;
+
+	mNodes[sibling].mParent = grandParent;
+	FreeNode(parent);
+	if (grandParent == cNull)
+	{
+		mRoot = sibling;
+		return;
+	}
+
+	if (mNodes[grandParent].mChild1 == parent)
+	{
+		mNodes[grandParent].mChild1 = sibling;
+	}
+	else
+	{
+		mNodes[grandParent].mChild2 = sibling;
+	}
+	Refit(grandParent);
+}
+
+void AABBTree::Refit(int index)
+{
+	while (index != cNull)
+	{
+		index = Balance(index);
+
+		Node& node = mNodes[index];
+		const Node& child1 = mNodes[node.mChild1];
+		const Node& child2 = mNodes[node.mChild2];
+		node.mHeight = 1 + Math::Max(child1.mHeight, child2.mHeight);
+		node.mBox = Union(child1.mBox, child2.mBox);
+
+		index = node.mParent;
+	}
+}
+
+int AABBTree::Balance(int iA)
+{
+	// A has children B and C. If one of them is more than one level
+	// taller than the other, it's rotated up into A's place: A becomes
+	// its first child, and A takes the shorter of its two children.
+	Node* A = &mNodes[iA];
+	if (A->IsLeaf() || A->mHeight < 2)
+	{
+		return iA;
+	}
+
+	int iB = A->mChild1;
+	int iC = A->mChild2;
+	int balance = mNodes[iC].mHeight - mNodes[iB].mHeight;
+
+	// Rotate C up, or B up (the same with the names swapped)
+	int iUp;
+	int iOther;
+	if (balance > 1)
+	{
+		iUp = iC;
+		iOther = iB;
+	}
+	else if (balance < -1)
+	{
+		iUp = iB;
+		iOther = iC;
+	}
+	else
+	{
+		return iA;
+	}
+
+	Node* up = &mNodes[iUp];
+	int iF = up->mChild1;
+	int iG = up->mChild2;
+	Node* F = &mNodes[iF];
+	Node* G = &mNodes[iG];
+
+	// Swap A and the child that goes up
+	up->mChild1 = iA;
+	up->mParent = A->mParent;
+	A->mParent = iUp;
+	if (up->mParent == cNull)
+	{
+		mRoot = iUp;
+	}
+	else if (mNodes[up->mParent].mChild1 == iA)
+	{
+		mNodes[up->mParent].mChild1 = iUp;
+	}
+	else
+	{
+		mNodes[up->mParent].mChild2 = iUp;
+	}
+
+	// The taller of its children stays with it, the other goes to A
+	int iKeep = iF;
+	int iMove = iG;
+	if (F->mHeight < G->mHeight)
+	{
+		iKeep = iG;
+		iMove = iF;
+	}
+	up->mChild2 = iKeep;
+	if (iUp == iC)
+	{
+		A->mChild2 = iMove;
+	}
+	else
+	{
+		A->mChild1 = iMove;
+	}
+	mNodes[iMove].mParent = iA;
+
+	const Node& other = mNodes[iOther];
+	const Node& moved = mNodes[iMove];
+	const Node& kept = mNodes[iKeep];
+	A->mBox = Union(other.mBox, moved.mBox);
+	A->mHeight = 1 + Math::Max(other.mHeight, moved.mHeight);
+	up->mBox = Union(A->mBox, kept.mBox);
+	up->mHeight = 1 + Math::Max(A->mHeight, kept.mHeight);
+	return iUp;
+}
@@ -0,0 +1,400 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "Math.h"
+#include "Collision.h"
+#include "SlotMap.h"
+
+// Dynamic bounding volume hierarchy. Each leaf holds a "fat" box (the
+// real box grown by a margin), so small moves don't change the tree.
+// Inserts pick the sibling that adds the least surface area, and
+// nodes are rotated on the way back up to keep the tree balanced.
+class AABBTree
+{
+public:
+	AABBTree(float margin);
+
+	// Returns the proxy for the new leaf
+	int Insert(const AABB& box, const SlotHandle& userData);
+	void Remove(int proxy);
+	// Call when the box moves. Returns true if the leaf was reinserted
+	// (only when the box leaves its fat box).
+	bool Update(int proxy, const AABB& box);
+	void Clear();
+
+	const SlotHandle& GetUserData(int proxy) const { return mNodes[proxy].mUserData; }
+	const AABB& GetFatBox(int proxy) const { return mNodes[proxy].mBox; }
+	size_t GetNumLeaves() const { return mNumLeaves; }
+	// Height of the root (0 for one leaf, -1 when empty)
+	int GetHeight() const;
+	// Total area of all internal nodes over the root's area
+	// (lower is better; for tracking tree quality)
+	float GetAreaRatio() const;
+	// Bytes allocated for the nodes
+	size_t GetMemoryUsage() const { return mNodes.capacity() * sizeof(Node); }
+
+	// Visits the leaves the segment enters, nearest first.
+	// func(userData, maxT) tests the real box, and returns the new
+	// closest t if it hit (or maxT if it didn't). Nodes farther than
+	// the closest hit so far are skipped.
+	template <typename Func>
+	void SegmentCast(const LineSegment& l, Func func) const;
+	// The same for a box with these half extents moving along l (each
+	// node is treated as if grown by the extents)
+	template <typename Func>
+	void SweepCast(const LineSegment& l, const Vector3& extents, Func func) const;
+
+	// Casts the segments packetSize (4, 8 or 16) at a time, with one
+	// walk of the tree per packet and SIMD slab tests. Pays off when
+	// the segments in a packet start near each other and go the same
+	// way. func(userData, index, maxT) is as for SegmentCast, where
+	// index is the segment's position in segments.
+	template <typename Func>
+	void SegmentCastPacket(const LineSegment* segments, size_t count,
+		size_t packetSize, Func func) const;
+	static const size_t cMaxPacketSize = 16;
+
+	// Calls func(userData) for each leaf whose fat box overlaps box
+	template <typename Func>
+	void Query(const AABB& box, Func func) const;
+private:
+	static const int cNull = -1;
+
+	struct Node
+	{
+		Node()
+			:mBox(Vector3::Zero, Vector3::Zero)
+			,mParent(cNull)
+			,mChild1(cNull)
+			,mChild2(cNull)
+			,mHeight(-1)
+		{}
+		bool IsLeaf() const { return mChild1 == cNull; }
+
+		AABB mBox;
+		SlotHandle mUserData;
+		// Parent, or the next free node when on the free list
+		int mParent;
+		int mChild1;
+		int mChild2;
+		// Leaves are 0, free nodes are -1
+		int mHeight;
+	};
+
+	// Precomputed for the slab tests of one segment
+	struct Ray
+	{
+		Vector3 mStart;
+		Vector3 mInvDir;
+		// Added to every box (for sweeps)
+		Vector3 mExtents;
+	};
+	static Ray MakeRay(const LineSegment& l);
+	// Returns the t where the ray enters box, if that's <= maxT
+	static bool RayEnters(const Ray& ray, const AABB& box, float maxT, float& outT);
+
+#ifdef MATH_SIMD
+	// Up to 16 rays, four to a register
+	struct RayPacket
+	{
+		__m128 mStartX[4];
+		__m128 mStartY[4];
+		__m128 mStartZ[4];
+		__m128 mInvDirX[4];
+		__m128 mInvDirY[4];
+		__m128 mInvDirZ[4];
+		// Closest hit so far for each ray (-1 for unused lanes, so
+		// they never hit anything)
+		alignas(16) float mMaxT[cMaxPacketSize];
+		size_t mNumGroups;
+	};
+	static void MakePacket(const LineSegment* segments, size_t count, RayPacket& outPacket);
+	// Returns a mask with bit i set if ray i enters box no later than
+	// its maxT, and the smallest t where one of them enters
+	static uint32_t PacketEnters(const RayPacket& packet, const AABB& box, float& outMinT);
+#endif
+
+	int AllocateNode();
+	void FreeNode(int index);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	// Fixes heights and boxes from index to the root, rotating as needed
+	void Refit(int index);
+	// Rotates the subtree at index if it's unbalanced, and returns
+	// the index of its new root
+	int Balance(int index);
+
+	std::vector<Node> mNodes;
+	int mRoot;
+	int mFreeList;
+	size_t mNumLeaves;
+	float mMargin;
+};
+
+inline AABBTree::Ray AABBTree::MakeRay(const LineSegment& l)
+{
+	// A zero direction would give 0 * inf = NaN, so use a large
+	// number instead (the slab is then either always or never hit)
+	Ray ray;
+	ray.mStart = l.mStart;
+	Vector3 dir = l.mEnd - l.mStart;
+	ray.mInvDir.x = dir.x != 0.0f ? 1.0f / dir.x : 1e30f;
+	ray.mInvDir.y = dir.y != 0.0f ? 1.0f / dir.y : 1e30f;
+	ray.mInvDir.z = dir.z != 0.0f ? 1.0f / dir.z : 1e30f;
+	ray.mExtents = Vector3::Zero;
+	return ray;
+}
+
+inline bool AABBTree::RayEnters(const Ray& ray, const AABB& box, float maxT, float& outT)
+{
+	Vector3 boxMin = box.mMin - ray.mExtents;
+	Vector3 boxMax = box.mMax + ray.mExtents;
+	float x1 = (boxMin.x - ray.mStart.x) * ray.mInvDir.x;
+	float x2 = (boxMax.x - ray.mStart.x) * ray.mInvDir.x;
+	float y1 = (boxMin.y - ray.mStart.y) * ray.mInvDir.y;
+	float y2 = (boxMax.y - ray.mStart.y) * ray.mInvDir.y;
+	float z1 = (boxMin.z - ray.mStart.z) * ray.mInvDir.z;
+	float z2 = (boxMax.z - ray.mStart.z) * ray.mInvDir.z;
+	float enter = Math::Max(Math::Max(Math::Min(x1, x2), Math::Min(y1, y2)),
+		Math::Max(Math::Min(z1, z2), 0.0f));
+	float exit = Math::Min(Math::Min(Math::Max(x1, x2), Math::Max(y1, y2)),
+		Math::Min(Math::Max(z1, z2), maxT));
+	outT = enter;
+	return enter <= exit;
+}
+
+template <typename Func>
+void AABBTree::SegmentCast(const LineSegment& l, Func func) const
+{
+	SweepCast(l, Vector3::Zero, func);
+}
+
+template <typename Func>
+void AABBTree::SweepCast(const LineSegment& l, const Vector3& extents, Func func) const
+{
+	if (mRoot == cNull)
+	{
+		return;
+	}
+
+	struct Entry
+	{
+		int mNode;
+		float mT;
+	};
+	// Per thread, so it's only allocated once
+	thread_local std::vector<Entry> stack;
+	stack.clear();
+
+	Ray ray = MakeRay(l);
+	ray.mExtents = extents;
+	float maxT = 1.0f;
+	float t;
+	if (RayEnters(ray, mNodes[mRoot].mBox, maxT, t))
+	{
+		stack.push_back(Entry{ mRoot, t });
+	}
+	while (!stack.empty())
+	{
+		Entry entry = stack.back();
+		stack.pop_back();
+		// A closer hit was found since this was pushed
+		if (entry.mT > maxT)
+		{
+			continue;
+		}
+
+		const Node& node = mNodes[entry.mNode];
+		if (node.IsLeaf())
+		{
+			maxT = func(node.mUserData, maxT);
+			continue;
+		}
+
+		// Push the farther child first, so the nearer one is next
+		float t1, t2;
+		bool hit1 = RayEnters(ray, mNodes[node.mChild1].mBox, maxT, t1);
+		bool hit2 = RayEnters(ray, mNodes[node.mChild2].mBox, maxT, t2);
+		if (hit1 && hit2)
+		{
+			if (t1 <= t2)
+			{
+				stack.push_back(Entry{ node.mChild2, t2 });
+				stack.push_back(Entry{ node.mChild1, t1 });
+			}
+			else
+			{
+				stack.push_back(Entry{ node.mChild1, t1 });
+				stack.push_back(Entry{ node.mChild2, t2 });
+			}
+		}
+		else if (hit1)
+		{
+			stack.push_back(Entry{ node.mChild1, t1 });
+		}
+		else if (hit2)
+		{
+			stack.push_back(Entry{ node.mChild2, t2 });
+		}
+	}
+}
+
+#ifdef MATH_SIMD
+inline uint32_t AABBTree::PacketEnters(const RayPacket& packet, const AABB& box, float& outMinT)
+{
+	const __m128 minX = _mm_set1_ps(box.mMin.x);
+	const __m128 minY = _mm_set1_ps(box.mMin.y);
+	const __m128 minZ = _mm_set1_ps(box.mMin.z);
+	const __m128 maxX = _mm_set1_ps(box.mMax.x);
+	const __m128 maxY = _mm_set1_ps(box.mMax.y);
+	const __m128 maxZ = _mm_set1_ps(box.mMax.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 inf = _mm_set1_ps(Math::Infinity);
+	__m128 minT = inf;
+	uint32_t mask = 0;
+	// Same as RayEnters, four rays at a time
+	for (size_t g = 0; g < packet.mNumGroups; g++)
+	{
+		__m128 x1 = _mm_mul_ps(_mm_sub_ps(minX, packet.mStartX[g]), packet.mInvDirX[g]);
+		__m128 x2 = _mm_mul_ps(_mm_sub_ps(maxX, packet.mStartX[g]), packet.mInvDirX[g]);
+		__m128 y1 = _mm_mul_ps(_mm_sub_ps(minY, packet.mStartY[g]), packet.mInvDirY[g]);
+		__m128 y2 = _mm_mul_ps(_mm_sub_ps(maxY, packet.mStartY[g]), packet.mInvDirY[g]);
+		__m128 z1 = _mm_mul_ps(_mm_sub_ps(minZ, packet.mStartZ[g]), packet.mInvDirZ[g]);
+		__m128 z2 = _mm_mul_ps(_mm_sub_ps(maxZ, packet.mStartZ[g]), packet.mInvDirZ[g]);
+		__m128 enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(x1, x2), _mm_min_ps(y1, y2)),
+			_mm_max_ps(_mm_min_ps(z1, z2), zero));
+		__m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(x1, x2), _mm_max_ps(y1, y2)),
+			_mm_min_ps(_mm_max_ps(z1, z2), _mm_load_ps(packet.mMaxT + 4 * g)));
+		__m128 hit = _mm_cmple_ps(enter, exit);
+		mask |= static_cast<uint32_t>(_mm_movemask_ps(hit)) << (4 * g);
+		minT = _mm_min_ps(minT, _mm_or_ps(_mm_and_ps(hit, enter), _mm_andnot_ps(hit, inf)));
+	}
+	minT = _mm_min_ps(minT, _mm_shuffle_ps(minT, minT, _MM_SHUFFLE(2, 3, 0, 1)));
+	minT = _mm_min_ps(minT, _mm_shuffle_ps(minT, minT, _MM_SHUFFLE(1, 0, 3, 2)));
+	outMinT = _mm_cvtss_f32(minT);
+	return mask;
+}
+#endif
+
+template <typename Func>
+void AABBTree::SegmentCastPacket(const LineSegment* segments, size_t count,
+	size_t packetSize, Func func) const
+{
+#ifdef MATH_SIMD
+	if (mRoot == cNull)
+	{
+		return;
+	}
+
+	// Whole registers only
+	packetSize = Math::Clamp<size_t>((packetSize + 3) & ~static_cast<size_t>(3), 4, cMaxPacketSize);
+	thread_local std::vector<int> stack;
+	for (size_t first = 0; first < count; first += packetSize)
+	{
+		RayPacket packet;
+		MakePacket(segments + first, Math::Min(packetSize, count - first), packet);
+
+		// As in SegmentCast, but a node is visited if any of the rays
+		// enters it, and the nearer child is the one a ray enters first
+		stack.clear();
+		float t;
+		if (PacketEnters(packet, mNodes[mRoot].mBox, t) != 0)
+		{
+			stack.push_back(mRoot);
+		}
+		while (!stack.empty())
+		{
+			const Node& node = mNodes[stack.back()];
+			stack.pop_back();
+			if (node.IsLeaf())
+			{
+				// Closer hits since this was pushed may rule some rays out
+				uint32_t mask = PacketEnters(packet, node.mBox, t);
+				for (size_t lane = 0; mask != 0; lane++, mask >>= 1)
+				{
+					if (mask & 1)
+					{
+						packet.mMaxT[lane] = func(node.mUserData, first + lane,
+							packet.mMaxT[lane]);
+					}
+				}
+				continue;
+			}
+
+			float t1, t2;
+			bool hit1 = PacketEnters(packet, mNodes[node.mChild1].mBox, t1) != 0;
+			bool hit2 = PacketEnters(packet, mNodes[node.mChild2].mBox, t2) != 0;
+			if (hit1 && hit2)
+			{
+				if (t1 <= t2)
+				{
+					stack.push_back(node.mChild2);
+					stack.push_back(node.mChild1);
+				}
+				else
+				{
+					stack.push_back(node.mChild1);
+					stack.push_back(node.mChild2);
+				}
+			}
+			else if (hit1)
+			{
+				stack.push_back(node.mChild1);
+			}
+			else if (hit2)
+			{
+				stack.push_back(node.mChild2);
+			}
+		}
+	}
+#else
+	// No SIMD, so cast them one at a time
+	for (size_t i = 0; i < count; i++)
+	{
+		SegmentCast(segments[i], [&func, i](const SlotHandle& userData, float maxT) {
+			return func(userData, i, maxT);
+		});
+	}
+#endif
+}
+
+template <typename Func>
+void AABBTree::Query(const AABB& box, Func func) const
+{
+	if (mRoot == cNull)
+	{
+		return;
+	}
+
+	thread_local std::vector<int> stack;
+	stack.clear();
+	stack.push_back(mRoot);
+	while (!stack.empty())
+	{
+		const Node& node = mNodes[stack.back()];
+		stack.pop_back();
+		if (!Intersect(node.mBox, box))
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			func(node.mUserData);
+		}
+		else
+		{
+			stack.push_back(node.mChild1);
+			stack.push_back(node.mChild2);
+		}
+	}
+}
@@ -10,6 +10,7 @@
 #include "Game.h"
 #include "Component.h"
 #include "LevelLoader.h"
+#include "TransformBatch.h"
 
 const char* Actor::TypeNames[NUM_ACTOR_TYPES] = {
 	"Actor",
@@ -26,6 +27,11 @@ Actor::Actor(Game* game)
 	,mScale(1.0f)
 	,mGame(game)
 	,mRecomputeTransform(true)
+	,mStatic(false)
+	,mPrevPosition(Vector3::Zero)
+	,mPrevRotation(Quaternion::Identity)
+	,mPrevScale(1.0f)
+	,mHasPrevTransform(false)
 {
 	mGame->AddActor(this);
 }
@@ -43,17 +49,24 @@ Actor::~Actor()
 
 void Actor::Update(float deltaTime)
 {
+	BeginUpdate();
 	if (mState == EActive)
 	{
-		if (mRecomputeTransform)
-		{
-			ComputeWorldTransform();
-		}
 		UpdateComponents(deltaTime);
 		UpdateActor(deltaTime);
 	}
 }
 
+void Actor::BeginUpdate()
+{
+	// Save off last tick's transform for interpolation
+	StorePreviousTransform();
+	if (mState == EActive && mRecomputeTransform)
+	{
+		ComputeWorldTransform();
+	}
+}
+
 void Actor::UpdateComponents(float deltaTime)
 {
 	for (auto comp : mComponents)
@@ -87,11 +100,19 @@ void Actor::ActorInput(const uint8_t* keyState)
 
 void Actor::ComputeWorldTransform()
 {
-	mRecomputeTransform = false;
 	// Scale, then rotate, then translate
-	mWorldTransform = Matrix4::CreateScale(mScale);
-	mWorldTransform *= Matrix4::CreateFromQuaternion(mRotation);
-	mWorldTransform *= Matrix4::CreateTranslation(mPosition);
+	SetWorldTransform(TransformBatch::Compose(mPosition, mRotation, mScale));
+}
+
+void Actor::SetWorldTransform(const Matrix4& world)
+{
+	// The first transform is also the previous one
+	if (!mHasPrevTransform)
+	{
+		StorePreviousTransform();
+	}
+	mRecomputeTransform = false;
+	mWorldTransform = world;
 
 	// Inform components world transform updated
 	for (auto comp : mComponents)
@@ -100,6 +121,67 @@ void Actor::ComputeWorldTransform()
 	}
 }
 
+void Actor::StorePreviousTransform()
+{
+	mPrevPosition = mPosition;
+	mPrevRotation = mRotation;
+	mPrevScale = mScale;
+	mHasPrevTransform = true;
+}
+
+void Actor::InterpolateTransform(float alpha)
+{
+	if (mRecomputeTransform)
+	{
+		ComputeWorldTransform();
+	}
+
+	// Most actors don't move, so skip the blend if nothing changed
+	bool moved = mPosition.x != mPrevPosition.x ||
+		mPosition.y != mPrevPosition.y ||
+		mPosition.z != mPrevPosition.z ||
+		mRotation.x != mPrevRotation.x ||
+		mRotation.y != mPrevRotation.y ||
+		mRotation.z != mPrevRotation.z ||
+		mRotation.w != mPrevRotation.w ||
+		mScale != mPrevScale;
+	if (!moved || alpha >= 1.0f)
+	{
+		mRenderTransform = mWorldTransform;
+		return;
+	}
+
+	// Blend each part, then compose them as ComputeWorldTransform does
+	float scale = Math::Lerp(mPrevScale, mScale, alpha);
+	Quaternion rot = Quaternion::Slerp(mPrevRotation, mRotation, alpha);
+	Vector3 pos = Vector3::Lerp(mPrevPosition, mPosition, alpha);
+	mRenderTransform = TransformBatch::Compose(pos, rot, scale);
+}
+
+void Actor::SetStatic(bool isStatic)
+{
+	if (isStatic == mStatic)
+	{
+		return;
+	}
+	mStatic = isStatic;
+
+	if (mStatic)
+	{
+		// Freeze the transform, since nothing will update it again
+		ComputeWorldTransform();
+		StorePreviousTransform();
+		InterpolateTransform(1.0f);
+	}
+	for (auto comp : mComponents)
+	{
+		ComponentPool::SetStatic(comp, mStatic);
+		comp->OnSetStatic(mStatic);
+	}
+	// Move to/from Game's list of static actors
+	mGame->SetActorStatic(this);
+}
+
 void Actor::RotateToNewForward(const Vector3& forward)
 {
 	// Figure out difference between original (unit x) and new
@@ -142,6 +224,12 @@ void Actor::AddComponent(Component* component)
 
 	// Inserts element before position of iterator
 	mComponents.insert(iter, component);
+
+	// Components added to a static actor don't update either
+	if (mStatic)
+	{
+		ComponentPool::SetStatic(component, true);
+	}
 }
 
 void Actor::RemoveComponent(Component* component)
@@ -196,4 +284,9 @@ void Actor::SaveProperties(rapidjson::Document::AllocatorType& alloc, rapidjson:
 	JsonHelper::AddVector3(alloc, inObj, "position", mPosition);
 	JsonHelper::AddQuaternion(alloc, inObj, "rotation", mRotation);
 	JsonHelper::AddFloat(alloc, inObj, "scale", mScale);
+	// (LevelLoader applies this once the components are loaded)
+	if (mStatic)
+	{
+		JsonHelper::AddBool(alloc, inObj, "static", mStatic);
+	}
 }
@@ -11,6 +11,8 @@
 #include "Math.h"
 #include <rapidjson/document.h>
 #include "Component.h"
+#include "SlotMap.h"
+#include "Memory.h"
 
 class Actor
 {
@@ -40,6 +42,8 @@ public:
 
 	// Update function called from Game (not overridable)
 	void Update(float deltaTime);
+	// First part of Update, before components update
+	void BeginUpdate();
 	// Updates all the components attached to the actor (not overridable)
 	void UpdateComponents(float deltaTime);
 	// Any actor-specific update code (overridable)
@@ -59,6 +63,18 @@ public:
 	
 	void ComputeWorldTransform();
 	const Matrix4& GetWorldTransform() const { return mWorldTransform; }
+	// Whether position/rotation/scale changed since the world transform
+	bool GetRecomputeTransform() const { return mRecomputeTransform; }
+	// Use a world transform computed elsewhere (such as in a batch)
+	// and let the components know, as ComputeWorldTransform does
+	void SetWorldTransform(const Matrix4& world);
+
+	// Remember the current transform as the previous tick's
+	void StorePreviousTransform();
+	// Blend between previous and current tick transform for drawing
+	// (alpha of 0 is the previous tick, 1 is the current tick)
+	void InterpolateTransform(float alpha);
+	const Matrix4& GetRenderTransform() const { return mRenderTransform; }
 
 	Vector3 GetForward() const { return Vector3::Transform(Vector3::UnitX, mRotation); }
 	Vector3 GetRight() const { return Vector3::Transform(Vector3::UnitY, mRotation); }
@@ -68,7 +84,17 @@ public:
 	State GetState() const { return mState; }
 	void SetState(State state) { mState = state; }
 
+	// A static actor never moves or updates. Game keeps it out of the
+	// per-tick actor list, its components are skipped by their pools,
+	// and its transform and world boxes are frozen as they are now.
+	// Call outside the actor update (such as after loading).
+	bool IsStatic() const { return mStatic; }
+	void SetStatic(bool isStatic);
+
 	class Game* GetGame() { return mGame; }
+	// Where the actor is in Game's actor slot map (set by Game)
+	const SlotHandle& GetHandle() const { return mHandle; }
+	void SetHandle(const SlotHandle& handle) { mHandle = handle; }
 
 
 	// Add/remove components
@@ -107,6 +133,7 @@ public:
 	}
 
 	virtual TypeID GetType() const { return TActor; }
+	ACTOR_POOL(Actor)
 
 	const std::vector<Component*>& GetComponents() const { return mComponents; }
 private:
@@ -119,7 +146,18 @@ private:
 	Quaternion mRotation;
 	float mScale;
 	bool mRecomputeTransform;
+	bool mStatic;
+
+	// Transform as of the previous tick, and the blended one to draw
+	Matrix4 mRenderTransform;
+	Vector3 mPrevPosition;
+	Quaternion mPrevRotation;
+	float mPrevScale;
+	// False until there's a previous transform (an actor added between
+	// ticks has none, so it isn't blended in from the origin)
+	bool mHasPrevTransform;
 
 	std::vector<Component*> mComponents;
 	class Game* mGame;
+	SlotHandle mHandle;
 };
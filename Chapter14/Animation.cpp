@@ -11,6 +11,8 @@
 #include <rapidjson/document.h>
 #include <SDL/SDL_log.h>
 #include "LevelLoader.h"
+#include "Profiler.h"
+#include <algorithm>
 
 bool Animation::Load(const std::string& fileName)
 {
@@ -115,8 +117,23 @@ bool Animation::Load(const std::string& fileName)
 	return true;
 }
 
+void Animation::SetTracks(const std::vector<std::vector<BoneTransform>>& tracks, float duration)
+{
+	mTracks = tracks;
+	mNumBones = tracks.size();
+	mNumFrames = 0;
+	for (const auto& track : tracks)
+	{
+		mNumFrames = std::max(mNumFrames, track.size());
+	}
+	mDuration = duration;
+	// A single frame (or none) is held for the whole duration
+	mFrameDuration = mNumFrames > 1 ? mDuration / (mNumFrames - 1) : mDuration;
+}
+
 void Animation::GetGlobalPoseAtTime(std::vector<Matrix4>& outPoses, const Skeleton* inSkeleton, float inTime) const
 {
+	PROFILE_SCOPE("Animation::GetGlobalPoseAtTime");
 	if (outPoses.size() != mNumBones)
 	{
 		outPoses.resize(mNumBones);
@@ -128,6 +145,13 @@ void Animation::GetGlobalPoseAtTime(std::vector<Matrix4>& outPoses, const Skelet
 	size_t nextFrame = frame + 1;
 	// Calculate fractional value between frame and next frame
 	float pct = inTime / mFrameDuration - frame;
+	// The last frame (or a single one) has no next frame, so hold it
+	if (nextFrame >= mNumFrames)
+	{
+		frame = mNumFrames > 0 ? mNumFrames - 1 : 0;
+		nextFrame = frame;
+		pct = 0.0f;
+	}
 
 	// Setup the pose for the root
 	if (mTracks[0].size() > 0)
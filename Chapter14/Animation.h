@@ -15,6 +15,9 @@ class Animation
 {
 public:
 	bool Load(const std::string& fileName);
+	// Or set up the tracks directly (one per bone, each track
+	// either empty or with the same number of frames)
+	void SetTracks(const std::vector<std::vector<BoneTransform>>& tracks, float duration);
 
 	size_t GetNumBones() const { return mNumBones; }
 	size_t GetNumFrames() const { return mNumFrames; }
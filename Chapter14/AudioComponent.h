@@ -25,6 +25,7 @@ public:
 	void StopAllEvents();
 
 	TypeID GetType() const override { return TAudioComponent; }
+	COMPONENT_POOL(AudioComponent)
 private:
 	std::vector<SoundEvent> mEvents2D;
 	std::vector<SoundEvent> mEvents3D;
@@ -7,6 +7,7 @@
 // ----------------------------------------------------------------
 
 #include "AudioSystem.h"
+#include "Profiler.h"
 #include <SDL/SDL_log.h>
 #include <fmod_studio.hpp>
 #include <fmod_errors.h>
@@ -78,8 +79,8 @@ void AudioSystem::Shutdown()
 
 void AudioSystem::LoadBank(const std::string& name)
 {
-	// Prevent double-loading
-	if (mBanks.find(name) != mBanks.end())
+	// Prevent double-loading (or loading without FMOD)
+	if (!mSystem || mBanks.find(name) != mBanks.end())
 	{
 		return;
 	}
@@ -238,6 +239,7 @@ SoundEvent AudioSystem::PlayEvent(const std::string& name)
 
 void AudioSystem::Update(float deltaTime)
 {
+	PROFILE_SCOPE("AudioSystem::Update");
 	// Find any stopped event instances
 	std::vector<unsigned int> done;
 	for (auto& iter : mEventInstances)
@@ -261,7 +263,10 @@ void AudioSystem::Update(float deltaTime)
 	}
 
 	// Update FMOD
-	mSystem->update();
+	if (mSystem)
+	{
+		mSystem->update();
+	}
 }
 
 namespace
@@ -280,9 +285,14 @@ namespace
 
 void AudioSystem::SetListener(const Matrix4& viewMatrix)
 {
+	// Without an FMOD system (headless), there's no listener
+	if (!mSystem)
+	{
+		return;
+	}
 	// Invert the view matrix to get the correct vectors
 	Matrix4 invView = viewMatrix;
-	invView.Invert();
+	invView.InvertRigid();
 	FMOD_3D_ATTRIBUTES listener;
 	// Set position, forward, up
 	listener.position = VecToFMOD(invView.GetTranslation());
@@ -32,6 +32,8 @@ public:
 	AudioSystem(class Game* game);
 	~AudioSystem();
 
+	// If Initialize isn't called (headless), the audio
+	// system stays silent and every call is a no-op
 	bool Initialize();
 	void Shutdown();
 
@@ -23,6 +23,7 @@ public:
 		rapidjson::Value& inObj) const override;
 
 	TypeID GetType() const override { return TBallActor; }
+	ACTOR_POOL(BallActor)
 private:
 	class AudioComponent* mAudioComp;
 	float mLifeSpan;
@@ -10,38 +10,52 @@
 #include "Actor.h"
 #include "Game.h"
 #include "PhysWorld.h"
-#include "TargetActor.h"
-#include "BallActor.h"
+#include "EventBus.h"
 
 BallMove::BallMove(Actor* owner)
 	:MoveComponent(owner)
+	,mRadius(0.0f)
 {
 }
 
 void BallMove::Update(float deltaTime)
 {
-	const float segmentLength = 30.0f;
+	// Bounces a tick can have before the ball stops short
+	const int cMaxBounces = 4;
 	PhysWorld* phys = mOwner->GetGame()->GetPhysWorld();
 
-	// Construct segment in direction of travel
-	Vector3 start = mOwner->GetPosition();
+	// Sweep the ball over this tick's whole move, so a fast ball can't
+	// skip through a thin target. After a bounce, the rest of the move
+	// goes in the new direction.
+	Vector3 pos = mOwner->GetPosition();
 	Vector3 dir = mOwner->GetForward();
-	Vector3 end = start + dir * segmentLength;
-	// Create line segment
-	LineSegment l(start, end);
-	// Test segment vs world
-	PhysWorld::CollisionInfo info;
-	if (phys->SegmentCast(l, info))
+	float remaining = mForwardSpeed * deltaTime;
+	bool bounced = false;
+	for (int i = 0; i < cMaxBounces && remaining > 0.0f; i++)
 	{
-		// If we collided, reflect the ball about the normal
-		dir = Vector3::Reflect(dir, info.mNormal);
-		mOwner->RotateToNewForward(dir);
-		// Did we hit a target?
-		TargetActor* target = dynamic_cast<TargetActor*>(info.mActor);
-		if (target)
+		PhysWorld::CollisionInfo info;
+		float t;
+		if (!phys->SweepSphere(Sphere(pos, mRadius), dir * remaining, info, t, mOwner))
 		{
-			static_cast<BallActor*>(mOwner)->HitTarget();
+			pos += dir * remaining;
+			break;
 		}
+
+		// Move up to the contact, and reflect the ball about the normal
+		pos += dir * (remaining * t);
+		remaining *= 1.0f - t;
+		dir = Vector3::Reflect(dir, info.mNormal);
+		bounced = true;
+		// Let gameplay decide what the hit means (this may be
+		// on a job thread, so it's handled at the next dispatch, in
+		// order of the balls' handles)
+		mOwner->GetGame()->GetEventBus()->PublishOrdered(
+			CollisionEvent{ mOwner, info.mActor, info.mPoint, info.mNormal },
+			mOwner->GetHandle().mIndex);
+	}
+	mOwner->SetPosition(pos);
+	if (bounced)
+	{
+		mOwner->RotateToNewForward(dir);
 	}
-	MoveComponent::Update(deltaTime);
 }
@@ -14,8 +14,16 @@ class BallMove : public MoveComponent
 public:
 	BallMove(class Actor* owner);
 
+	// Like MoveComponent, this updates on job threads. Its sweeps read
+	// the AABB tree while other jobs move their balls, which is only
+	// safe because PhysWorld::UpdateBox defers box writes to EndTick.
 	void Update(float deltaTime) override;
 
+	// Radius of the ball for its sweeps
+	void SetRadius(float radius) { mRadius = radius; }
+
 	TypeID GetType() const override { return TBallMove; }
+	COMPONENT_POOL(BallMove)
 protected:
+	float mRadius;
 };
\ No newline at end of file
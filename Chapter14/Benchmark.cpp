@@ -0,0 +1,1533 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "Benchmark.h"
+#include "Math.h"
+#include "TransformBatch.h"
+#include "VectorStream.h"
+#include "Collision.h"
+#include "BoneTransform.h"
+#include "Animation.h"
+#include "Skeleton.h"
+#include "PhysWorld.h"
+#include "RenderQueue.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	// Every benchmark does roughly this much work per measurement,
+	// so small sizes are repeated more times
+	const size_t cWorkPerRun = 4000000;
+
+	double GetSeconds()
+	{
+		using namespace std::chrono;
+		return duration_cast<duration<double>>(
+			steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Small deterministic generator, so runs are comparable
+	class BenchRandom
+	{
+	public:
+		BenchRandom(uint32_t seed) : mState(seed) {}
+		float GetFloat(float min, float max)
+		{
+			mState = mState * 1664525u + 1013904223u;
+			float t = (mState >> 8) / 16777216.0f;
+			return min + (max - min) * t;
+		}
+	private:
+		uint32_t mState;
+	};
+
+	// Runs the cases of RunSuite and writes a CSV row for each
+	class SuiteRunner
+	{
+	public:
+		SuiteRunner(FILE* out, const char* filter)
+			:mOut(out)
+			,mFilter(filter)
+		{
+			fprintf(mOut, "group,case,size,ops,reps,ns_min,ns_median,checksum\n");
+		}
+
+		// func does ops operations on a data set of the given size, and
+		// returns a checksum (the first call's is written, so it should
+		// match between builds). It's repeated until a sample takes
+		// about cSampleSeconds, and the times are per operation.
+		template <typename Func>
+		void Run(const char* group, const char* name, size_t size, size_t ops, Func func)
+		{
+			if (mFilter && !strstr(group, mFilter) && !strstr(name, mFilter))
+			{
+				return;
+			}
+
+			// Warm up, and pick how many reps make up a sample
+			double start = GetSeconds();
+			float check = func();
+			mSink += check;
+			double once = GetSeconds() - start;
+			size_t reps = static_cast<size_t>(cSampleSeconds / Math::Max(once, 1e-9));
+			reps = Math::Clamp<size_t>(reps, 1, 1000000);
+
+			double samples[cSamples];
+			for (int s = 0; s < cSamples; s++)
+			{
+				start = GetSeconds();
+				for (size_t r = 0; r < reps; r++)
+				{
+					mSink += func();
+				}
+				samples[s] = (GetSeconds() - start) * 1e9 / (reps * ops);
+			}
+			std::sort(samples, samples + cSamples);
+			fprintf(mOut, "%s,%s,%zu,%zu,%zu,%.3f,%.3f,%g\n", group, name, size,
+				ops, reps, samples[0], samples[cSamples / 2], check);
+			fflush(mOut);
+		}
+	private:
+		static const int cSamples = 5;
+		static constexpr double cSampleSeconds = 0.02;
+		FILE* mOut;
+		const char* mFilter;
+		// Results of the timed calls go here, so they can't be skipped
+		volatile float mSink = 0.0f;
+	};
+
+	Vector3 RandomVector(BenchRandom& rand, float range)
+	{
+		return Vector3(rand.GetFloat(-range, range), rand.GetFloat(-range, range),
+			rand.GetFloat(-range, range));
+	}
+
+	Quaternion RandomRotation(BenchRandom& rand)
+	{
+		Vector3 axis = RandomVector(rand, 1.0f);
+		axis.Normalize();
+		return Quaternion(axis, rand.GetFloat(-Math::Pi, Math::Pi));
+	}
+
+	// Boxes spread so each overlaps a few others whatever the count
+	AABB RandomBox(BenchRandom& rand, size_t count)
+	{
+		float range = 100.0f * std::cbrt(static_cast<float>(count));
+		Vector3 center = RandomVector(rand, range);
+		Vector3 half(rand.GetFloat(10.0f, 50.0f), rand.GetFloat(10.0f, 50.0f),
+			rand.GetFloat(10.0f, 50.0f));
+		return AABB(center - half, center + half);
+	}
+
+	// Bursts of shots, each from one spot in a narrow cone (like bots
+	// firing spread weapons), which is what packets are good at
+	std::vector<LineSegment> CoherentSegments(BenchRandom& rand, size_t count, float range)
+	{
+		const size_t cBurst = 16;
+		std::vector<LineSegment> segments;
+		Vector3 start, dir;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (i % cBurst == 0)
+			{
+				start = RandomVector(rand, range);
+				dir = RandomVector(rand, 1.0f);
+				dir.Normalize();
+			}
+			Vector3 spread = dir + RandomVector(rand, 0.05f);
+			spread.Normalize();
+			segments.emplace_back(start, start + spread * 2000.0f);
+		}
+		return segments;
+	}
+
+	// Box layouts for RunScaling. The moving boxes come first.
+	struct StressScene
+	{
+		std::vector<AABB> mBoxes;
+		std::vector<Vector3> mVelocities;
+		size_t mNumMoving;
+		// Everything is inside +/- mRange
+		float mRange;
+	};
+
+	enum SceneType
+	{
+		EUniform,
+		EClustered,
+		ECorridors,
+		EMostlyStatic,
+		ENumSceneTypes
+	};
+	const char* const cSceneNames[] = { "uniform", "clustered", "corridors", "mostly_static" };
+
+	StressScene MakeStressScene(SceneType type, size_t count)
+	{
+		BenchRandom rand(9137 + static_cast<uint32_t>(type));
+		StressScene scene;
+		scene.mRange = 100.0f * std::cbrt(static_cast<float>(count));
+		auto addMoving = [&](const AABB& box, const Vector3& velocity) {
+			scene.mBoxes.emplace_back(box);
+			scene.mVelocities.emplace_back(velocity);
+		};
+
+		switch (type)
+		{
+		case EUniform:
+		case EMostlyStatic:
+		{
+			// Every box moves, or one in twenty
+			scene.mNumMoving = type == EUniform ? count : count / 20;
+			for (size_t i = 0; i < count; i++)
+			{
+				addMoving(RandomBox(rand, count), RandomVector(rand, 2.0f));
+			}
+			break;
+		}
+		case EClustered:
+		{
+			// Groups of 1000, about eight times as dense as uniform
+			// (thicker in the middle of each group)
+			scene.mNumMoving = count;
+			Vector3 center;
+			for (size_t i = 0; i < count; i++)
+			{
+				if (i % 1000 == 0)
+				{
+					center = RandomVector(rand, scene.mRange);
+				}
+				Vector3 pos = center + RandomVector(rand, 250.0f) + RandomVector(rand, 250.0f);
+				Vector3 half(rand.GetFloat(10.0f, 50.0f), rand.GetFloat(10.0f, 50.0f),
+					rand.GetFloat(10.0f, 50.0f));
+				addMoving(AABB(pos - half, pos + half), RandomVector(rand, 2.0f));
+			}
+			break;
+		}
+		case ECorridors:
+		{
+			// Like Level3: blocks of 1000 x 1000 with a floor tile, four
+			// corridors 250 wide running along x, and a wall across the
+			// end. A quarter of the boxes are crates moving along the
+			// corridors, and the rest are static.
+			const float cBlock = 1000.0f;
+			const float cLane = 250.0f;
+			size_t numStatic = count - count / 4;
+			int blocks = Math::Max(1, static_cast<int>(std::sqrt(numStatic / 6.0f)));
+			scene.mRange = blocks * cBlock * 0.5f;
+			scene.mNumMoving = count - static_cast<size_t>(blocks * blocks * 6);
+			for (size_t i = 0; i < scene.mNumMoving; i++)
+			{
+				int lane = static_cast<int>(rand.GetFloat(0.0f, blocks * 4.0f - 0.01f));
+				Vector3 pos(rand.GetFloat(-scene.mRange, scene.mRange),
+					-scene.mRange + (lane + 0.5f) * cLane, rand.GetFloat(30.0f, 170.0f));
+				Vector3 half(rand.GetFloat(10.0f, 25.0f), rand.GetFloat(10.0f, 25.0f),
+					rand.GetFloat(10.0f, 25.0f));
+				Vector3 velocity(rand.GetFloat(-3.0f, 3.0f), rand.GetFloat(-0.5f, 0.5f), 0.0f);
+				addMoving(AABB(pos - half, pos + half), velocity);
+			}
+			for (int bx = 0; bx < blocks; bx++)
+			{
+				for (int by = 0; by < blocks; by++)
+				{
+					Vector3 corner(-scene.mRange + bx * cBlock, -scene.mRange + by * cBlock, 0.0f);
+					addMoving(AABB(corner, corner + Vector3(cBlock, cBlock, 0.0f)), Vector3::Zero);
+					for (int lane = 0; lane < 4; lane++)
+					{
+						Vector3 wall = corner + Vector3(0.0f, lane * cLane, 0.0f);
+						addMoving(AABB(wall - Vector3(0.0f, 5.0f, 0.0f),
+							wall + Vector3(cBlock, 5.0f, 200.0f)), Vector3::Zero);
+					}
+					Vector3 end = corner + Vector3(cBlock, 0.0f, 0.0f);
+					addMoving(AABB(end - Vector3(5.0f, 0.0f, 0.0f),
+						end + Vector3(5.0f, cBlock, 200.0f)), Vector3::Zero);
+				}
+			}
+			break;
+		}
+		default:
+			break;
+		}
+		return scene;
+	}
+
+	// Read the results so the compiler can't skip the work
+	float Checksum(const std::vector<Matrix4>& mats)
+	{
+		float sum = 0.0f;
+		for (const Matrix4& m : mats)
+		{
+			sum += m.mat[0][0] + m.mat[1][1] + m.mat[2][2] + m.mat[3][0];
+		}
+		return sum;
+	}
+}
+
+void Benchmark::RunAll()
+{
+	RunTransforms();
+	RunMath();
+	RunInverse();
+	RunVectorStreams();
+	RunSegmentCasts();
+}
+
+void Benchmark::RunTransforms()
+{
+	printf("World transforms (scale * rotation * translation)\n");
+	printf("%10s %14s %14s %14s\n", "count", "multiply ns", "scalar ns", "batch ns");
+
+	const size_t counts[] = { 10000, 100000, 1000000 };
+	for (size_t count : counts)
+	{
+		BenchRandom rand(1234);
+		std::vector<TransformBatch::Input> inputs(count);
+		for (auto& in : inputs)
+		{
+			in.mPosition = Vector3(rand.GetFloat(-1000.0f, 1000.0f),
+				rand.GetFloat(-1000.0f, 1000.0f), rand.GetFloat(-1000.0f, 1000.0f));
+			in.mScale = rand.GetFloat(0.5f, 2.0f);
+			Vector3 axis(rand.GetFloat(-1.0f, 1.0f), rand.GetFloat(-1.0f, 1.0f),
+				rand.GetFloat(-1.0f, 1.0f));
+			axis.Normalize();
+			in.mRotation = Quaternion(axis, rand.GetFloat(-Math::Pi, Math::Pi));
+		}
+		std::vector<Matrix4> outputs(count);
+		size_t reps = cWorkPerRun / count;
+		if (reps == 0)
+		{
+			reps = 1;
+		}
+		float check = 0.0f;
+
+		// The old way, as Actor::ComputeWorldTransform used to
+		double start = GetSeconds();
+		for (size_t r = 0; r < reps; r++)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				Matrix4 m = Matrix4::CreateScale(inputs[i].mScale);
+				m *= Matrix4::CreateFromQuaternion(inputs[i].mRotation);
+				m *= Matrix4::CreateTranslation(inputs[i].mPosition);
+				outputs[i] = m;
+			}
+		}
+		double multiplyNS = (GetSeconds() - start) * 1e9 / (reps * count);
+		check += Checksum(outputs);
+
+		start = GetSeconds();
+		for (size_t r = 0; r < reps; r++)
+		{
+			TransformBatch::ComposeBatchScalar(inputs.data(), outputs.data(), count);
+		}
+		double scalarNS = (GetSeconds() - start) * 1e9 / (reps * count);
+		check += Checksum(outputs);
+
+		start = GetSeconds();
+		for (size_t r = 0; r < reps; r++)
+		{
+			TransformBatch::ComposeBatch(inputs.data(), outputs.data(), count);
+		}
+		double batchNS = (GetSeconds() - start) * 1e9 / (reps * count);
+		check += Checksum(outputs);
+
+		printf("%10zu %14.2f %14.2f %14.2f   (checksum %g)\n", count,
+			multiplyNS, scalarNS, batchNS, check);
+	}
+}
+
+void Benchmark::RunMath()
+{
+#ifdef MATH_SIMD
+	printf("\nMath.h (SSE)\n");
+#else
+	printf("\nMath.h (SIMD disabled, both columns are scalar)\n");
+#endif
+	printf("%24s %14s %14s\n", "operation", "scalar ns", "simd ns");
+
+	const size_t count = 4096;
+	const size_t reps = cWorkPerRun / count;
+	BenchRandom rand(5678);
+	std::vector<Matrix4> mats(count);
+	std::vector<Quaternion> quats(count);
+	std::vector<Vector3> vecs(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				mats[i].mat[r][c] = rand.GetFloat(-1.0f, 1.0f);
+			}
+		}
+		Vector3 axis(rand.GetFloat(-1.0f, 1.0f), rand.GetFloat(-1.0f, 1.0f),
+			rand.GetFloat(-1.0f, 1.0f));
+		axis.Normalize();
+		quats[i] = Quaternion(axis, rand.GetFloat(-Math::Pi, Math::Pi));
+		vecs[i] = Vector3(rand.GetFloat(-100.0f, 100.0f),
+			rand.GetFloat(-100.0f, 100.0f), rand.GetFloat(-100.0f, 100.0f));
+	}
+	std::vector<Matrix4> matOut(count);
+	std::vector<Quaternion> quatOut(count);
+	std::vector<Vector3> vecOut(count);
+	float check = 0.0f;
+
+	// Times func(i) over every element, reps times, in ns per call
+	auto time = [reps, count](auto func) {
+		double start = GetSeconds();
+		for (size_t r = 0; r < reps; r++)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				func(i);
+			}
+		}
+		return (GetSeconds() - start) * 1e9 / (reps * count);
+	};
+	auto quatSum = [&quatOut]() {
+		float sum = 0.0f;
+		for (const Quaternion& q : quatOut)
+		{
+			sum += q.x + q.w;
+		}
+		return sum;
+	};
+	auto vecSum = [&vecOut]() {
+		float sum = 0.0f;
+		for (const Vector3& v : vecOut)
+		{
+			sum += v.x + v.z;
+		}
+		return sum;
+	};
+
+	double scalarNS = time([&](size_t i) {
+		matOut[i] = Matrix4::MultiplyScalar(mats[i], mats[count - 1 - i]); });
+	check += Checksum(matOut);
+	double simdNS = time([&](size_t i) {
+		matOut[i] = mats[i] * mats[count - 1 - i]; });
+	check += Checksum(matOut);
+	printf("%24s %14.2f %14.2f\n", "Matrix4 multiply", scalarNS, simdNS);
+
+	scalarNS = time([&](size_t i) {
+		vecOut[i] = Vector3::TransformScalar(vecs[i], mats[i]); });
+	check += vecSum();
+	simdNS = time([&](size_t i) {
+		vecOut[i] = Vector3::Transform(vecs[i], mats[i]); });
+	check += vecSum();
+	printf("%24s %14.2f %14.2f\n", "Vector3::Transform", scalarNS, simdNS);
+
+	scalarNS = time([&](size_t i) {
+		quatOut[i] = Quaternion::SlerpScalar(quats[i], quats[count - 1 - i], 0.3f); });
+	check += quatSum();
+	simdNS = time([&](size_t i) {
+		quatOut[i] = Quaternion::Slerp(quats[i], quats[count - 1 - i], 0.3f); });
+	check += quatSum();
+	printf("%24s %14.2f %14.2f\n", "Quaternion::Slerp", scalarNS, simdNS);
+
+	scalarNS = time([&](size_t i) {
+		quatOut[i] = Quaternion::ConcatenateScalar(quats[i], quats[count - 1 - i]); });
+	check += quatSum();
+	simdNS = time([&](size_t i) {
+		quatOut[i] = Quaternion::Concatenate(quats[i], quats[count - 1 - i]); });
+	check += quatSum();
+	printf("%24s %14.2f %14.2f\n", "Quaternion::Concatenate", scalarNS, simdNS);
+
+	printf("(checksum %g)\n", check);
+}
+
+void Benchmark::RunInverse()
+{
+	printf("\nMatrix4 inverse\n");
+	printf("%22s %14s %14s\n", "variant", "max error", "ns");
+
+	const size_t count = 4096;
+	const size_t reps = cWorkPerRun / count / 4;
+	BenchRandom rand(91011);
+	// The kinds of matrices the game inverts
+	std::vector<Matrix4> rigid(count);
+	std::vector<Matrix4> scaled(count);
+	std::vector<Matrix4> viewProj(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		Vector3 axis(rand.GetFloat(-1.0f, 1.0f), rand.GetFloat(-1.0f, 1.0f),
+			rand.GetFloat(-1.0f, 1.0f));
+		axis.Normalize();
+		Quaternion rot(axis, rand.GetFloat(-Math::Pi, Math::Pi));
+		Vector3 pos(rand.GetFloat(-1000.0f, 1000.0f),
+			rand.GetFloat(-1000.0f, 1000.0f), rand.GetFloat(-1000.0f, 1000.0f));
+		rigid[i] = Matrix4::CreateFromQuaternion(rot) * Matrix4::CreateTranslation(pos);
+		scaled[i] = Matrix4::CreateScale(rand.GetFloat(0.1f, 10.0f)) * rigid[i];
+		viewProj[i] = Matrix4::CreateLookAt(pos, Vector3::Zero, Vector3::UnitZ) *
+			Matrix4::CreatePerspectiveFOV(Math::ToRadians(70.0f), 1024.0f, 768.0f,
+			10.0f, 10000.0f);
+	}
+	std::vector<Matrix4> out(count);
+
+	// Largest difference from InvertScalar, relative to the
+	// largest element of that matrix
+	auto maxError = [count, &out](const std::vector<Matrix4>& mats) {
+		float maxErr = 0.0f;
+		for (size_t i = 0; i < count; i++)
+		{
+			Matrix4 expected = mats[i];
+			expected.InvertScalar();
+			float largest = 0.0f;
+			float err = 0.0f;
+			for (int r = 0; r < 4; r++)
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					largest = Math::Max(largest, Math::Abs(expected.mat[r][c]));
+					err = Math::Max(err, Math::Abs(out[i].mat[r][c] - expected.mat[r][c]));
+				}
+			}
+			maxErr = Math::Max(maxErr, err / largest);
+		}
+		return maxErr;
+	};
+	float check = 0.0f;
+	auto run = [&](const char* name, const std::vector<Matrix4>& mats,
+		void (Matrix4::*invert)()) {
+		double start = GetSeconds();
+		for (size_t r = 0; r < reps; r++)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				out[i] = mats[i];
+				(out[i].*invert)();
+			}
+		}
+		double ns = (GetSeconds() - start) * 1e9 / (reps * count);
+		check += Checksum(out);
+		printf("%22s %14g %14.2f\n", name, maxError(mats), ns);
+	};
+
+	run("InvertScalar", viewProj, &Matrix4::InvertScalar);
+	run("Invert (view proj)", viewProj, &Matrix4::Invert);
+	run("Invert (rigid)", rigid, &Matrix4::Invert);
+	run("InvertRigid", rigid, &Matrix4::InvertRigid);
+	run("InvertUniformScale", scaled, &Matrix4::InvertUniformScale);
+	printf("(checksum %g)\n", check);
+}
+
+void Benchmark::RunVectorStreams()
+{
+	printf("\nVectorStream (millions of points/sec)\n");
+	printf("%10s %16s %14s %14s\n", "count", "kernel", "Vector3[]", "stream");
+
+	const size_t counts[] = { 1000, 100000 };
+	for (size_t count : counts)
+	{
+		BenchRandom rand(1213);
+		std::vector<Vector3> points(count);
+		VectorStream stream(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			points[i] = Vector3(rand.GetFloat(-1000.0f, 1000.0f),
+				rand.GetFloat(-1000.0f, 1000.0f), rand.GetFloat(-1000.0f, 1000.0f));
+			stream.Set(i, points[i]);
+		}
+		Vector3 axis(1.0f, 2.0f, 3.0f);
+		axis.Normalize();
+		Quaternion q(axis, 0.7f);
+		Matrix4 mat = Matrix4::CreateFromQuaternion(q) *
+			Matrix4::CreateTranslation(Vector3(10.0f, 20.0f, 30.0f));
+		std::vector<Vector3> outPoints(count);
+		VectorStream outStream(count);
+		std::vector<float> values(count);
+		size_t reps = cWorkPerRun / count;
+		float check = 0.0f;
+
+		// Times func reps times, in millions of points per second
+		auto rate = [reps, count](auto func) {
+			double start = GetSeconds();
+			for (size_t r = 0; r < reps; r++)
+			{
+				func();
+			}
+			return reps * count / (GetSeconds() - start) / 1e6;
+		};
+		auto print = [count](const char* name, double aos, double soa) {
+			printf("%10zu %16s %14.1f %14.1f\n", count, name, aos, soa);
+		};
+
+		double aos = rate([&]() {
+			for (size_t i = 0; i < count; i++)
+			{
+				outPoints[i] = Vector3::Transform(points[i], mat);
+			}
+		});
+		check += outPoints[count / 2].x;
+		double soa = rate([&]() { VectorStream::Transform(stream, mat, outStream); });
+		check += outStream.GetX()[count / 2];
+		print("Matrix4", aos, soa);
+
+		aos = rate([&]() {
+			for (size_t i = 0; i < count; i++)
+			{
+				outPoints[i] = Vector3::Transform(points[i], q);
+			}
+		});
+		check += outPoints[count / 2].x;
+		soa = rate([&]() { VectorStream::Transform(stream, q, outStream); });
+		check += outStream.GetX()[count / 2];
+		print("Quaternion", aos, soa);
+
+		aos = rate([&]() {
+			for (size_t i = 0; i < count; i++)
+			{
+				values[i] = Vector3::Dot(points[i], axis);
+			}
+		});
+		check += values[count / 2];
+		soa = rate([&]() { VectorStream::Dot(stream, axis, values.data()); });
+		check += values[count / 2];
+		print("Dot", aos, soa);
+
+		aos = rate([&]() {
+			for (size_t i = 0; i < count; i++)
+			{
+				values[i] = (points[i] - axis).LengthSq();
+			}
+		});
+		check += values[count / 2];
+		soa = rate([&]() { VectorStream::DistanceSq(stream, axis, values.data()); });
+		check += values[count / 2];
+		print("DistanceSq", aos, soa);
+
+		Vector3 minV, maxV;
+		aos = rate([&]() {
+			minV = points[0];
+			maxV = points[0];
+			for (size_t i = 1; i < count; i++)
+			{
+				minV.x = Math::Min(minV.x, points[i].x);
+				minV.y = Math::Min(minV.y, points[i].y);
+				minV.z = Math::Min(minV.z, points[i].z);
+				maxV.x = Math::Max(maxV.x, points[i].x);
+				maxV.y = Math::Max(maxV.y, points[i].y);
+				maxV.z = Math::Max(maxV.z, points[i].z);
+			}
+		});
+		check += minV.x + maxV.z;
+		soa = rate([&]() { VectorStream::MinMax(stream, minV, maxV); });
+		check += minV.x + maxV.z;
+		print("MinMax", aos, soa);
+		printf("(checksum %g)\n", check);
+	}
+}
+
+void Benchmark::RunSegmentCasts()
+{
+	const size_t cNumBoxes = 16384;
+	const size_t cNumSegments = 1024;
+	printf("\nSegment casts, %zu boxes (millions of rays/sec)\n", cNumBoxes);
+	printf("%10s %14s %14s %14s %14s\n", "rays", "one at a time", "packets of 4",
+		"packets of 8", "packets of 16");
+
+	BenchRandom rand(4512);
+	PhysWorld world(nullptr);
+	for (size_t i = 0; i < cNumBoxes; i++)
+	{
+		world.AddBox(RandomBox(rand, cNumBoxes), nullptr, nullptr, true);
+	}
+	float range = 100.0f * std::cbrt(static_cast<float>(cNumBoxes));
+	std::vector<LineSegment> coherent = CoherentSegments(rand, cNumSegments, range);
+	std::vector<LineSegment> random;
+	for (size_t i = 0; i < cNumSegments; i++)
+	{
+		Vector3 start = RandomVector(rand, range);
+		random.emplace_back(start, start + RandomVector(rand, 1000.0f));
+	}
+
+	std::vector<PhysWorld::CollisionInfo> infos(cNumSegments);
+	std::unique_ptr<bool[]> hits(new bool[cNumSegments]);
+	float check = 0.0f;
+	// Runs for about a fifth of a second, in millions of rays per second
+	auto rate = [&check](const std::vector<LineSegment>& segments, auto func) {
+		size_t reps = 0;
+		double start = GetSeconds();
+		double elapsed;
+		do
+		{
+			check += static_cast<float>(func(segments));
+			reps++;
+			elapsed = GetSeconds() - start;
+		} while (elapsed < 0.2);
+		return reps * segments.size() / elapsed / 1e6;
+	};
+	auto one = [&](const std::vector<LineSegment>& segments) {
+		size_t numHits = 0;
+		for (size_t i = 0; i < segments.size(); i++)
+		{
+			numHits += world.SegmentCast(segments[i], infos[i]) ? 1 : 0;
+		}
+		return numHits;
+	};
+	auto packets = [&](size_t packetSize) {
+		return [&, packetSize](const std::vector<LineSegment>& segments) {
+			return world.SegmentCastBatch(segments.data(), segments.size(), infos.data(),
+				hits.get(), packetSize);
+		};
+	};
+
+	auto print = [&](const char* name, const std::vector<LineSegment>& segments) {
+		printf("%10s %14.2f %14.2f %14.2f %14.2f\n", name, rate(segments, one),
+			rate(segments, packets(4)), rate(segments, packets(8)),
+			rate(segments, packets(16)));
+	};
+	print("coherent", coherent);
+	print("random", random);
+	printf("(checksum %g)\n", check);
+}
+
+void Benchmark::RunSuite(FILE* out, const char* filter)
+{
+	SuiteRunner suite(out, filter);
+
+	// Math.h
+	{
+		const size_t count = 1024;
+		BenchRandom rand(1415);
+		std::vector<Matrix4> mats(count);
+		std::vector<Matrix4> rigid(count);
+		std::vector<Quaternion> quats(count);
+		std::vector<Vector3> vecs(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			quats[i] = RandomRotation(rand);
+			vecs[i] = RandomVector(rand, 100.0f);
+			rigid[i] = Matrix4::CreateFromQuaternion(quats[i]) *
+				Matrix4::CreateTranslation(vecs[i]);
+			mats[i] = Matrix4::CreateScale(rand.GetFloat(0.5f, 2.0f)) * rigid[i];
+		}
+		std::vector<Matrix4> outMats(count);
+		std::vector<Quaternion> outQuats(count);
+		std::vector<Vector3> outVecs(count);
+
+		suite.Run("Math", "Matrix4::operator*", count, count, [&]() {
+			for (size_t i = 0; i < count; i++)
+			{
+				outMats[i] = mats[i] * rigid[(i + 1) % count];
+			}
+			return Checksum(outMats);
+		});
+		suite.Run("Math", "Matrix4::Invert", count, count, [&]() {
+			for (size_t i = 0; i < count; i++)
+			{
+				outMats[i] = mats[i];
+				outMats[i].Invert();
+			}
+			return Checksum(outMats);
+		});
+		suite.Run("Math", "Matrix4::InvertRigid", count, count, [&]() {
+			for (size_t i = 0; i < count; i++)
+			{
+				outMats[i] = rigid[i];
+				outMats[i].InvertRigid();
+			}
+			return Checksum(outMats);
+		});
+		suite.Run("Math", "Quaternion::Slerp", count, count, [&]() {
+			for (size_t i = 0; i < count; i++)
+			{
+				outQuats[i] = Quaternion::Slerp(quats[i], quats[(i + 1) % count], 0.3f);
+			}
+			return outQuats[count / 2].w;
+		});
+		suite.Run("Math", "Vector3::Normalize", count, count, [&]() {
+			for (size_t i = 0; i < count; i++)
+			{
+				outVecs[i] = Vector3::Normalize(vecs[i]);
+			}
+			return outVecs[count / 2].x;
+		});
+	}
+
+	// Collision.cpp, with shapes placed so roughly half the tests hit
+	{
+		const size_t count = 1024;
+		BenchRandom rand(9265);
+		std::vector<Sphere> spheres;
+		std::vector<AABB> boxes;
+		std::vector<Capsule> capsules;
+		std::vector<LineSegment> segments;
+		std::vector<Plane> planes;
+		std::vector<Vector3> points;
+		for (size_t i = 0; i < count; i++)
+		{
+			spheres.emplace_back(RandomVector(rand, 100.0f), rand.GetFloat(10.0f, 60.0f));
+			Vector3 center = RandomVector(rand, 100.0f);
+			Vector3 half(rand.GetFloat(10.0f, 60.0f), rand.GetFloat(10.0f, 60.0f),
+				rand.GetFloat(10.0f, 60.0f));
+			boxes.emplace_back(center - half, center + half);
+			capsules.emplace_back(RandomVector(rand, 100.0f), RandomVector(rand, 100.0f),
+				rand.GetFloat(5.0f, 30.0f));
+			segments.emplace_back(RandomVector(rand, 200.0f), RandomVector(rand, 200.0f));
+			Vector3 normal = RandomVector(rand, 1.0f);
+			normal.Normalize();
+			planes.emplace_back(normal, rand.GetFloat(-50.0f, 50.0f));
+			points.emplace_back(RandomVector(rand, 150.0f));
+		}
+
+		// Each case tests element i against element i + 1
+		auto pairs = [&](const char* name, auto test) {
+			suite.Run("Collision", name, count, count, [&]() {
+				float hits = 0.0f;
+				for (size_t i = 0; i < count; i++)
+				{
+					hits += test(i, (i + 1) % count);
+				}
+				return hits;
+			});
+		};
+		pairs("Intersect(Sphere,Sphere)", [&](size_t i, size_t j) {
+			return Intersect(spheres[i], spheres[j]) ? 1.0f : 0.0f;
+		});
+		pairs("Intersect(AABB,AABB)", [&](size_t i, size_t j) {
+			return Intersect(boxes[i], boxes[j]) ? 1.0f : 0.0f;
+		});
+		pairs("Intersect(Capsule,Capsule)", [&](size_t i, size_t j) {
+			return Intersect(capsules[i], capsules[j]) ? 1.0f : 0.0f;
+		});
+		pairs("Intersect(Sphere,AABB)", [&](size_t i, size_t j) {
+			return Intersect(spheres[i], boxes[j]) ? 1.0f : 0.0f;
+		});
+		pairs("Intersect(LineSegment,Sphere)", [&](size_t i, size_t j) {
+			float t;
+			return Intersect(segments[i], spheres[j], t) ? t : 0.0f;
+		});
+		pairs("Intersect(LineSegment,Plane)", [&](size_t i, size_t j) {
+			float t;
+			return Intersect(segments[i], planes[j], t) ? t : 0.0f;
+		});
+		pairs("Intersect(LineSegment,AABB)", [&](size_t i, size_t j) {
+			float t;
+			Vector3 norm;
+			return Intersect(segments[i], boxes[j], t, norm) ? t : 0.0f;
+		});
+		pairs("SweptSphere", [&](size_t i, size_t j) {
+			float t;
+			// Sphere i moves to sphere j's center, past a still sphere
+			Sphere end(spheres[j].mCenter, spheres[i].mRadius);
+			const Sphere& other = spheres[(j + 1) % count];
+			return SweptSphere(spheres[i], end, other, other, t) ? t : 0.0f;
+		});
+		pairs("SweptAABB", [&](size_t i, size_t j) {
+			float t;
+			Vector3 norm;
+			// Box i moves to box j's center
+			Vector3 delta = boxes[j].mMin + boxes[j].mMax - boxes[i].mMin - boxes[i].mMax;
+			const AABB& other = boxes[(j + 1) % count];
+			return SweptAABB(boxes[i], delta * 0.5f, other, t, norm) ? t : 0.0f;
+		});
+		pairs("SweptSphere(AABB)", [&](size_t i, size_t j) {
+			float t;
+			Vector3 norm;
+			Vector3 delta = spheres[j].mCenter - spheres[i].mCenter;
+			return SweptSphere(spheres[i], delta, boxes[j], t, norm) ? t : 0.0f;
+		});
+		pairs("LineSegment::MinDistSq(point)", [&](size_t i, size_t j) {
+			return segments[i].MinDistSq(points[j]);
+		});
+		pairs("LineSegment::MinDistSq(segment)", [&](size_t i, size_t j) {
+			return LineSegment::MinDistSq(segments[i], segments[j]);
+		});
+	}
+
+	// Animation
+	{
+		const size_t count = 1024;
+		BenchRandom rand(3589);
+		std::vector<BoneTransform> transforms(count);
+		for (BoneTransform& bt : transforms)
+		{
+			bt.mRotation = RandomRotation(rand);
+			bt.mTranslation = RandomVector(rand, 10.0f);
+		}
+		std::vector<BoneTransform> outTransforms(count);
+		suite.Run("Animation", "BoneTransform::Interpolate", count, count, [&]() {
+			for (size_t i = 0; i < count; i++)
+			{
+				outTransforms[i] = BoneTransform::Interpolate(transforms[i],
+					transforms[(i + 1) % count], 0.7f);
+			}
+			return outTransforms[count / 2].mRotation.w;
+		});
+
+		// Skeletons where each bone's parent is a random earlier bone
+		const size_t boneCounts[] = { 16, 64, 96 };
+		for (size_t numBones : boneCounts)
+		{
+			const size_t numFrames = 30;
+			std::vector<Skeleton::Bone> bones(numBones);
+			std::vector<std::vector<BoneTransform>> tracks(numBones);
+			for (size_t b = 0; b < numBones; b++)
+			{
+				bones[b].mParent = b == 0 ? -1 :
+					static_cast<int>(rand.GetFloat(0.0f, static_cast<float>(b) - 0.01f));
+				bones[b].mLocalBindPose = transforms[b];
+				tracks[b].resize(numFrames);
+				for (BoneTransform& frame : tracks[b])
+				{
+					frame.mRotation = RandomRotation(rand);
+					frame.mTranslation = RandomVector(rand, 10.0f);
+				}
+			}
+			Skeleton skeleton;
+			skeleton.SetBones(bones);
+			Animation anim;
+			anim.SetTracks(tracks, 1.0f);
+
+			std::vector<Matrix4> poses;
+			float time = 0.0f;
+			suite.Run("Animation", "Animation::GetGlobalPoseAtTime", numBones, 1, [&]() {
+				time += 0.013f;
+				if (time >= anim.GetDuration())
+				{
+					time = 0.0f;
+				}
+				anim.GetGlobalPoseAtTime(poses, &skeleton, time);
+				return poses[numBones - 1].mat[3][0];
+			});
+		}
+	}
+
+	// PhysWorld, with a tenth of the boxes static (times are per call)
+	{
+		const size_t boxCounts[] = { 256, 1024, 4096, 16384 };
+		for (size_t numBoxes : boxCounts)
+		{
+			BenchRandom rand(7932);
+			PhysWorld world(nullptr);
+			std::vector<SlotHandle> moving;
+			std::vector<AABB> movingBoxes;
+			for (size_t i = 0; i < numBoxes; i++)
+			{
+				AABB box = RandomBox(rand, numBoxes);
+				SlotHandle handle = world.AddBox(box, nullptr, nullptr, i % 10 == 0);
+				if (i % 10 != 0)
+				{
+					moving.emplace_back(handle);
+					movingBoxes.emplace_back(box);
+				}
+			}
+
+			float pairs = 0.0f;
+			auto countPair = [&pairs](Actor*, Actor*) { pairs += 1.0f; };
+			if (numBoxes <= 4096)
+			{
+				suite.Run("PhysWorld", "TestPairwise", numBoxes, 1, [&]() {
+					pairs = 0.0f;
+					world.TestPairwise(countPair);
+					return pairs;
+				});
+			}
+			suite.Run("PhysWorld", "TestSweepAndPrune", numBoxes, 1, [&]() {
+				pairs = 0.0f;
+				world.TestSweepAndPrune(countPair);
+				return pairs;
+			});
+			suite.Run("PhysWorld", "TestSweepAndPruneFullSort", numBoxes, 1, [&]() {
+				pairs = 0.0f;
+				world.TestSweepAndPruneFullSort(countPair);
+				return pairs;
+			});
+			suite.Run("PhysWorld", "TestSpatialHash", numBoxes, 1, [&]() {
+				pairs = 0.0f;
+				world.TestSpatialHash(countPair);
+				return pairs;
+			});
+			suite.Run("PhysWorld", "ForEachOverlap", numBoxes, 1, [&]() {
+				pairs = 0.0f;
+				world.ForEachOverlap([&pairs](const PhysWorld::Body&, const PhysWorld::Body&) {
+					pairs += 1.0f;
+				});
+				return pairs;
+			});
+
+			const size_t numSegments = 64;
+			std::vector<LineSegment> segments;
+			float range = 100.0f * std::cbrt(static_cast<float>(numBoxes));
+			for (size_t i = 0; i < numSegments; i++)
+			{
+				Vector3 start = RandomVector(rand, range);
+				segments.emplace_back(start, start + RandomVector(rand, 300.0f));
+			}
+			auto cast = [&](const char* name, auto segmentCast) {
+				suite.Run("PhysWorld", name, numBoxes, numSegments, [&]() {
+					float hits = 0.0f;
+					PhysWorld::CollisionInfo info;
+					for (const LineSegment& l : segments)
+					{
+						if ((world.*segmentCast)(l, info))
+						{
+							hits += info.mPoint.x;
+						}
+					}
+					return hits;
+				});
+			};
+			cast("SegmentCast", &PhysWorld::SegmentCast);
+			cast("SegmentCastLinear", &PhysWorld::SegmentCastLinear);
+
+			// Times are per segment
+			std::vector<LineSegment> coherent = CoherentSegments(rand, numSegments, range);
+			std::vector<PhysWorld::CollisionInfo> infos(numSegments);
+			std::unique_ptr<bool[]> hits(new bool[numSegments]);
+			auto batch = [&](const char* name, const std::vector<LineSegment>& batchSegments,
+				size_t packetSize) {
+				suite.Run("PhysWorld", name, numBoxes, numSegments, [&]() {
+					float total = 0.0f;
+					if (packetSize == 0)
+					{
+						for (size_t i = 0; i < numSegments; i++)
+						{
+							if (world.SegmentCast(batchSegments[i], infos[i]))
+							{
+								total += infos[i].mPoint.x;
+							}
+						}
+						return total;
+					}
+					world.SegmentCastBatch(batchSegments.data(), numSegments, infos.data(),
+						hits.get(), packetSize);
+					for (size_t i = 0; i < numSegments; i++)
+					{
+						if (hits[i])
+						{
+							total += infos[i].mPoint.x;
+						}
+					}
+					return total;
+				});
+			};
+			batch("SegmentCastBatch", segments, 8);
+			batch("Coherent/SegmentCast", coherent, 0);
+			batch("Coherent/SegmentCastBatch4", coherent, 4);
+			batch("Coherent/SegmentCastBatch8", coherent, 8);
+			batch("Coherent/SegmentCastBatch16", coherent, 16);
+
+			// Spheres and boxes about the ball's size, along the segments
+			auto sweep = [&](const char* name, bool sphere) {
+				suite.Run("PhysWorld", name, numBoxes, numSegments, [&]() {
+					float total = 0.0f;
+					PhysWorld::CollisionInfo info;
+					Vector3 half(12.5f, 12.5f, 12.5f);
+					for (const LineSegment& l : segments)
+					{
+						float t;
+						Vector3 delta = l.mEnd - l.mStart;
+						bool hit = sphere ?
+							world.SweepSphere(Sphere(l.mStart, 12.5f), delta, info, t) :
+							world.SweepBox(AABB(l.mStart - half, l.mStart + half), delta, info, t);
+						if (hit)
+						{
+							total += t;
+						}
+					}
+					return total;
+				});
+			};
+			sweep("SweepSphere", true);
+			sweep("SweepBox", false);
+
+			// Region queries about the size of the radar's
+			const size_t numQueries = 64;
+			std::vector<Vector3> points;
+			for (size_t i = 0; i < numQueries; i++)
+			{
+				points.emplace_back(RandomVector(rand, range));
+			}
+			const float cQueryRadius = 300.0f;
+			auto countBody = [&pairs](const PhysWorld::Body&) { pairs += 1.0f; };
+			suite.Run("PhysWorld", "OverlapBox", numBoxes, numQueries, [&]() {
+				pairs = 0.0f;
+				Vector3 extents(cQueryRadius, cQueryRadius, cQueryRadius);
+				for (const Vector3& p : points)
+				{
+					world.OverlapBox(AABB(p - extents, p + extents), countBody);
+				}
+				return pairs;
+			});
+			suite.Run("PhysWorld", "OverlapSphere", numBoxes, numQueries, [&]() {
+				pairs = 0.0f;
+				for (const Vector3& p : points)
+				{
+					world.OverlapSphere(Sphere(p, cQueryRadius), countBody);
+				}
+				return pairs;
+			});
+			std::vector<const PhysWorld::Body*> nearest;
+			suite.Run("PhysWorld", "FindNearest", numBoxes, numQueries, [&]() {
+				float total = 0.0f;
+				for (const Vector3& p : points)
+				{
+					world.FindNearest(p, 8, Math::Infinity, nearest);
+					for (const PhysWorld::Body* body : nearest)
+					{
+						total += body->mBox.mMin.x;
+					}
+				}
+				return total;
+			});
+
+			// Moving boxes drift back and forth, as if for a few frames
+			// (time is per box, recording and then applying them)
+			float frame = 0.0f;
+			suite.Run("PhysWorld", "UpdateBox", numBoxes, moving.size(), [&]() {
+				frame += 1.0f;
+				Vector3 offset(8.0f * Math::Sin(frame * 0.3f), 6.0f * Math::Cos(frame * 0.2f), 0.0f);
+				for (size_t i = 0; i < moving.size(); i++)
+				{
+					world.UpdateBox(moving[i], AABB(movingBoxes[i].mMin + offset,
+						movingBoxes[i].mMax + offset));
+				}
+				world.EndTick();
+				return static_cast<float>(world.GetTree().GetHeight());
+			});
+		}
+	}
+
+	// Every box moving a little each frame, as sweep and prune expects
+	// (times are per frame: moving the boxes, then finding the pairs)
+	{
+		const size_t boxCounts[] = { 10000, 50000 };
+		for (size_t numBoxes : boxCounts)
+		{
+			BenchRandom rand(2384);
+			std::vector<AABB> boxes;
+			std::vector<Vector3> velocities;
+			for (size_t i = 0; i < numBoxes; i++)
+			{
+				boxes.emplace_back(RandomBox(rand, numBoxes));
+				velocities.emplace_back(RandomVector(rand, 2.0f));
+			}
+
+			auto moving = [&](const char* name, int mode) {
+				PhysWorld world(nullptr);
+				world.SetSweepAndPruneAxes(mode != 2);
+				world.SetThreaded(mode == 7);
+				world.SetContactEvents(mode == 6 || mode == 7);
+				std::vector<SlotHandle> handles;
+				for (const AABB& box : boxes)
+				{
+					handles.emplace_back(world.AddBox(box, nullptr, nullptr, false));
+					// Half the boxes are debris, which only hits the other half
+					if (mode == 5 && handles.size() % 2 == 0)
+					{
+						world.SetBoxFilter(handles.back(), 2, 1);
+					}
+				}
+				std::vector<AABB> current = boxes;
+				float frame = 0.0f;
+				float pairs = 0.0f;
+				auto countPair = [&pairs](Actor*, Actor*) { pairs += 1.0f; };
+				suite.Run("PhysWorld", name, numBoxes, 1, [&]() {
+					// Back and forth, so the scene doesn't spread out
+					frame += 1.0f;
+					float dir = Math::Sin(frame * 0.05f) > 0.0f ? 1.0f : -1.0f;
+					for (size_t i = 0; i < current.size(); i++)
+					{
+						current[i].mMin += velocities[i] * dir;
+						current[i].mMax += velocities[i] * dir;
+						world.UpdateBox(handles[i], current[i]);
+					}
+					pairs = 0.0f;
+					if (mode != 6 && mode != 7)
+					{
+						// Apply the boxes (with nothing else to step)
+						world.EndTick();
+					}
+					if (mode == 0)
+					{
+						world.TestSweepAndPruneFullSort(countPair);
+					}
+					else if (mode == 3)
+					{
+						world.TestSpatialHash(countPair);
+					}
+					else if (mode == 6 || mode == 7)
+					{
+						// The tick's step, and its results at the next tick
+						world.EndTick();
+						world.BeginTick();
+						world.ForEachContactEvent([&pairs](PhysWorld::ContactState state,
+							const PhysWorld::Body&, const PhysWorld::Body&) {
+							if (state != PhysWorld::EPersist)
+							{
+								pairs += 1.0f;
+							}
+						});
+					}
+					else if (mode == 4)
+					{
+						// Counts the pairs that began or ended
+						world.UpdateContacts([&pairs](PhysWorld::ContactState state,
+							const PhysWorld::Body&, const PhysWorld::Body&) {
+							if (state != PhysWorld::EPersist)
+							{
+								pairs += 1.0f;
+							}
+						});
+					}
+					else
+					{
+						world.TestSweepAndPrune(countPair);
+					}
+					return pairs;
+				});
+			};
+			moving("Moving/TestSweepAndPruneFullSort", 0);
+			moving("Moving/TestSweepAndPrune", 1);
+			moving("Moving/TestSweepAndPruneXOnly", 2);
+			moving("Moving/TestSpatialHash", 3);
+			moving("Moving/UpdateContacts", 4);
+			moving("Moving/TestSweepAndPruneLayers", 5);
+			moving("Moving/Step", 6);
+			moving("Moving/ThreadedStep", 7);
+		}
+	}
+
+	// RenderQueue.cpp, with draws of a few hundred meshes (two to a
+	// texture) in a random order, a tenth of them skinned. Sort also
+	// submits the draws and counts the binds, which on their own are
+	// CountStateChanges(Unsorted). Checksums are the binds.
+	{
+		const size_t cMeshes = 300;
+		for (size_t count : { 300, 1000, 3000, 10000 })
+		{
+			BenchRandom rand(1234);
+			std::vector<RenderQueue::Item> draws(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				uint32_t mesh = static_cast<uint32_t>(rand.GetFloat(0.0f, 1.0f) * cMeshes);
+				uint32_t shader = mesh % 10 == 0 ? 1 : 0;
+				draws[i].mKey = RenderQueue::MakeKey(shader, mesh / 2 + 1, mesh + 1,
+					rand.GetFloat(0.0f, 1.0f));
+				draws[i].mIndex = static_cast<uint32_t>(i);
+			}
+			RenderQueue queue;
+			suite.Run("RenderQueue", "Sort", count, count, [&]() {
+				queue.Clear();
+				for (const RenderQueue::Item& d : draws)
+				{
+					uint64_t key = d.mKey;
+					queue.Submit(RenderQueue::GetShader(key), RenderQueue::GetTexture(key),
+						RenderQueue::GetVertexArray(key), (key & 0xFFFFFF) / 16777215.0f,
+						d.mIndex);
+				}
+				queue.Sort();
+				return static_cast<float>(queue.CountStateChanges().GetBinds());
+			});
+			// Just sorting the same keys, with a comparison sort
+			std::vector<RenderQueue::Item> sorted;
+			suite.Run("RenderQueue", "std::stable_sort", count, count, [&]() {
+				sorted = draws;
+				std::stable_sort(sorted.begin(), sorted.end(),
+					[](const RenderQueue::Item& a, const RenderQueue::Item& b) {
+					return a.mKey < b.mKey;
+				});
+				return static_cast<float>(sorted[count / 2].mIndex);
+			});
+			// Binds in the order submitted
+			suite.Run("RenderQueue", "CountStateChanges(Unsorted)", count, count, [&]() {
+				queue.Clear();
+				for (const RenderQueue::Item& d : draws)
+				{
+					uint64_t key = d.mKey;
+					queue.Submit(RenderQueue::GetShader(key), RenderQueue::GetTexture(key),
+						RenderQueue::GetVertexArray(key), (key & 0xFFFFFF) / 16777215.0f,
+						d.mIndex);
+				}
+				return static_cast<float>(queue.CountStateChanges().GetBinds());
+			});
+		}
+	}
+}
+
+void Benchmark::RunScaling(FILE* out, const char* filter, size_t maxBoxes)
+{
+	// Beyond these sizes, a broadphase takes minutes on some scenes
+	const size_t cMaxPairwise = 10000;
+	const size_t cMaxSweepX = 100000;
+	const int cNumFrames = 4;
+	const size_t cNumCasts = 64;
+	volatile float sink = 0.0f;
+
+	fprintf(out, "scene,broadphase,boxes,moving,build_ms,update_ms,pairs_ms,pairs,"
+		"cast_us,memory_bytes\n");
+	for (size_t numBoxes = 1000; numBoxes <= maxBoxes; numBoxes *= 10)
+	{
+		for (int type = 0; type < ENumSceneTypes; type++)
+		{
+			const char* sceneName = cSceneNames[type];
+			StressScene scene = MakeStressScene(static_cast<SceneType>(type), numBoxes);
+			const std::vector<AABB>& boxes = scene.mBoxes;
+			BenchRandom rand(4471);
+			std::vector<LineSegment> segments;
+			for (size_t i = 0; i < cNumCasts; i++)
+			{
+				Vector3 start = RandomVector(rand, scene.mRange);
+				segments.emplace_back(start, start + RandomVector(rand, 1000.0f));
+			}
+
+			// Times one call (the best of a few, unless the scene is big)
+			auto timeBest = [numBoxes](auto func) {
+				int runs = numBoxes <= 10000 ? 5 : 1;
+				double best = 1e30;
+				for (int r = 0; r < runs; r++)
+				{
+					double start = GetSeconds();
+					func();
+					best = Math::Min(best, GetSeconds() - start);
+				}
+				return best;
+			};
+
+			// Every broadphase must find the same pairs as the first one
+			// run (Pairwise, unless it was filtered out or the scene is
+			// too big for it)
+			const char* referenceName = nullptr;
+			size_t referencePairs = 0;
+
+			// build(), move(frameBoxes) for a frame, pairs() returning the
+			// count, and cast(l) returning the hit t (or 1). Times are in
+			// ms, except casts (us per cast). Empty fields weren't run.
+			auto run = [&](const char* name, auto build, auto move, auto pairs, auto cast,
+				auto memory, bool runPairs, bool runCast) {
+				if (filter && !strstr(sceneName, filter) && !strstr(name, filter))
+				{
+					return;
+				}
+				double buildTime = timeBest(build);
+				std::vector<AABB> current = boxes;
+				double updateTime = 0.0;
+				for (int frame = 0; frame < cNumFrames; frame++)
+				{
+					for (size_t i = 0; i < scene.mNumMoving; i++)
+					{
+						current[i].mMin += scene.mVelocities[i];
+						current[i].mMax += scene.mVelocities[i];
+					}
+					double start = GetSeconds();
+					move(current);
+					updateTime += GetSeconds() - start;
+				}
+				fprintf(out, "%s,%s,%zu,%zu,%.3f,%.3f,", sceneName, name, numBoxes,
+					scene.mNumMoving, buildTime * 1e3, updateTime * 1e3 / cNumFrames);
+				if (runPairs)
+				{
+					size_t count = 0;
+					double pairsTime = timeBest([&]() { count = pairs(); });
+					fprintf(out, "%.3f,%zu,", pairsTime * 1e3, count);
+					if (!referenceName)
+					{
+						referenceName = name;
+						referencePairs = count;
+					}
+					else if (count != referencePairs)
+					{
+						fprintf(stderr, "%s, %zu boxes: %s found %zu pairs, but %s found %zu\n",
+							sceneName, numBoxes, name, count, referenceName, referencePairs);
+					}
+				}
+				else
+				{
+					fprintf(out, ",,");
+				}
+				if (runCast)
+				{
+					double castTime = timeBest([&]() {
+						for (const LineSegment& l : segments)
+						{
+							sink = sink + cast(l);
+						}
+					});
+					fprintf(out, "%.3f,", castTime * 1e6 / cNumCasts);
+				}
+				else
+				{
+					fprintf(out, ",");
+				}
+				fprintf(out, "%zu\n", memory());
+				fflush(out);
+			};
+			auto isStatic = [&scene](size_t i) { return i >= scene.mNumMoving; };
+
+			// Every pair tested, and every box for casts: PhysWorld's own
+			// TestPairwise and SegmentCastLinear (so its build and update
+			// times include the world's other broadphases)
+			if (numBoxes <= cMaxSweepX)
+			{
+				std::unique_ptr<PhysWorld> world;
+				std::vector<SlotHandle> handles;
+				run("Pairwise",
+					[&]() {
+					world.reset(new PhysWorld(nullptr));
+					handles.clear();
+					for (size_t i = 0; i < boxes.size(); i++)
+					{
+						handles.emplace_back(world->AddBox(boxes[i], nullptr, nullptr,
+							isStatic(i)));
+					}
+				},
+					[&](const std::vector<AABB>& current) {
+					for (size_t i = 0; i < scene.mNumMoving; i++)
+					{
+						world->UpdateBox(handles[i], current[i]);
+					}
+					world->EndTick();
+					world->BeginTick();
+				},
+					[&]() {
+					size_t count = 0;
+					world->TestPairwise([&count](Actor*, Actor*) { count++; });
+					return count;
+				},
+					[&](const LineSegment& l) {
+					PhysWorld::CollisionInfo info;
+					return world->SegmentCastLinear(l, info) ?
+						(info.mPoint - l.mStart).Length() / (l.mEnd - l.mStart).Length() : 1.0f;
+				},
+					[&]() { return world->GetNumBoxes() * sizeof(PhysWorld::Body); },
+					numBoxes <= cMaxPairwise, true);
+			}
+
+			// Sweep and prune on three axes, and on x only
+			for (int axes = 3; axes >= 1; axes -= 2)
+			{
+				if (axes == 1 && numBoxes > cMaxSweepX)
+				{
+					continue;
+				}
+				std::unique_ptr<SweepAndPrune> sap;
+				std::vector<int> proxies;
+				run(axes == 3 ? "SweepAndPrune" : "SweepAndPruneX",
+					[&]() {
+					sap.reset(new SweepAndPrune(axes == 3));
+					proxies.clear();
+					for (size_t i = 0; i < boxes.size(); i++)
+					{
+						proxies.emplace_back(sap->Add(boxes[i],
+							SlotHandle(static_cast<uint32_t>(i), 0), isStatic(i)));
+					}
+					sap->Sync();
+				},
+					[&](const std::vector<AABB>& current) {
+					for (size_t i = 0; i < scene.mNumMoving; i++)
+					{
+						sap->Update(proxies[i], current[i]);
+					}
+					sap->Sync();
+				},
+					[&]() {
+					size_t count = 0;
+					sap->ForEachPair([&count](const SlotHandle&, const SlotHandle&) { count++; });
+					return count;
+				},
+					[](const LineSegment&) { return 0.0f; },
+					[&]() { return sap->GetMemoryUsage(); },
+					true, false);
+			}
+
+			// The tree PhysWorld::SegmentCast uses. Pairs are a query
+			// for each moving box.
+			{
+				std::unique_ptr<AABBTree> tree;
+				std::vector<int> proxies;
+				std::vector<AABB> current;
+				run("AABBTree",
+					[&]() {
+					tree.reset(new AABBTree(10.0f));
+					proxies.clear();
+					for (size_t i = 0; i < boxes.size(); i++)
+					{
+						proxies.emplace_back(tree->Insert(boxes[i],
+							SlotHandle(static_cast<uint32_t>(i), 0)));
+					}
+					current = boxes;
+				},
+					[&](const std::vector<AABB>& moved) {
+					for (size_t i = 0; i < scene.mNumMoving; i++)
+					{
+						tree->Update(proxies[i], moved[i]);
+						current[i] = moved[i];
+					}
+				},
+					[&]() {
+					size_t count = 0;
+					for (size_t i = 0; i < scene.mNumMoving; i++)
+					{
+						tree->Query(current[i], [&](const SlotHandle& other) {
+							// Each moving pair once
+							size_t j = other.mIndex;
+							if ((isStatic(j) || j > i) && Intersect(current[i], current[j]))
+							{
+								count++;
+							}
+						});
+					}
+					return count;
+				},
+					[&](const LineSegment& l) {
+					float closestT = 1.0f;
+					tree->SegmentCast(l, [&](const SlotHandle& handle, float maxT) {
+						float t;
+						Vector3 norm;
+						if (Intersect(l, current[handle.mIndex], t, norm) && t < maxT)
+						{
+							closestT = t;
+							return t;
+						}
+						return maxT;
+					});
+					return closestT;
+				},
+					[&]() { return tree->GetMemoryUsage(); },
+					true, true);
+			}
+
+			{
+				std::unique_ptr<SpatialHash> hash;
+				std::vector<int> proxies;
+				run("SpatialHash",
+					[&]() {
+					hash.reset(new SpatialHash(250.0f));
+					proxies.clear();
+					for (size_t i = 0; i < boxes.size(); i++)
+					{
+						proxies.emplace_back(hash->Add(boxes[i],
+							SlotHandle(static_cast<uint32_t>(i), 0), isStatic(i)));
+					}
+				},
+					[&](const std::vector<AABB>& current) {
+					for (size_t i = 0; i < scene.mNumMoving; i++)
+					{
+						hash->Update(proxies[i], current[i]);
+					}
+				},
+					[&]() {
+					size_t count = 0;
+					hash->ForEachPair([&count](const SlotHandle&, const SlotHandle&) { count++; });
+					return count;
+				},
+					[](const LineSegment&) { return 0.0f; },
+					[&]() { return hash->GetMemoryUsage(); },
+					true, false);
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <cstdio>
+
+// Microbenchmarks for engine hot paths. These don't need SDL, GL or
+// FMOD, so they also build on their own (see Benchmark/CMakeLists.txt).
+class Benchmark
+{
+public:
+	// Human-readable tables of the sections below
+	static void RunAll();
+
+	// Math, Collision, animation and PhysWorld cases on synthetic data,
+	// written as CSV rows so results can be compared between builds.
+	// If filter isn't null, only cases whose name contains it are run.
+	static void RunSuite(FILE* out, const char* filter = nullptr);
+
+	// Broadphases on stress scenes (uniform, clustered, corridors and
+	// mostly static) from 1000 boxes up to maxBoxes, ten times bigger
+	// each time. Writes a CSV row for each scene, size and broadphase:
+	// time to build it, to update it for a frame of movement, to find
+	// the pairs, and per segment cast, and the memory it uses.
+	static void RunScaling(FILE* out, const char* filter = nullptr,
+		size_t maxBoxes = 100000);
+
+	// World transforms from position/rotation/scale, scalar vs. batched
+	static void RunTransforms();
+	// Math.h operations, scalar vs. SIMD
+	static void RunMath();
+	// Matrix4 inverses: error against InvertScalar, and speed
+	static void RunInverse();
+	// VectorStream kernels against the same work on Vector3 arrays
+	static void RunVectorStreams();
+	// PhysWorld segment casts one at a time and in packets
+	static void RunSegmentCasts();
+};
@@ -0,0 +1,102 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "Benchmark.h"
+#include "LevelLoader.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// The benchmark doesn't link SDL or LevelLoader.cpp. These stand in
+// for the few functions the engine files above call from them.
+extern "C" void SDL_Log(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+}
+
+bool LevelLoader::LoadJSON(const std::string& fileName, rapidjson::Document&)
+{
+	SDL_Log("LoadJSON isn't available in the benchmark (%s)", fileName.c_str());
+	return false;
+}
+
+// Benchmark [-filter text] [-o file.csv] [-tables] [-scaling [maxBoxes]]
+int main(int argc, char** argv)
+{
+	const char* filter = nullptr;
+	const char* outFile = nullptr;
+	bool tables = false;
+	bool scaling = false;
+	// (1000000 works too, but takes minutes per scene)
+	size_t maxBoxes = 100000;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+		{
+			outFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "-tables") == 0)
+		{
+			tables = true;
+		}
+		else if (strcmp(argv[i], "-scaling") == 0)
+		{
+			scaling = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+			{
+				maxBoxes = strtoul(argv[++i], nullptr, 10);
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [-filter text] [-o file.csv] [-tables] "
+				"[-scaling [maxBoxes]]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// The tables from the game's -bench option
+	if (tables)
+	{
+		Benchmark::RunAll();
+		return 0;
+	}
+
+	FILE* out = stdout;
+	if (outFile)
+	{
+		out = fopen(outFile, "w");
+		if (!out)
+		{
+			fprintf(stderr, "Unable to open %s\n", outFile);
+			return 1;
+		}
+	}
+	if (scaling)
+	{
+		Benchmark::RunScaling(out, filter, maxBoxes);
+	}
+	else
+	{
+		Benchmark::RunSuite(out, filter);
+	}
+	if (out != stdout)
+	{
+		fclose(out);
+	}
+	return 0;
+}
@@ -18,12 +18,12 @@ BoxComponent::BoxComponent(Actor* owner, int updateOrder)
 	,mWorldBox(Vector3::Zero, Vector3::Zero)
 	,mShouldRotate(true)
 {
-	mOwner->GetGame()->GetPhysWorld()->AddBox(this);
+	mPhysHandle = mOwner->GetGame()->GetPhysWorld()->AddBox(this);
 }
 
 BoxComponent::~BoxComponent()
 {
-	mOwner->GetGame()->GetPhysWorld()->RemoveBox(this);
+	mOwner->GetGame()->GetPhysWorld()->RemoveBox(mPhysHandle);
 }
 
 void BoxComponent::OnUpdateWorldTransform()
@@ -41,6 +41,12 @@ void BoxComponent::OnUpdateWorldTransform()
 	// Translate
 	mWorldBox.mMin += mOwner->GetPosition();
 	mWorldBox.mMax += mOwner->GetPosition();
+	mOwner->GetGame()->GetPhysWorld()->UpdateBox(mPhysHandle, mWorldBox);
+}
+
+void BoxComponent::OnSetStatic(bool isStatic)
+{
+	mOwner->GetGame()->GetPhysWorld()->SetBoxStatic(mPhysHandle, isStatic);
 }
 
 void BoxComponent::LoadProperties(const rapidjson::Value& inObj)
@@ -52,6 +58,7 @@ void BoxComponent::LoadProperties(const rapidjson::Value& inObj)
 	JsonHelper::GetVector3(inObj, "worldMin", mWorldBox.mMin);
 	JsonHelper::GetVector3(inObj, "worldMax", mWorldBox.mMax);
 	JsonHelper::GetBool(inObj, "shouldRotate", mShouldRotate);
+	mOwner->GetGame()->GetPhysWorld()->UpdateBox(mPhysHandle, mWorldBox);
 }
 
 void BoxComponent::SaveProperties(rapidjson::Document::AllocatorType & alloc, rapidjson::Value & inObj) const
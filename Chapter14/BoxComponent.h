@@ -9,6 +9,7 @@
 #pragma once
 #include "Component.h"
 #include "Collision.h"
+#include "SlotMap.h"
 
 class BoxComponent : public Component
 {
@@ -17,18 +18,23 @@ public:
 	~BoxComponent();
 
 	void OnUpdateWorldTransform() override;
+	void OnSetStatic(bool isStatic) override;
 
 	void SetObjectBox(const AABB& model) { mObjectBox = model; }
 	const AABB& GetWorldBox() const { return mWorldBox; }
 
 	TypeID GetType() const override { return TBoxComponent; }
+	COMPONENT_POOL(BoxComponent)
 
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
 		rapidjson::Value& inObj) const override;
 	void SetShouldRotate(bool value) { mShouldRotate = value; }
+	const SlotHandle& GetPhysHandle() const { return mPhysHandle; }
 private:
 	AABB mObjectBox;
 	AABB mWorldBox;
 	bool mShouldRotate;
+	// Handle from PhysWorld::AddBox
+	SlotHandle mPhysHandle;
 };
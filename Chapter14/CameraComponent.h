@@ -16,6 +16,7 @@ public:
 	CameraComponent(class Actor* owner, int updateOrder = 200);
 
 	TypeID GetType() const override { return TCameraComponent; }
+	COMPONENT_POOL(CameraComponent)
 protected:
 	void SetViewMatrix(const Matrix4& view);
 };
@@ -15,8 +15,8 @@
 // ----------------------------------------------------------------
 
 #include "Collision.h"
+#include "VectorStream.h"
 #include <algorithm>
-#include <array>
 
 LineSegment::LineSegment(const Vector3& start, const Vector3& end)
 	:mStart(start)
@@ -186,31 +186,24 @@ void AABB::UpdateMinMax(const Vector3& point)
 void AABB::Rotate(const Quaternion& q)
 {
 	// Construct the 8 points for the corners of the box
-	std::array<Vector3, 8> points;
+	// (one stream per thread, since boxes update on job threads)
+	thread_local VectorStream points(8);
 	// Min point is always a corner
-	points[0] = mMin;
+	points.Set(0, mMin);
 	// Permutations with 2 min and 1 max
-	points[1] = Vector3(mMax.x, mMin.y, mMin.z);
-	points[2] = Vector3(mMin.x, mMax.y, mMin.z);
-	points[3] = Vector3(mMin.x, mMin.y, mMax.z);
+	points.Set(1, Vector3(mMax.x, mMin.y, mMin.z));
+	points.Set(2, Vector3(mMin.x, mMax.y, mMin.z));
+	points.Set(3, Vector3(mMin.x, mMin.y, mMax.z));
 	// Permutations with 2 max and 1 min
-	points[4] = Vector3(mMin.x, mMax.y, mMax.z);
-	points[5] = Vector3(mMax.x, mMin.y, mMax.z);
-	points[6] = Vector3(mMax.x, mMax.y, mMin.z);
+	points.Set(4, Vector3(mMin.x, mMax.y, mMax.z));
+	points.Set(5, Vector3(mMax.x, mMin.y, mMax.z));
+	points.Set(6, Vector3(mMax.x, mMax.y, mMin.z));
 	// Max point corner
-	points[7] = Vector3(mMax);
-
-	// Rotate first point
-	Vector3 p = Vector3::Transform(points[0], q);
-	// Reset min/max to first point rotated
-	mMin = p;
-	mMax = p;
-	// Update min/max based on remaining points, rotated
-	for (size_t i = 1; i < points.size(); i++)
-	{
-		p = Vector3::Transform(points[i], q);
-		UpdateMinMax(p);
-	}
+	points.Set(7, mMax);
+
+	// Rotate all the points, and the new box bounds them
+	VectorStream::Transform(points, q, points);
+	VectorStream::MinMax(points, mMin, mMax);
 }
 
 bool AABB::Contains(const Vector3& point) const
@@ -233,7 +226,7 @@ float AABB::MinDistSq(const Vector3& point) const
 	float dy = Math::Max(mMin.y - point.y, 0.0f);
 	dy = Math::Max(dy, point.y - mMax.y);
 	float dz = Math::Max(mMin.z - point.z, 0.0f);
-	dz = Math::Max(dy, point.z - mMax.z);
+	dz = Math::Max(dz, point.z - mMax.z);
 	// Distance squared formula
 	return dx * dx + dy * dy + dz * dz;
 }
@@ -389,7 +382,7 @@ bool Intersect(const LineSegment& l, const Plane& p, float& outT)
 }
 
 bool TestSidePlane(float start, float end, float negd, const Vector3& norm,
-	std::vector<std::pair<float, Vector3>>& out)
+	std::pair<float, Vector3>* out, int& outCount)
 {
 	float denom = end - start;
 	if (Math::NearZero(denom))
@@ -403,7 +396,7 @@ bool TestSidePlane(float start, float end, float negd, const Vector3& norm,
 		// Test that t is within bounds
 		if (t >= 0.0f && t <= 1.0f)
 		{
-			out.emplace_back(t, norm);
+			out[outCount++] = std::make_pair(t, norm);
 			return true;
 		}
 		else
@@ -416,34 +409,37 @@ bool TestSidePlane(float start, float end, float negd, const Vector3& norm,
 bool Intersect(const LineSegment& l, const AABB& b, float& outT,
 	Vector3& outNorm)
 {
-	// Vector to save all possible t values, and normals for those sides
-	std::vector<std::pair<float, Vector3>> tValues;
+	// Save all possible t values, and normals for those sides
+	// (at most one per side, so no need to allocate)
+	std::pair<float, Vector3> tValues[6];
+	int numValues = 0;
 	// Test the x planes
 	TestSidePlane(l.mStart.x, l.mEnd.x, b.mMin.x, Vector3::NegUnitX,
-		tValues);
+		tValues, numValues);
 	TestSidePlane(l.mStart.x, l.mEnd.x, b.mMax.x, Vector3::UnitX,
-		tValues);
+		tValues, numValues);
 	// Test the y planes
 	TestSidePlane(l.mStart.y, l.mEnd.y, b.mMin.y, Vector3::NegUnitY,
-		tValues);
+		tValues, numValues);
 	TestSidePlane(l.mStart.y, l.mEnd.y, b.mMax.y, Vector3::UnitY,
-		tValues);
+		tValues, numValues);
 	// Test the z planes
 	TestSidePlane(l.mStart.z, l.mEnd.z, b.mMin.z, Vector3::NegUnitZ,
-		tValues);
+		tValues, numValues);
 	TestSidePlane(l.mStart.z, l.mEnd.z, b.mMax.z, Vector3::UnitZ,
-		tValues);
+		tValues, numValues);
 	
 	// Sort the t values in ascending order
-	std::sort(tValues.begin(), tValues.end(), [](
+	std::sort(tValues, tValues + numValues, [](
 		const std::pair<float, Vector3>& a,
 		const std::pair<float, Vector3>& b) {
 		return a.first < b.first;
 	});
 	// Test if the box contains any of these points of intersection
 	Vector3 point;
-	for (auto& t : tValues)
+	for (int i = 0; i < numValues; i++)
 	{
+		const auto& t = tValues[i];
 		point = l.PointOnSegment(t.first);
 		if (b.Contains(point))
 		{
@@ -479,7 +475,7 @@ bool SweptSphere(const Sphere& P0, const Sphere& P1,
 		disc = Math::Sqrt(disc);
 		// We only care about the smaller solution
 		outT = (-b - disc) / (2.0f * a);
-		if (outT >= 0.0f && outT <= 0.0f)
+		if (outT >= 0.0f && outT <= 1.0f)
 		{
 			return true;
 		}
@@ -489,3 +485,242 @@ bool SweptSphere(const Sphere& P0, const Sphere& P1,
 		}
 	}
 }
+
+namespace
+{
+	// How far a shape can be inside a box at the start of a sweep and
+	// still count as touching it (for float error after moving to the
+	// last contact)
+	const float cContactSkin = 0.01f;
+
+	// Whether a t from one of the sweeps below counts as a hit
+	bool AcceptSweepT(float t, float length)
+	{
+		return t <= 1.0f && t * length >= -cContactSkin;
+	}
+
+	// Where the segment from start to start + delta enters box, and the
+	// normal of the side it goes in through
+	bool SegmentEntersBox(const Vector3& start, const Vector3& delta,
+		const AABB& box, float& outT, Vector3& outNorm)
+	{
+		const float* s = start.GetAsFloatPtr();
+		const float* d = delta.GetAsFloatPtr();
+		const float* boxMin = box.mMin.GetAsFloatPtr();
+		const float* boxMax = box.mMax.GetAsFloatPtr();
+		float enter = Math::NegInfinity;
+		float exit = Math::Infinity;
+		int enterAxis = -1;
+		float enterSign = 0.0f;
+		for (int i = 0; i < 3; i++)
+		{
+			if (d[i] == 0.0f)
+			{
+				// Parallel to this slab, so it has to start inside it
+				if (s[i] < boxMin[i] || s[i] > boxMax[i])
+				{
+					return false;
+				}
+				continue;
+			}
+
+			float t1 = (boxMin[i] - s[i]) / d[i];
+			float t2 = (boxMax[i] - s[i]) / d[i];
+			// Going in through the min side faces -axis
+			float sign = -1.0f;
+			if (t1 > t2)
+			{
+				std::swap(t1, t2);
+				sign = 1.0f;
+			}
+			if (t1 > enter)
+			{
+				enter = t1;
+				enterAxis = i;
+				enterSign = sign;
+			}
+			exit = Math::Min(exit, t2);
+		}
+
+		// Not moving, or not moving into it
+		if (enterAxis < 0 || enter > exit || exit < 0.0f ||
+			!AcceptSweepT(enter, delta.Length()))
+		{
+			return false;
+		}
+		const Vector3 axes[3] = { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ };
+		outT = Math::Max(enter, 0.0f);
+		outNorm = axes[enterAxis] * enterSign;
+		return true;
+	}
+
+	// First t where start + delta * t is within radius of center
+	bool SegmentEntersSphere(const Vector3& start, const Vector3& delta,
+		const Vector3& center, float radius, float& outT)
+	{
+		Vector3 w = start - center;
+		float a = Vector3::Dot(delta, delta);
+		float b = Vector3::Dot(w, delta);
+		float c = Vector3::Dot(w, w) - radius * radius;
+		float disc = b * b - a * c;
+		if (a == 0.0f || disc < 0.0f)
+		{
+			return false;
+		}
+		outT = (-b - Math::Sqrt(disc)) / a;
+		return AcceptSweepT(outT, Math::Sqrt(a));
+	}
+
+	// First t where start + delta * t is within radius of the segment
+	// from p to q (so, enters the capsule around it)
+	bool SegmentEntersCapsule(const Vector3& start, const Vector3& delta,
+		const Vector3& p, const Vector3& q, float radius, float& outT)
+	{
+		float best = Math::Infinity;
+		float t;
+		// The round side, where the closest point is between p and q
+		Vector3 m = q - p;
+		Vector3 w = start - p;
+		float mm = Vector3::Dot(m, m);
+		float md = Vector3::Dot(m, delta);
+		float mw = Vector3::Dot(m, w);
+		float a = mm * Vector3::Dot(delta, delta) - md * md;
+		float b = mm * Vector3::Dot(delta, w) - md * mw;
+		float c = mm * (Vector3::Dot(w, w) - radius * radius) - mw * mw;
+		float disc = b * b - a * c;
+		if (a > 0.0f && disc >= 0.0f)
+		{
+			t = (-b - Math::Sqrt(disc)) / a;
+			float along = (mw + t * md) / mm;
+			if (along >= 0.0f && along <= 1.0f && AcceptSweepT(t, delta.Length()))
+			{
+				best = t;
+			}
+		}
+		// The ends
+		if (SegmentEntersSphere(start, delta, p, radius, t))
+		{
+			best = Math::Min(best, t);
+		}
+		if (SegmentEntersSphere(start, delta, q, radius, t))
+		{
+			best = Math::Min(best, t);
+		}
+
+		if (best == Math::Infinity)
+		{
+			return false;
+		}
+		outT = Math::Max(best, 0.0f);
+		return true;
+	}
+
+	// Corner of the box with max on the axes set in bits (x = 1, y = 2,
+	// z = 4), and min on the others
+	Vector3 Corner(const AABB& b, int bits)
+	{
+		return Vector3((bits & 1) ? b.mMax.x : b.mMin.x,
+			(bits & 2) ? b.mMax.y : b.mMin.y,
+			(bits & 4) ? b.mMax.z : b.mMin.z);
+	}
+}
+
+bool SweptAABB(const AABB& a, const Vector3& delta, const AABB& b,
+	float& outT, Vector3& outNorm)
+{
+	// Same as moving a's center against b grown by a's half size
+	Vector3 half = (a.mMax - a.mMin) * 0.5f;
+	AABB grown(b.mMin - half, b.mMax + half);
+	return SegmentEntersBox(a.mMin + half, delta, grown, outT, outNorm);
+}
+
+bool SweptSphere(const Sphere& s, const Vector3& delta, const AABB& b,
+	float& outT, Vector3& outNorm)
+{
+	// The center against the box grown by the radius. That's exact on
+	// the sides, but the grown box's edges and corners are square
+	// where the real shape is rounded.
+	Vector3 r(s.mRadius, s.mRadius, s.mRadius);
+	AABB grown(b.mMin - r, b.mMax + r);
+	float t;
+	bool startsInside = false;
+	if (!SegmentEntersBox(s.mCenter, delta, grown, t, outNorm))
+	{
+		// Starting in one of the grown box's square edges or corners
+		// is still outside the real shape (checked below)
+		if (!grown.Contains(s.mCenter))
+		{
+			return false;
+		}
+		startsInside = true;
+		t = 0.0f;
+	}
+
+	// Which of b's sides the hit point is past
+	Vector3 p = s.mCenter + delta * t;
+	int below = 0;
+	int above = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		float value = p.GetAsFloatPtr()[i];
+		if (value < b.mMin.GetAsFloatPtr()[i])
+		{
+			below |= 1 << i;
+		}
+		if (value > b.mMax.GetAsFloatPtr()[i])
+		{
+			above |= 1 << i;
+		}
+	}
+	int mask = below | above;
+
+	if (startsInside && (mask & (mask - 1)) == 0)
+	{
+		// Already overlapping one of the sides
+		return false;
+	}
+	else if ((mask & (mask - 1)) != 0)
+	{
+		// Past two sides (an edge) or three (a corner), so test the
+		// rounded edges there instead
+		bool hit;
+		if (mask == 7)
+		{
+			float best = Math::Infinity;
+			Vector3 corner = Corner(b, above);
+			for (int axis = 1; axis <= 4; axis <<= 1)
+			{
+				if (SegmentEntersCapsule(s.mCenter, delta, corner,
+					Corner(b, above ^ axis), s.mRadius, t))
+				{
+					best = Math::Min(best, t);
+				}
+			}
+			hit = best != Math::Infinity;
+			t = best;
+		}
+		else
+		{
+			hit = SegmentEntersCapsule(s.mCenter, delta, Corner(b, below ^ 7),
+				Corner(b, above), s.mRadius, t);
+		}
+		if (!hit)
+		{
+			return false;
+		}
+
+		// Normal from the closest point on the box
+		Vector3 center = s.mCenter + delta * t;
+		Vector3 closest(Math::Clamp(center.x, b.mMin.x, b.mMax.x),
+			Math::Clamp(center.y, b.mMin.y, b.mMax.y),
+			Math::Clamp(center.z, b.mMin.z, b.mMax.z));
+		Vector3 norm = center - closest;
+		if (norm.LengthSq() > 0.0f)
+		{
+			norm.Normalize();
+			outNorm = norm;
+		}
+	}
+	outT = t;
+	return true;
+}
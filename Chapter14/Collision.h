@@ -98,3 +98,13 @@ bool Intersect(const LineSegment& l, const AABB& b, float& outT,
 
 bool SweptSphere(const Sphere& P0, const Sphere& P1,
 	const Sphere& Q0, const Sphere& Q1, float& t);
+
+// A shape moving by delta against a box that doesn't move. outT is
+// the fraction of delta it moves before touching the box, and outNorm
+// is the box's normal there. A shape that starts out overlapping the
+// box is ignored (so it can move back out), unless it's only touching
+// and moving further in.
+bool SweptAABB(const AABB& a, const Vector3& delta, const AABB& b,
+	float& outT, Vector3& outNorm);
+bool SweptSphere(const Sphere& s, const Vector3& delta, const AABB& b,
+	float& outT, Vector3& outNorm);
@@ -9,6 +9,7 @@
 #pragma once
 #include "Math.h"
 #include <rapidjson/document.h>
+#include "ComponentPool.h"
 
 class Component
 {
@@ -45,6 +46,14 @@ public:
 	virtual void ProcessInput(const uint8_t* keyState) {}
 	// Called when world transform changes
 	virtual void OnUpdateWorldTransform();
+	// Called when the owner becomes static (or stops being static)
+	virtual void OnSetStatic(bool /*isStatic*/) { }
+	// Whether Update only touches this component and its owner, so
+	// the type can update on job threads (see Game::Defer for the rest).
+	// PhysWorld queries are fine too, but only because the broadphase
+	// doesn't change until PhysWorld::EndTick (UpdateBox just records
+	// the box).
+	virtual bool CanUpdateInParallel() const { return false; }
 
 	class Actor* GetOwner() { return mOwner; }
 	int GetUpdateOrder() const { return mUpdateOrder; }
@@ -0,0 +1,198 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "ComponentPool.h"
+#include "Component.h"
+#include "Memory.h"
+#include <new>
+#include <climits>
+
+namespace
+{
+	std::vector<ComponentPool*>& PoolRegistry()
+	{
+		static std::vector<ComponentPool*> pools;
+		return pools;
+	}
+}
+
+ComponentPool::ComponentPool(size_t objectSize, Component* (*toComponent)(void*),
+	size_t objectsPerChunk)
+	:mToComponent(toComponent)
+	,mTypeSize(objectSize)
+	,mObjectSize(objectSize)
+	,mObjectsPerChunk(objectsPerChunk)
+	,mNumLive(0)
+	,mInPass(false)
+{
+	// Keep every slot aligned like the heap would
+	size_t align = alignof(std::max_align_t);
+	mObjectSize = (mObjectSize + align - 1) / align * align;
+	PoolRegistry().emplace_back(this);
+}
+
+ComponentPool::~ComponentPool()
+{
+	for (auto& chunk : mChunks)
+	{
+		::operator delete(chunk.mData);
+		delete[] chunk.mState;
+	}
+}
+
+const std::vector<ComponentPool*>& ComponentPool::GetPools()
+{
+	return PoolRegistry();
+}
+
+void* ComponentPool::Allocate(size_t size)
+{
+	if (size != mTypeSize)
+	{
+		return ::operator new(size);
+	}
+
+	if (mFreeSlots.empty())
+	{
+		AddChunk();
+	}
+	size_t index = mFreeSlots.back();
+	mFreeSlots.pop_back();
+
+	Chunk& chunk = mChunks[index / mObjectsPerChunk];
+	size_t slot = index % mObjectsPerChunk;
+	if (mInPass)
+	{
+		chunk.mState[slot] = ENew;
+		mNewSlots.emplace_back(&chunk.mState[slot]);
+	}
+	else
+	{
+		chunk.mState[slot] = ELive;
+	}
+	mNumLive++;
+	MemoryStats::sPoolAllocs.fetch_add(1, std::memory_order_relaxed);
+	return chunk.mData + slot * mObjectSize;
+}
+
+void ComponentPool::Free(void* ptr, size_t size)
+{
+	if (size == mTypeSize)
+	{
+		size_t index = 0;
+		uint8_t* state = FindSlot(ptr, index);
+		if (state)
+		{
+			*state = EFree;
+			mFreeSlots.emplace_back(index);
+			mNumLive--;
+			return;
+		}
+	}
+	// Not one of ours, so it came from the regular heap
+	::operator delete(ptr);
+}
+
+void ComponentPool::BeginPass()
+{
+	mInPass = true;
+}
+
+void ComponentPool::EndPass()
+{
+	mInPass = false;
+	for (uint8_t* state : mNewSlots)
+	{
+		// Might have been freed again during the pass
+		if (*state == ENew)
+		{
+			*state = ELive;
+		}
+	}
+	mNewSlots.clear();
+}
+
+void ComponentPool::SetStatic(Component* comp, bool isStatic)
+{
+	// Only happens when loading, so just ask every pool
+	for (ComponentPool* pool : PoolRegistry())
+	{
+		size_t index = 0;
+		uint8_t* state = pool->FindSlot(comp, index);
+		if (state)
+		{
+			if (isStatic && *state != EFree)
+			{
+				*state = EStatic;
+			}
+			else if (!isStatic && *state == EStatic)
+			{
+				*state = ELive;
+			}
+			return;
+		}
+	}
+}
+
+uint8_t* ComponentPool::FindSlot(void* ptr, size_t& outIndex)
+{
+	char* p = static_cast<char*>(ptr);
+	for (size_t i = 0; i < mChunks.size(); i++)
+	{
+		Chunk& chunk = mChunks[i];
+		if (p >= chunk.mData && p < chunk.mData + mObjectsPerChunk * mObjectSize)
+		{
+			size_t slot = (p - chunk.mData) / mObjectSize;
+			outIndex = i * mObjectsPerChunk + slot;
+			return &chunk.mState[slot];
+		}
+	}
+	return nullptr;
+}
+
+int ComponentPool::GetUpdateOrder() const
+{
+	Component* comp = GetFirstLive();
+	return comp ? comp->GetUpdateOrder() : INT_MAX;
+}
+
+bool ComponentPool::CanUpdateInParallel() const
+{
+	Component* comp = GetFirstLive();
+	return comp ? comp->CanUpdateInParallel() : false;
+}
+
+Component* ComponentPool::GetFirstLive() const
+{
+	for (const auto& chunk : mChunks)
+	{
+		for (size_t i = 0; i < mObjectsPerChunk; i++)
+		{
+			if (chunk.mState[i] == ELive)
+			{
+				return mToComponent(chunk.mData + i * mObjectSize);
+			}
+		}
+	}
+	return nullptr;
+}
+
+void ComponentPool::AddChunk()
+{
+	Chunk chunk;
+	chunk.mData = static_cast<char*>(::operator new(mObjectsPerChunk * mObjectSize));
+	chunk.mState = new uint8_t[mObjectsPerChunk]();
+	mChunks.emplace_back(chunk);
+
+	// Push in reverse so the lowest address is handed out first
+	size_t first = (mChunks.size() - 1) * mObjectsPerChunk;
+	for (size_t i = mObjectsPerChunk; i > 0; i--)
+	{
+		mFreeSlots.emplace_back(first + i - 1);
+	}
+}
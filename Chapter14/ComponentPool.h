@@ -0,0 +1,132 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Storage for every component of one concrete type. Components sit
+// next to each other in fixed-size chunks, so a pass over all
+// components of a type walks memory in order. Components never move
+// once allocated, so pointers to them stay valid.
+class ComponentPool
+{
+public:
+	ComponentPool(size_t objectSize, class Component* (*toComponent)(void*),
+		size_t objectsPerChunk = 64);
+	~ComponentPool();
+
+	// Get the pool for a component type (created on first use)
+	template <typename T>
+	static ComponentPool& Get()
+	{
+		static ComponentPool pool(sizeof(T), &ToComponent<T>);
+		return pool;
+	}
+	// All pools created so far
+	static const std::vector<ComponentPool*>& GetPools();
+
+	// Called from the operator new/delete of the pool's type.
+	// A derived type without its own pool has a different size,
+	// so it falls back to the regular heap.
+	void* Allocate(size_t size);
+	void Free(void* ptr, size_t size);
+
+	// Components allocated between BeginPass and EndPass are
+	// skipped by ForEach until the next pass
+	void BeginPass();
+	void EndPass();
+
+	// Static components stay allocated, but ForEach skips them
+	// (for actors that never change, see Actor::SetStatic)
+	static void SetStatic(class Component* comp, bool isStatic);
+
+	// Call func on every live component, in memory order
+	template <typename Func>
+	void ForEach(Func func)
+	{
+		// Index loop, since func may allocate new chunks
+		for (size_t i = 0; i < mChunks.size(); i++)
+		{
+			ForEachInChunk(i, func);
+		}
+	}
+
+	// Same as ForEach, but only for one chunk, so separate
+	// chunks can be handed to separate job threads
+	template <typename Func>
+	void ForEachInChunk(size_t chunk, Func func)
+	{
+		for (size_t j = 0; j < mObjectsPerChunk; j++)
+		{
+			if (mChunks[chunk].mState[j] == ELive)
+			{
+				func(mToComponent(mChunks[chunk].mData + j * mObjectSize));
+			}
+		}
+	}
+	size_t GetNumChunks() const { return mChunks.size(); }
+
+	// Update order of the first live component,
+	// used to decide which type's pass runs first
+	int GetUpdateOrder() const;
+	// Whether the type's Update is safe to run on job threads
+	bool CanUpdateInParallel() const;
+	size_t GetNumLive() const { return mNumLive; }
+	size_t GetObjectSize() const { return mObjectSize; }
+private:
+	template <typename T>
+	static class Component* ToComponent(void* ptr)
+	{
+		return static_cast<T*>(ptr);
+	}
+
+	enum SlotState : uint8_t
+	{
+		EFree,
+		ELive,
+		// Allocated during the current pass
+		ENew,
+		// Belongs to a static actor
+		EStatic
+	};
+
+	struct Chunk
+	{
+		char* mData;
+		uint8_t* mState;
+	};
+
+	void AddChunk();
+	// State of the slot holding ptr, or null if it isn't in this pool
+	uint8_t* FindSlot(void* ptr, size_t& outIndex);
+	class Component* GetFirstLive() const;
+
+	std::vector<Chunk> mChunks;
+	// Free slots (chunk * objects per chunk + slot),
+	// reused most recently freed first
+	std::vector<size_t> mFreeSlots;
+	// Slots allocated during the current pass
+	std::vector<uint8_t*> mNewSlots;
+	class Component* (*mToComponent)(void*);
+	// Size of the type, and of a slot (rounded up for alignment)
+	size_t mTypeSize;
+	size_t mObjectSize;
+	size_t mObjectsPerChunk;
+	size_t mNumLive;
+	bool mInPass;
+};
+
+// Add to the class declaration of each concrete component type,
+// so it is allocated from its own ComponentPool
+#define COMPONENT_POOL(T) \
+	static void* operator new(size_t size) \
+	{ return ComponentPool::Get<T>().Allocate(size); } \
+	static void operator delete(void* ptr, size_t size) \
+	{ ComponentPool::Get<T>().Free(ptr, size); }
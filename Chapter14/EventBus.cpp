@@ -0,0 +1,50 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "EventBus.h"
+#include "Profiler.h"
+#include <SDL/SDL.h>
+
+size_t EventBus::sNumTypes = 0;
+
+// Guards against subscribers that keep publishing to each other
+const int cMaxDispatchRounds = 8;
+
+EventBus::EventBus()
+	:mNextID(1)
+{
+}
+
+EventBus::~EventBus()
+{
+	for (QueueBase* queue : mQueues)
+	{
+		delete queue;
+	}
+}
+
+void EventBus::Dispatch()
+{
+	PROFILE_SCOPE("EventBus::Dispatch");
+	for (int round = 0; round < cMaxDispatchRounds; round++)
+	{
+		size_t delivered = 0;
+		for (QueueBase* queue : mQueues)
+		{
+			if (queue)
+			{
+				delivered += queue->Dispatch();
+			}
+		}
+		if (delivered == 0)
+		{
+			return;
+		}
+	}
+	SDL_Log("EventBus: events still queued after %d rounds", cMaxDispatchRounds);
+}
@@ -0,0 +1,197 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "Math.h"
+#include <SDL/SDL_assert.h>
+
+// Something (usually a ball) ran into an actor
+struct CollisionEvent
+{
+	class Actor* mActor;
+	class Actor* mOther;
+	Vector3 mPoint;
+	Vector3 mNormal;
+};
+
+// A shot hit a target
+struct HitEvent
+{
+	class Actor* mShooter;
+	class Actor* mTarget;
+	Vector3 mPoint;
+};
+
+// An actor joined the game
+struct SpawnEvent
+{
+	class Actor* mActor;
+};
+
+// An actor died, and will be deleted after this dispatch
+struct DeathEvent
+{
+	class Actor* mActor;
+};
+
+// Events are queued when published (from any thread) and delivered
+// to the subscribers of their type when Game calls Dispatch
+class EventBus
+{
+public:
+	EventBus();
+	~EventBus();
+
+	// Each event type must be registered once, on the main thread,
+	// before anything publishes or subscribes to it
+	template <typename T>
+	void Register()
+	{
+		size_t index = GetTypeIndex<T>();
+		if (index >= mQueues.size())
+		{
+			mQueues.resize(index + 1, nullptr);
+		}
+		if (!mQueues[index])
+		{
+			mQueues[index] = new Queue<T>();
+		}
+	}
+
+	// Returns an id for Unsubscribe
+	template <typename T>
+	int Subscribe(std::function<void(const T&)> func)
+	{
+		Queue<T>* queue = GetQueue<T>();
+		queue->mSubscribers.emplace_back(mNextID, std::move(func));
+		return mNextID++;
+	}
+
+	template <typename T>
+	void Unsubscribe(int id)
+	{
+		Queue<T>* queue = GetQueue<T>();
+		for (auto iter = queue->mSubscribers.begin();
+			iter != queue->mSubscribers.end(); ++iter)
+		{
+			if (iter->first == id)
+			{
+				queue->mSubscribers.erase(iter);
+				break;
+			}
+		}
+	}
+
+	// Safe to call from job threads, but events are delivered in the
+	// order they were published, which between threads depends on
+	// timing. Job threads should use PublishOrdered.
+	template <typename T>
+	void Publish(const T& event)
+	{
+		Queue<T>* queue = GetQueue<T>();
+		std::lock_guard<std::mutex> lock(queue->mMutex);
+		queue->mPending.emplace_back(event);
+	}
+
+	// For job threads. These events are delivered before the others of
+	// their type, sorted by key (and in the order published for each
+	// key). A key that doesn't depend on timing, such as the handle of
+	// the actor publishing, keeps the order the same between runs.
+	template <typename T>
+	void PublishOrdered(const T& event, uint64_t key)
+	{
+		Queue<T>* queue = GetQueue<T>();
+		std::lock_guard<std::mutex> lock(queue->mMutex);
+		queue->mPendingOrdered.emplace_back(key, event);
+	}
+
+	// Deliver queued events, type by type in registration order.
+	// Events published by subscribers are delivered in the same call.
+	void Dispatch();
+private:
+	class QueueBase
+	{
+	public:
+		virtual ~QueueBase() { }
+		// Returns how many events were delivered
+		virtual size_t Dispatch() = 0;
+	};
+
+	template <typename T>
+	class Queue : public QueueBase
+	{
+	public:
+		size_t Dispatch() override
+		{
+			{
+				// Swap so subscribers can publish while we deliver.
+				// Both vectors keep their capacity, so once warmed up
+				// this doesn't allocate.
+				std::lock_guard<std::mutex> lock(mMutex);
+				mPending.swap(mDelivering);
+				mPendingOrdered.swap(mDeliveringOrdered);
+			}
+			std::stable_sort(mDeliveringOrdered.begin(), mDeliveringOrdered.end(),
+				[](const std::pair<uint64_t, T>& a, const std::pair<uint64_t, T>& b) {
+				return a.first < b.first;
+			});
+			for (const auto& entry : mDeliveringOrdered)
+			{
+				Deliver(entry.second);
+			}
+			for (const T& event : mDelivering)
+			{
+				Deliver(event);
+			}
+			size_t count = mDelivering.size() + mDeliveringOrdered.size();
+			mDelivering.clear();
+			mDeliveringOrdered.clear();
+			return count;
+		}
+
+		void Deliver(const T& event)
+		{
+			for (auto& sub : mSubscribers)
+			{
+				sub.second(event);
+			}
+		}
+
+		std::vector<T> mPending;
+		std::vector<T> mDelivering;
+		std::vector<std::pair<uint64_t, T>> mPendingOrdered;
+		std::vector<std::pair<uint64_t, T>> mDeliveringOrdered;
+		std::vector<std::pair<int, std::function<void(const T&)>>> mSubscribers;
+		std::mutex mMutex;
+	};
+
+	template <typename T>
+	static size_t GetTypeIndex()
+	{
+		static size_t index = sNumTypes++;
+		return index;
+	}
+
+	template <typename T>
+	Queue<T>* GetQueue()
+	{
+		size_t index = GetTypeIndex<T>();
+		SDL_assert(index < mQueues.size() && mQueues[index]);
+		return static_cast<Queue<T>*>(mQueues[index]);
+	}
+
+	std::vector<QueueBase*> mQueues;
+	int mNextID;
+	static size_t sNumTypes;
+};
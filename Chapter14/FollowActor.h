@@ -23,6 +23,7 @@ public:
 		rapidjson::Value& inObj) const override;
 
 	TypeID GetType() const override { return TFollowActor; }
+	ACTOR_POOL(FollowActor)
 private:
 	class MoveComponent* mMoveComp;
 	class FollowCamera* mCameraComp;
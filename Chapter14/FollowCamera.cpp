@@ -22,6 +22,7 @@ FollowCamera::FollowCamera(Actor* owner)
 void FollowCamera::Update(float deltaTime)
 {
 	CameraComponent::Update(deltaTime);
+	mPrevActualPos = mActualPos;
 	// Compute dampening from spring constant
 	float dampening = 2.0f * Math::Sqrt(mSpringConstant);
 	// Compute ideal position
@@ -35,28 +36,28 @@ void FollowCamera::Update(float deltaTime)
 	mVelocity += acel * deltaTime;
 	// Update actual camera position
 	mActualPos += mVelocity * deltaTime;
-	// Target is target dist in front of owning actor
-	Vector3 target = mOwner->GetPosition() +
-		mOwner->GetForward() * mTargetDist;
-	// Use actual position here, not ideal
-	Matrix4 view = Matrix4::CreateLookAt(mActualPos, target,
-		Vector3::UnitZ);
-	SetViewMatrix(view);
+	// Use actual position here, not ideal (UpdateView replaces this
+	// with a blended view before drawing)
+	SetView(mActualPos, mOwner->GetPosition(), mOwner->GetForward());
+}
+
+void FollowCamera::UpdateView(float alpha)
+{
+	// Follow the owner as it's drawn, so it doesn't jitter against
+	// the camera
+	const Matrix4& ownerTransform = mOwner->GetRenderTransform();
+	SetView(Vector3::Lerp(mPrevActualPos, mActualPos, alpha),
+		ownerTransform.GetTranslation(), ownerTransform.GetXAxis());
 }
 
 void FollowCamera::SnapToIdeal()
 {
 	// Set actual position to ideal
 	mActualPos = ComputeCameraPos();
+	mPrevActualPos = mActualPos;
 	// Zero velocity
 	mVelocity = Vector3::Zero;
-	// Compute target and view
-	Vector3 target = mOwner->GetPosition() +
-		mOwner->GetForward() * mTargetDist;
-	// Use actual position here, not ideal
-	Matrix4 view = Matrix4::CreateLookAt(mActualPos, target,
-		Vector3::UnitZ);
-	SetViewMatrix(view);
+	SetView(mActualPos, mOwner->GetPosition(), mOwner->GetForward());
 }
 
 void FollowCamera::LoadProperties(const rapidjson::Value& inObj)
@@ -64,6 +65,7 @@ void FollowCamera::LoadProperties(const rapidjson::Value& inObj)
 	CameraComponent::LoadProperties(inObj);
 
 	JsonHelper::GetVector3(inObj, "actualPos", mActualPos);
+	mPrevActualPos = mActualPos;
 	JsonHelper::GetVector3(inObj, "velocity", mVelocity);
 	JsonHelper::GetFloat(inObj, "horzDist", mHorzDist);
 	JsonHelper::GetFloat(inObj, "vertDist", mVertDist);
@@ -83,6 +85,16 @@ void FollowCamera::SaveProperties(rapidjson::Document::AllocatorType& alloc, rap
 	JsonHelper::AddFloat(alloc, inObj, "springConstant", mSpringConstant);
 }
 
+void FollowCamera::SetView(const Vector3& cameraPos, const Vector3& ownerPos,
+	const Vector3& ownerForward)
+{
+	// Target is target dist in front of owning actor
+	Vector3 target = ownerPos + ownerForward * mTargetDist;
+	Matrix4 view = Matrix4::CreateLookAt(cameraPos, target,
+		Vector3::UnitZ);
+	SetViewMatrix(view);
+}
+
 Vector3 FollowCamera::ComputeCameraPos() const
 {
 	// Set camera position behind and above owner
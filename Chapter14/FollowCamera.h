@@ -17,6 +17,9 @@ public:
 	void Update(float deltaTime) override;
 	
 	void SnapToIdeal();
+	// Sets the view for drawing, blended between the last two ticks
+	// (alpha as in Actor::InterpolateTransform)
+	void UpdateView(float alpha);
 
 	void SetHorzDist(float dist) { mHorzDist = dist; }
 	void SetVertDist(float dist) { mVertDist = dist; }
@@ -24,15 +27,20 @@ public:
 	void SetSpringConstant(float spring) { mSpringConstant = spring; }
 
 	TypeID GetType() const override { return TFollowCamera; }
+	COMPONENT_POOL(FollowCamera)
 
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
 		rapidjson::Value& inObj) const override;
 private:
 	Vector3 ComputeCameraPos() const;
+	void SetView(const Vector3& cameraPos, const Vector3& ownerPos,
+		const Vector3& ownerForward);
 
 	// Actual position of camera
 	Vector3 mActualPos;
+	// Actual position as of the previous tick
+	Vector3 mPrevActualPos;
 	// Velocity of actual camera
 	Vector3 mVelocity;
 	// Horizontal follow distance
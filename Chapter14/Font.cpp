@@ -60,6 +60,13 @@ void Font::Unload()
 Texture* Font::RenderText(const std::string& textKey,
 						  const Vector3& color /*= Color::White*/,
 						  int pointSize /*= 24*/)
+{
+	return RenderString(mGame->GetText(textKey), color, pointSize);
+}
+
+Texture* Font::RenderString(const std::string& text,
+							const Vector3& color /*= Color::White*/,
+							int pointSize /*= 24*/)
 {
 	Texture* texture = nullptr;
 	
@@ -75,9 +82,8 @@ Texture* Font::RenderText(const std::string& textKey,
 	if (iter != mFontData.end())
 	{
 		TTF_Font* font = iter->second;
-		const std::string& actualText = mGame->GetText(textKey);
 		// Draw this to a surface (blended for alpha)
-		SDL_Surface* surf = TTF_RenderUTF8_Blended(font, actualText.c_str(), sdlColor);
+		SDL_Surface* surf = TTF_RenderUTF8_Blended(font, text.c_str(), sdlColor);
 		if (surf != nullptr)
 		{
 			// Convert from surface to texture
@@ -26,6 +26,10 @@ public:
 	class Texture* RenderText(const std::string& textKey,
 							  const Vector3& color = Color::White,
 							  int pointSize = 30);
+	// Same, but draws the string as is (no localization lookup)
+	class Texture* RenderString(const std::string& text,
+								const Vector3& color = Color::White,
+								int pointSize = 30);
 private:
 	// Map of point sizes to font data
 	std::unordered_map<int, TTF_Font*> mFontData;
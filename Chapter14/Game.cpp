@@ -28,20 +28,46 @@
 #include "Animation.h"
 #include "PointLightComponent.h"
 #include "LevelLoader.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "EventBus.h"
+#include "TargetComponent.h"
+#include "FollowCamera.h"
+#include <cstring>
+
+// Longest frame the simulation will try to catch up on
+const float cMaxFrameTime = 0.25f;
 
 Game::Game()
 :mRenderer(nullptr)
 ,mAudioSystem(nullptr)
 ,mPhysWorld(nullptr)
+,mJobSystem(nullptr)
+,mEventBus(nullptr)
+,mFrameHeapAllocs(0)
+,mFrameCounter(0)
+,mTickLength(1.0f / 60.0f)
+,mTickAccumulator(0.0f)
+,mMaxFrameRate(60.0f)
 ,mGameState(EGameplay)
 ,mUpdatingActors(false)
+,mUpdateByType(true)
+,mThreadedPhysics(false)
+,mHeadless(false)
 {
-	
+	mInput.mFrameTime = 0.0f;
+	memset(mInput.mKeys, 0, sizeof(mInput.mKeys));
+	mInput.mMouseX = 0;
+	mInput.mMouseY = 0;
 }
 
-bool Game::Initialize()
+bool Game::Initialize(bool headless)
 {
-	if (SDL_Init(SDL_INIT_VIDEO|SDL_INIT_AUDIO) != 0)
+	mHeadless = headless;
+	Profiler::SetThreadName("Main");
+	// Headless doesn't need any SDL subsystems
+	Uint32 flags = mHeadless ? 0 : SDL_INIT_VIDEO | SDL_INIT_AUDIO;
+	if (SDL_Init(flags) != 0)
 	{
 		SDL_Log("Unable to initialize SDL: %s", SDL_GetError());
 		return false;
@@ -49,7 +75,7 @@ bool Game::Initialize()
 
 	// Create the renderer
 	mRenderer = new Renderer(this);
-	if (!mRenderer->Initialize(1024.0f, 768.0f))
+	if (!mRenderer->Initialize(1024.0f, 768.0f, mHeadless))
 	{
 		SDL_Log("Failed to initialize renderer");
 		delete mRenderer;
@@ -57,9 +83,9 @@ bool Game::Initialize()
 		return false;
 	}
 
-	// Create the audio system
+	// Create the audio system (left uninitialized, and silent, if headless)
 	mAudioSystem = new AudioSystem(this);
-	if (!mAudioSystem->Initialize())
+	if (!mHeadless && !mAudioSystem->Initialize())
 	{
 		SDL_Log("Failed to initialize audio system");
 		mAudioSystem->Shutdown();
@@ -70,6 +96,17 @@ bool Game::Initialize()
 
 	// Create the physics world
 	mPhysWorld = new PhysWorld(this);
+
+	// Create the job system (one worker per spare core)
+	mJobSystem = new JobSystem();
+	mJobSystem->Initialize();
+
+	// Create the event bus, with the event types gameplay uses
+	mEventBus = new EventBus();
+	mEventBus->Register<CollisionEvent>();
+	mEventBus->Register<HitEvent>();
+	mEventBus->Register<SpawnEvent>();
+	mEventBus->Register<DeathEvent>();
 	
 	// Initialize SDL_ttf
 	if (TTF_Init() != 0)
@@ -80,63 +117,145 @@ bool Game::Initialize()
 
 	LoadData();
 
-	mTicksCount = SDL_GetTicks();
+	// So the first frame doesn't interpolate from the origin
+	for (auto actor : mActors)
+	{
+		actor->ComputeWorldTransform();
+		actor->StorePreviousTransform();
+	}
+
+	// Only once the level's boxes are in, so the first tick sees them
+	mPhysWorld->SetThreaded(mThreadedPhysics);
+
+	mFrameCounter = SDL_GetPerformanceCounter();
 	
 	return true;
 }
 
 void Game::RunLoop()
 {
+	bool replaying = mRecording.GetMode() == InputRecording::EReplay;
 	while (mGameState != EQuit)
 	{
+		size_t heapAllocs = MemoryStats::GetHeapAllocs();
+		uint64_t frameStart = Profiler::GetTimeNS();
 		ProcessInput();
 		UpdateGame();
 		GenerateOutput();
+		mFrameHeapAllocs = MemoryStats::GetHeapAllocs() - heapAllocs;
+		Profiler::EndFrame();
+		if (replaying)
+		{
+			// Replays run as fast as possible, and time every frame
+			mRecording.AddFrameTiming((Profiler::GetTimeNS() - frameStart) / 1000000.0f);
+		}
+		else
+		{
+			LimitFrameRate();
+		}
 	}
+	mRecording.Finish();
+}
+
+float Game::RunTicks(int numTicks)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	size_t heapAllocs = MemoryStats::GetHeapAllocs();
+	int ticks = 0;
+	while (ticks < numTicks && mGameState != EQuit)
+	{
+		TickGame(mTickLength);
+		Profiler::EndFrame();
+		ticks++;
+	}
+	float seconds = static_cast<float>(SDL_GetPerformanceCounter() - start) /
+		SDL_GetPerformanceFrequency();
+
+	heapAllocs = MemoryStats::GetHeapAllocs() - heapAllocs;
+
+	float ticksPerSec = seconds > 0.0f ? ticks / seconds : 0.0f;
+	SDL_Log("Ran %d ticks in %.3f s (%.1f ticks/sec)", ticks, seconds,
+		ticksPerSec);
+	SDL_Log("Heap allocations: %d (%.2f per tick)", static_cast<int>(heapAllocs),
+		ticks > 0 ? static_cast<float>(heapAllocs) / ticks : 0.0f);
+	return ticksPerSec;
 }
 
 void Game::ProcessInput()
 {
-	SDL_Event event;
-	while (SDL_PollEvent(&event))
+	PROFILE_SCOPE("Game::ProcessInput");
+	if (mRecording.GetMode() == InputRecording::EReplay)
 	{
-		switch (event.type)
+		// Still let the window be closed during a replay
+		SDL_Event event;
+		while (SDL_PollEvent(&event))
 		{
-			case SDL_QUIT:
+			if (event.type == SDL_QUIT)
+			{
 				mGameState = EQuit;
-				break;
-			// This fires when a key's initially pressed
-			case SDL_KEYDOWN:
-				if (!event.key.repeat)
-				{
-					if (mGameState == EGameplay)
-					{
-						HandleKeyPress(event.key.keysym.sym);
-					}
-					else if (!mUIStack.empty())
+			}
+		}
+		// The input all comes from the recording
+		if (!mRecording.ReadFrame(mInput))
+		{
+			SDL_Log("Replay finished");
+			mGameState = EQuit;
+			return;
+		}
+	}
+	else
+	{
+		mInput.mEvents.clear();
+		SDL_Event event;
+		while (SDL_PollEvent(&event))
+		{
+			InputEvent input;
+			switch (event.type)
+			{
+				case SDL_QUIT:
+					input.mType = InputEvent::EQuit;
+					input.mCode = 0;
+					mInput.mEvents.emplace_back(input);
+					break;
+				// This fires when a key's initially pressed
+				case SDL_KEYDOWN:
+					if (!event.key.repeat)
 					{
-						mUIStack.back()->
-							HandleKeyPress(event.key.keysym.sym);
+						input.mType = InputEvent::EKeyDown;
+						input.mCode = event.key.keysym.sym;
+						mInput.mEvents.emplace_back(input);
 					}
-				}
-				break;
-			case SDL_MOUSEBUTTONDOWN:
-				if (mGameState == EGameplay)
-				{
-					HandleKeyPress(event.button.button);
-				}
-				else if (!mUIStack.empty())
-				{
-					mUIStack.back()->
-						HandleKeyPress(event.button.button);
-				}
-				break;
-			default:
-				break;
+					break;
+				case SDL_MOUSEBUTTONDOWN:
+					input.mType = InputEvent::EMouseButtonDown;
+					input.mCode = event.button.button;
+					mInput.mEvents.emplace_back(input);
+					break;
+				default:
+					break;
+			}
+		}
+		memcpy(mInput.mKeys, SDL_GetKeyboardState(NULL), sizeof(mInput.mKeys));
+		SDL_GetMouseState(&mInput.mMouseX, &mInput.mMouseY);
+	}
+
+	for (const InputEvent& input : mInput.mEvents)
+	{
+		if (input.mType == InputEvent::EQuit)
+		{
+			mGameState = EQuit;
+		}
+		else if (mGameState == EGameplay)
+		{
+			HandleKeyPress(input.mCode);
+		}
+		else if (!mUIStack.empty())
+		{
+			mUIStack.back()->HandleKeyPress(input.mCode);
 		}
 	}
 	
-	const Uint8* state = SDL_GetKeyboardState(NULL);
+	const Uint8* state = mInput.mKeys;
 	if (mGameState == EGameplay)
 	{
 		for (auto actor : mActors)
@@ -195,6 +314,18 @@ void Game::HandleKeyPress(int key)
 		LevelLoader::SaveLevel(this, "Assets/Saved.gplevel");
 		break;
 	}
+	case 'p':
+	{
+		// Capture a couple seconds of profiling
+		Profiler::StartCapture(120, "Profile.json");
+		break;
+	}
+	case 'o':
+	{
+		// Toggle the profiler overlay
+		mHUD->SetShowProfiler(!mHUD->GetShowProfiler());
+		break;
+	}
 	case SDL_BUTTON_LEFT:
 	{
 		break;
@@ -206,35 +337,107 @@ void Game::HandleKeyPress(int key)
 
 void Game::UpdateGame()
 {
-	// Compute delta time
-	// Wait until 16ms has elapsed since last frame
-	while (!SDL_TICKS_PASSED(SDL_GetTicks(), mTicksCount + 16))
-		;
+	PROFILE_SCOPE("Game::UpdateGame");
+	// Compute real time elapsed since last frame
+	Uint64 counter = SDL_GetPerformanceCounter();
+	float frameTime = static_cast<float>(counter - mFrameCounter) /
+		SDL_GetPerformanceFrequency();
+	mFrameCounter = counter;
+	// Clamp long frames (such as from a breakpoint), otherwise
+	// the simulation spends forever catching up
+	if (frameTime > cMaxFrameTime)
+	{
+		frameTime = cMaxFrameTime;
+	}
+
+	if (mRecording.GetMode() == InputRecording::EReplay)
+	{
+		// Step exactly as the recorded session did
+		frameTime = mInput.mFrameTime;
+	}
+	else
+	{
+		mInput.mFrameTime = frameTime;
+		if (mRecording.GetMode() == InputRecording::ERecord)
+		{
+			mRecording.WriteFrame(mInput);
+		}
+	}
 
-	float deltaTime = (SDL_GetTicks() - mTicksCount) / 1000.0f;
-	if (deltaTime > 0.05f)
+	// Run as many fixed ticks as fit in the elapsed time
+	mTickAccumulator += frameTime;
+	while (mTickAccumulator >= mTickLength)
 	{
-		deltaTime = 0.05f;
+		TickGame(mTickLength);
+		mTickAccumulator -= mTickLength;
 	}
-	mTicksCount = SDL_GetTicks();
 
+	// Blend between the last two ticks for rendering
+	// (when paused, just show the latest tick)
+	float alpha = 1.0f;
+	if (mGameState == EGameplay)
+	{
+		alpha = mTickAccumulator / mTickLength;
+	}
+	for (auto actor : mActors)
+	{
+		actor->InterpolateTransform(alpha);
+	}
+	// Cameras look at the blended transforms too
+	ComponentPool::Get<FollowCamera>().ForEach([alpha](Component* comp) {
+		static_cast<FollowCamera*>(comp)->UpdateView(alpha);
+	});
+
+	// Update audio system
+	mAudioSystem->Update(frameTime);
+}
+
+void Game::TickGame(float deltaTime)
+{
+	PROFILE_SCOPE("Game::TickGame");
+	// Contacts and casts from the last tick's step
+	mPhysWorld->BeginTick();
 	if (mGameState == EGameplay)
 	{
 		// Update all actors
 		mUpdatingActors = true;
-		for (auto actor : mActors)
+		if (mUpdateByType)
+		{
+			UpdateActorsByType(deltaTime);
+		}
+		else
+		{
+			for (auto actor : mActors)
+			{
+				actor->Update(deltaTime);
+			}
+		}
+
+		// Run anything job threads couldn't do themselves
+		// (this may add pending actors, so still "updating")
+		for (auto& func : mDeferred)
 		{
-			actor->Update(deltaTime);
+			func();
 		}
+		mDeferred.clear();
 		mUpdatingActors = false;
 
 		// Move any pending actors to mActors
 		for (auto pending : mPendingActors)
 		{
 			pending->ComputeWorldTransform();
-			mActors.emplace_back(pending);
+			pending->StorePreviousTransform();
+			if (pending->IsStatic())
+			{
+				pending->InterpolateTransform(1.0f);
+				pending->SetHandle(mStaticActors.Insert(pending));
+			}
+			else
+			{
+				pending->SetHandle(mActors.Insert(pending));
+			}
 		}
-		mPendingActors.clear();
+		mPendingActors.Clear();
 
 		// Add any dead actors to a temp vector
 		std::vector<Actor*> deadActors;
@@ -243,9 +446,13 @@ void Game::UpdateGame()
 			if (actor->GetState() == Actor::EDead)
 			{
 				deadActors.emplace_back(actor);
+				mEventBus->Publish(DeathEvent{ actor });
 			}
 		}
 
+		// Deliver this tick's events while dead actors still exist
+		mEventBus->Dispatch();
+
 		// Delete dead actors (which removes them from mActors)
 		for (auto actor : deadActors)
 		{
@@ -253,9 +460,6 @@ void Game::UpdateGame()
 		}
 	}
 	
-	// Update audio system
-	mAudioSystem->Update(deltaTime);
-	
 	// Update UI screens
 	for (auto ui : mUIStack)
 	{
@@ -278,13 +482,138 @@ void Game::UpdateGame()
 			++iter;
 		}
 	}
+
+	// Physics catches up with this tick (on its own thread, while
+	// the frame renders)
+	mPhysWorld->EndTick();
 }
 
 void Game::GenerateOutput()
 {
+	PROFILE_SCOPE("Game::GenerateOutput");
 	mRenderer->Draw();
 }
 
+void Game::UpdateActorsByType(float deltaTime)
+{
+	// Save off last tick's transforms, and gather the actors that moved
+	mDirtyActors.clear();
+	mTransformInputs.clear();
+	for (auto actor : mActors)
+	{
+		actor->StorePreviousTransform();
+		if (actor->GetState() == Actor::EActive && actor->GetRecomputeTransform())
+		{
+			TransformBatch::Input input;
+			input.mPosition = actor->GetPosition();
+			input.mScale = actor->GetScale();
+			input.mRotation = actor->GetRotation();
+			mTransformInputs.emplace_back(input);
+			mDirtyActors.emplace_back(actor);
+		}
+	}
+
+	// Compute their world transforms in batches
+	mTransformOutputs.resize(mDirtyActors.size());
+	mJobSystem->ParallelFor(mDirtyActors.size(), 256,
+		[this](size_t begin, size_t end) {
+		TransformBatch::ComposeBatch(&mTransformInputs[begin],
+			&mTransformOutputs[begin], end - begin);
+	});
+	// Then let their components know, on this thread. Some of them
+	// (such as AudioComponent, which calls into FMOD) aren't thread safe.
+	for (size_t i = 0; i < mDirtyActors.size(); i++)
+	{
+		mDirtyActors[i]->SetWorldTransform(mTransformOutputs[i]);
+	}
+
+	// Types with a lower update order go first
+	// (assumes all components of a type share an update order)
+	mPoolOrder = ComponentPool::GetPools();
+	std::stable_sort(mPoolOrder.begin(), mPoolOrder.end(),
+		[](ComponentPool* a, ComponentPool* b) {
+		return a->GetUpdateOrder() < b->GetUpdateOrder();
+	});
+
+	// Components created during the passes wait until next tick,
+	// same as their pending actor would
+	for (auto pool : mPoolOrder)
+	{
+		pool->BeginPass();
+	}
+	auto updateComp = [deltaTime](Component* comp) {
+		if (comp->GetOwner()->GetState() == Actor::EActive)
+		{
+			comp->Update(deltaTime);
+		}
+	};
+	for (auto pool : mPoolOrder)
+	{
+		// A pass finishes before the next type starts, so update
+		// order is respected even when a pass is split across threads
+		if (pool->CanUpdateInParallel())
+		{
+			mJobSystem->ParallelFor(pool->GetNumChunks(), 1,
+				[pool, &updateComp](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+				{
+					pool->ForEachInChunk(i, updateComp);
+				}
+			});
+		}
+		else
+		{
+			pool->ForEach(updateComp);
+		}
+	}
+	for (auto pool : mPoolOrder)
+	{
+		pool->EndPass();
+	}
+
+	for (auto actor : mActors)
+	{
+		if (actor->GetState() == Actor::EActive)
+		{
+			actor->UpdateActor(deltaTime);
+		}
+	}
+}
+
+void Game::Defer(std::function<void()> func)
+{
+	std::lock_guard<std::mutex> lock(mDeferredMutex);
+	mDeferred.emplace_back(std::move(func));
+}
+
+void Game::LimitFrameRate()
+{
+	if (mMaxFrameRate <= 0.0f)
+	{
+		return;
+	}
+	// How long this frame has taken so far
+	float elapsed = static_cast<float>(SDL_GetPerformanceCounter() -
+		mFrameCounter) / SDL_GetPerformanceFrequency();
+	float remaining = 1.0f / mMaxFrameRate - elapsed;
+	// Sleep rather than spin. SDL_Delay only has millisecond
+	// granularity, so undershoot by a millisecond; the tick
+	// accumulator absorbs the difference.
+	Uint32 sleepMS = static_cast<Uint32>(remaining * 1000.0f);
+	if (sleepMS > 1)
+	{
+		SDL_Delay(sleepMS - 1);
+	}
+}
+
+void Game::SetTickRate(float ticksPerSecond)
+{
+	if (ticksPerSecond > 0.0f)
+	{
+		mTickLength = 1.0f / ticksPerSecond;
+	}
+}
+
 void Game::LoadData()
 {
 	// Load English text
@@ -292,26 +621,51 @@ void Game::LoadData()
 	// Create HUD
 	mHUD = new HUD(this);
 
+	// A ball running into a target is a hit
+	mEventBus->Subscribe<CollisionEvent>([this](const CollisionEvent& e) {
+		if (e.mActor->GetType() == Actor::TBallActor &&
+			e.mOther->GetComponentOfType(Component::TTargetComponent))
+		{
+			mEventBus->Publish(HitEvent{ e.mActor, e.mOther, e.mPoint });
+		}
+	});
+	mEventBus->Subscribe<HitEvent>([](const HitEvent& e) {
+		// Other things may publish hits too, so only balls are told
+		if (e.mShooter->GetType() == Actor::TBallActor)
+		{
+			static_cast<BallActor*>(e.mShooter)->HitTarget();
+		}
+	});
+
 	// Load the level from file
 	LevelLoader::LoadLevel(this, "Assets/Level3.gplevel");
 	
 	// Start music
 	mMusicEvent = mAudioSystem->PlayEvent("event:/Music");
 
-	// Enable relative mouse mode for camera look
-	SDL_SetRelativeMouseMode(SDL_TRUE);
-	// Make an initial call to get relative to clear out
-	SDL_GetRelativeMouseState(nullptr, nullptr);
+	if (!mHeadless)
+	{
+		// Enable relative mouse mode for camera look
+		SDL_SetRelativeMouseMode(SDL_TRUE);
+		// Make an initial call to get relative to clear out
+		SDL_GetRelativeMouseState(nullptr, nullptr);
+	}
 }
 
 void Game::UnloadData()
 {
 	// Delete actors
 	// Because ~Actor calls RemoveActor, have to use a different style loop
-	while (!mActors.empty())
+	while (mActors.GetSize() > 0)
+	{
+		delete mActors.GetDense().back();
+	}
+	while (mStaticActors.GetSize() > 0)
 	{
-		delete mActors.back();
+		delete mStaticActors.GetDense().back();
 	}
+	// Now no actors are left in the level's memory
+	mLevelArena.Reset();
 
 	// Clear the UI stack
 	while (!mUIStack.empty())
@@ -345,11 +699,24 @@ void Game::UnloadData()
 	}
 }
 
+bool Game::StartRecording(const std::string& fileName)
+{
+	return mRecording.StartRecording(fileName);
+}
+
+bool Game::StartReplay(const std::string& fileName)
+{
+	return mRecording.StartReplay(fileName);
+}
+
 void Game::Shutdown()
 {
+	mRecording.Finish();
 	UnloadData();
 	TTF_Quit();
 	delete mPhysWorld;
+	delete mJobSystem;
+	delete mEventBus;
 	if (mRenderer)
 	{
 		mRenderer->Shutdown();
@@ -366,32 +733,47 @@ void Game::AddActor(Actor* actor)
 	// If we're updating actors, need to add to pending
 	if (mUpdatingActors)
 	{
-		mPendingActors.emplace_back(actor);
+		actor->SetHandle(mPendingActors.Insert(actor));
 	}
 	else
 	{
-		mActors.emplace_back(actor);
+		actor->SetHandle(mActors.Insert(actor));
 	}
+	mEventBus->Publish(SpawnEvent{ actor });
 }
 
 void Game::RemoveActor(Actor* actor)
 {
-	// Is it in pending actors?
-	auto iter = std::find(mPendingActors.begin(), mPendingActors.end(), actor);
-	if (iter != mPendingActors.end())
+	// The handle could be from either map, so make sure
+	// the slot it refers to really holds this actor
+	const SlotHandle& handle = actor->GetHandle();
+	Actor** pending = mPendingActors.Get(handle);
+	if (pending && *pending == actor)
 	{
-		// Swap to end of vector and pop off (avoid erase copies)
-		std::iter_swap(iter, mPendingActors.end() - 1);
-		mPendingActors.pop_back();
+		mPendingActors.Remove(handle);
 	}
-
-	// Is it in actors?
-	iter = std::find(mActors.begin(), mActors.end(), actor);
-	if (iter != mActors.end())
+	else
 	{
-		// Swap to end of vector and pop off (avoid erase copies)
-		std::iter_swap(iter, mActors.end() - 1);
-		mActors.pop_back();
+		SlotMap<Actor*>& actors = actor->IsStatic() ? mStaticActors : mActors;
+		Actor** active = actors.Get(handle);
+		if (active && *active == actor)
+		{
+			actors.Remove(handle);
+		}
+	}
+}
+
+void Game::SetActorStatic(Actor* actor)
+{
+	// Pending actors are put in the right map once they're added
+	SlotMap<Actor*>& from = actor->IsStatic() ? mActors : mStaticActors;
+	SlotMap<Actor*>& to = actor->IsStatic() ? mStaticActors : mActors;
+	const SlotHandle& handle = actor->GetHandle();
+	Actor** current = from.Get(handle);
+	if (current && *current == actor)
+	{
+		from.Remove(handle);
+		actor->SetHandle(to.Insert(actor));
 	}
 }
 
@@ -10,18 +10,36 @@
 #include <unordered_map>
 #include <string>
 #include <vector>
+#include <functional>
+#include <mutex>
 #include "Math.h"
 #include "SoundEvent.h"
+#include "SlotMap.h"
+#include "Memory.h"
+#include "TransformBatch.h"
+#include "InputRecording.h"
 #include <SDL/SDL_types.h>
 
 class Game
 {
 public:
 	Game();
-	bool Initialize();
+	// Headless runs the simulation without a window, GL, or FMOD
+	bool Initialize(bool headless = false);
 	void RunLoop();
+	// Step numTicks as fast as possible, returns ticks/sec
+	float RunTicks(int numTicks);
 	void Shutdown();
 
+	bool IsHeadless() const { return mHeadless; }
+
+	// Call before Initialize to record this session's input to a file,
+	// or to play one back instead of reading the keyboard and mouse
+	bool StartRecording(const std::string& fileName);
+	bool StartReplay(const std::string& fileName);
+	// Input for the current frame (live or replayed)
+	const InputFrame& GetInput() const { return mInput; }
+
 	void AddActor(class Actor* actor);
 	void RemoveActor(class Actor* actor);
 
@@ -29,6 +47,17 @@ public:
 	class AudioSystem* GetAudioSystem() { return mAudioSystem; }
 	class PhysWorld* GetPhysWorld() { return mPhysWorld; }
 	class HUD* GetHUD() { return mHUD; }
+	class JobSystem* GetJobSystem() { return mJobSystem; }
+	class EventBus* GetEventBus() { return mEventBus; }
+	// Memory for actors created by the level, freed in UnloadData
+	MemoryArena& GetLevelArena() { return mLevelArena; }
+	// Heap allocations made during the last frame
+	size_t GetFrameHeapAllocs() const { return mFrameHeapAllocs; }
+
+	// Run func on the main thread once the actor update is done.
+	// Code running on job threads must use this to spawn actors,
+	// delete components, or touch other shared state.
+	void Defer(std::function<void()> func);
 	
 	// Manage UI stack
 	const std::vector<class UIScreen*>& GetUIStack() { return mUIStack; }
@@ -55,18 +84,44 @@ public:
 
 	class Animation* GetAnimation(const std::string& fileName);
 
-	const std::vector<class Actor*>& GetActors() const { return mActors; }
+	// Actors that update (static actors are kept separately)
+	const std::vector<class Actor*>& GetActors() const { return mActors.GetDense(); }
+	const std::vector<class Actor*>& GetStaticActors() const { return mStaticActors.GetDense(); }
+	// Called by Actor::SetStatic to move the actor between lists
+	void SetActorStatic(class Actor* actor);
 	void SetFollowActor(class FollowActor* actor) { mFollowActor = actor; }
+
+	// Simulation runs at a fixed number of ticks per second
+	float GetTickRate() const { return 1.0f / mTickLength; }
+	void SetTickRate(float ticksPerSecond);
+	// Cap on rendered frames per second (0 means uncapped)
+	float GetMaxFrameRate() const { return mMaxFrameRate; }
+	void SetMaxFrameRate(float fps) { mMaxFrameRate = fps; }
+	// Update components one type at a time (from their ComponentPool)
+	// instead of one actor at a time
+	bool GetUpdateByType() const { return mUpdateByType; }
+	void SetUpdateByType(bool byType) { mUpdateByType = byType; }
+	// Call before Initialize to step physics on its own thread
+	// (see PhysWorld::SetThreaded)
+	void SetThreadedPhysics(bool threaded) { mThreadedPhysics = threaded; }
 private:
 	void ProcessInput();
 	void HandleKeyPress(int key);
 	void UpdateGame();
+	// Advance the simulation by one fixed tick
+	void TickGame(float deltaTime);
+	// Update all actors with one linear pass per component type
+	void UpdateActorsByType(float deltaTime);
 	void GenerateOutput();
+	// Sleep off whatever is left of the frame budget
+	void LimitFrameRate();
 	void LoadData();
 	void UnloadData();
 	
 	// All the actors in the game
-	std::vector<class Actor*> mActors;
+	SlotMap<class Actor*> mActors;
+	// Actors that never move or update (see Actor::SetStatic)
+	SlotMap<class Actor*> mStaticActors;
 	std::vector<class UIScreen*> mUIStack;
 	// Map for fonts
 	std::unordered_map<std::string, class Font*> mFonts;
@@ -78,17 +133,43 @@ private:
 	// Map for text localization
 	std::unordered_map<std::string, std::string> mText;
 	// Any pending actors
-	std::vector<class Actor*> mPendingActors;
+	SlotMap<class Actor*> mPendingActors;
+	// Component pools, sorted by update order each tick
+	std::vector<class ComponentPool*> mPoolOrder;
+	// Actors whose world transform is recomputed this tick,
+	// with the inputs and results of the batch
+	std::vector<class Actor*> mDirtyActors;
+	std::vector<TransformBatch::Input> mTransformInputs;
+	std::vector<Matrix4> mTransformOutputs;
 
 	class Renderer* mRenderer;
 	class AudioSystem* mAudioSystem;
 	class PhysWorld* mPhysWorld;
 	class HUD* mHUD;
+	class JobSystem* mJobSystem;
+	class EventBus* mEventBus;
+	MemoryArena mLevelArena;
+	size_t mFrameHeapAllocs;
+	InputRecording mRecording;
+	InputFrame mInput;
+
+	// Work deferred until after the actor update
+	std::vector<std::function<void()>> mDeferred;
+	std::mutex mDeferredMutex;
 
-	Uint32 mTicksCount;
+	// Performance counter at the start of the current frame
+	Uint64 mFrameCounter;
+	// Length of a simulation tick, in seconds
+	float mTickLength;
+	// Real time not yet consumed by simulation ticks
+	float mTickAccumulator;
+	float mMaxFrameRate;
 	GameState mGameState;
 	// Track if we're updating actors right now
 	bool mUpdatingActors;
+	bool mUpdateByType;
+	bool mThreadedPhysics;
+	bool mHeadless;
 
 	// Game-specific code
 	class FollowActor* mFollowActor;
@@ -16,12 +16,17 @@
 #include <algorithm>
 #include "GBuffer.h"
 #include "TargetComponent.h"
+#include "Font.h"
+#include "Profiler.h"
+#include <cstdio>
 
 HUD::HUD(Game* game)
 	:UIScreen(game)
 	,mRadarRange(2000.0f)
 	,mRadarRadius(92.0f)
 	,mTargetEnemy(false)
+	,mProfilerTimer(0.0f)
+	,mShowProfiler(false)
 {
 	Renderer* r = mGame->GetRenderer();
 	mHealthBar = r->GetTexture("Assets/HealthBar.png");
@@ -34,6 +39,7 @@ HUD::HUD(Game* game)
 
 HUD::~HUD()
 {
+	ClearProfilerLines();
 }
 
 void HUD::Update(float deltaTime)
@@ -42,6 +48,10 @@ void HUD::Update(float deltaTime)
 	
 	UpdateCrosshair(deltaTime);
 	UpdateRadar(deltaTime);
+	if (mShowProfiler)
+	{
+		UpdateProfiler(deltaTime);
+	}
 }
 
 void HUD::Draw(Shader* shader)
@@ -60,6 +70,16 @@ void HUD::Draw(Shader* shader)
 	}
 	// Radar arrow
 	DrawTexture(shader, mRadarArrow, cRadarPos);
+
+	// Profiler lines (top right, left aligned)
+	const Vector2 cProfilerPos(160.0f, 360.0f);
+	for (size_t i = 0; i < mProfilerLines.size(); i++)
+	{
+		Texture* line = mProfilerLines[i];
+		Vector2 pos(cProfilerPos.x + line->GetWidth() * 0.5f,
+			cProfilerPos.y - i * (line->GetHeight() + 2.0f));
+		DrawTexture(shader, line, pos);
+	}
 	
 	//// Health bar
 	//DrawTexture(shader, mHealthBar, Vector2(-350.0f, -350.0f));
@@ -70,16 +90,14 @@ void HUD::Draw(Shader* shader)
 	//DrawTexture(shader, tex, Vector2::Zero, 1.0f, true);
 }
 
-void HUD::AddTargetComponent(TargetComponent* tc)
+SlotHandle HUD::AddTargetComponent(TargetComponent* tc)
 {
-	mTargetComps.emplace_back(tc);
+	return mTargetComps.Insert(tc);
 }
 
 void HUD::RemoveTargetComponent(TargetComponent* tc)
 {
-	auto iter = std::find(mTargetComps.begin(), mTargetComps.end(),
-		tc);
-	mTargetComps.erase(iter);
+	mTargetComps.Remove(tc->GetHUDHandle());
 }
 
 void HUD::UpdateCrosshair(float deltaTime)
@@ -96,13 +114,9 @@ void HUD::UpdateCrosshair(float deltaTime)
 	if (mGame->GetPhysWorld()->SegmentCast(l, info))
 	{
 		// Is this a target?
-		for (auto tc : mTargetComps)
+		if (info.mActor->GetComponentOfType(Component::TTargetComponent))
 		{
-			if (tc->GetOwner() == info.mActor)
-			{
-				mTargetEnemy = true;
-				break;
-			}
+			mTargetEnemy = true;
 		}
 	}
 }
@@ -124,18 +138,27 @@ void HUD::UpdateRadar(float deltaTime)
 	// Make a 2D rotation matrix
 	Matrix3 rotMat = Matrix3::CreateRotation(angle);
 	
-	// Get positions of blips
+	// Get the distances to all targets in one pass (ignoring height)
+	mTargetPositions.Clear();
 	for (auto tc : mTargetComps)
 	{
 		Vector3 targetPos = tc->GetOwner()->GetPosition();
-		Vector2 actorPos2D(targetPos.y, targetPos.x);
-		
-		// Calculate vector between player and target
-		Vector2 playerToTarget = actorPos2D - playerPos2D;
-		
+		mTargetPositions.PushBack(Vector3(targetPos.x, targetPos.y, 0.0f));
+	}
+	mTargetDistSq.resize(mTargetPositions.GetSize());
+	VectorStream::DistanceSq(mTargetPositions,
+		Vector3(playerPos.x, playerPos.y, 0.0f), mTargetDistSq.data());
+
+	// Get positions of blips
+	for (size_t i = 0; i < mTargetPositions.GetSize(); i++)
+	{
 		// See if within range
-		if (playerToTarget.LengthSq() <= (mRadarRange * mRadarRange))
+		if (mTargetDistSq[i] <= (mRadarRange * mRadarRange))
 		{
+			// Calculate vector between player and target
+			Vector2 actorPos2D(mTargetPositions.GetY()[i], mTargetPositions.GetX()[i]);
+			Vector2 playerToTarget = actorPos2D - playerPos2D;
+
 			// Convert playerToTarget into an offset from
 			// the center of the on-screen radar
 			Vector2 blipPos = playerToTarget;
@@ -147,3 +170,75 @@ void HUD::UpdateRadar(float deltaTime)
 		}
 	}
 }
+
+void HUD::SetShowProfiler(bool show)
+{
+	mShowProfiler = show;
+	// Redraw right away when shown
+	mProfilerTimer = 0.0f;
+	if (!mShowProfiler)
+	{
+		ClearProfilerLines();
+	}
+}
+
+void HUD::UpdateProfiler(float deltaTime)
+{
+	// Rendering text is slow, so only redraw a couple times a second
+	mProfilerTimer -= deltaTime;
+	if (mProfilerTimer > 0.0f)
+	{
+		return;
+	}
+	mProfilerTimer = 0.5f;
+
+	ClearProfilerLines();
+	// Most expensive zones first
+	std::vector<Profiler::ZoneStats> stats = Profiler::GetZoneStats();
+	std::sort(stats.begin(), stats.end(),
+		[](const Profiler::ZoneStats& a, const Profiler::ZoneStats& b) {
+		return a.mAverageMS > b.mAverageMS;
+	});
+
+	const size_t cMaxLines = 16;
+	char text[128];
+	auto addLine = [this](const char* line) {
+		Texture* tex = mFont->RenderString(line, Color::White, 16);
+		if (tex)
+		{
+			mProfilerLines.emplace_back(tex);
+		}
+	};
+	// Mesh draws, and their binds once sorted vs. in the order the
+	// meshes were added. Unfiltered is what the same draws would bind
+	// if nothing already bound were skipped.
+	const Renderer* renderer = mGame->GetRenderer();
+	const RenderQueue::Stats& unsorted = renderer->GetUnsortedDrawStats();
+	const RenderQueue::Stats& sorted = renderer->GetDrawStats();
+	const RenderQueue::Stats& unfiltered = renderer->GetUnfilteredDrawStats();
+	snprintf(text, sizeof(text), "Draws: %d, binds: %d (unsorted %d, unfiltered %d)",
+		static_cast<int>(sorted.mDraws), static_cast<int>(sorted.GetBinds()),
+		static_cast<int>(unsorted.GetBinds()), static_cast<int>(unfiltered.GetBinds()));
+	addLine(text);
+	snprintf(text, sizeof(text), "Shader/texture/VAO binds: %d/%d/%d (unsorted %d/%d/%d)",
+		static_cast<int>(sorted.mShaderBinds), static_cast<int>(sorted.mTextureBinds),
+		static_cast<int>(sorted.mVertexArrayBinds), static_cast<int>(unsorted.mShaderBinds),
+		static_cast<int>(unsorted.mTextureBinds), static_cast<int>(unsorted.mVertexArrayBinds));
+	addLine(text);
+	for (size_t i = 0; i < stats.size() && i < cMaxLines; i++)
+	{
+		snprintf(text, sizeof(text), "%s: %.2f ms (%.1f calls)",
+			stats[i].mName, stats[i].mAverageMS, stats[i].mAverageCalls);
+		addLine(text);
+	}
+}
+
+void HUD::ClearProfilerLines()
+{
+	for (auto tex : mProfilerLines)
+	{
+		tex->Unload();
+		delete tex;
+	}
+	mProfilerLines.clear();
+}
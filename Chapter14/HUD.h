@@ -9,6 +9,8 @@
 #pragma once
 #include "UIScreen.h"
 #include <vector>
+#include "SlotMap.h"
+#include "VectorStream.h"
 
 class HUD : public UIScreen
 {
@@ -20,11 +22,17 @@ public:
 	void Update(float deltaTime) override;
 	void Draw(class Shader* shader) override;
 	
-	void AddTargetComponent(class TargetComponent* tc);
+	SlotHandle AddTargetComponent(class TargetComponent* tc);
 	void RemoveTargetComponent(class TargetComponent* tc);
+
+	// Show the profiler's per-zone averages in the corner
+	void SetShowProfiler(bool show);
+	bool GetShowProfiler() const { return mShowProfiler; }
 protected:
 	void UpdateCrosshair(float deltaTime);
 	void UpdateRadar(float deltaTime);
+	void UpdateProfiler(float deltaTime);
+	void ClearProfilerLines();
 	
 	class Texture* mHealthBar;
 	class Texture* mRadar;
@@ -34,12 +42,20 @@ protected:
 	class Texture* mRadarArrow;
 	
 	// All the target components in the game
-	std::vector<class TargetComponent*> mTargetComps;
+	SlotMap<class TargetComponent*> mTargetComps;
 	// 2D offsets of blips relative to radar
 	std::vector<Vector2> mBlips;
+	// Target positions (with z = 0), and their distance from the player
+	VectorStream mTargetPositions;
+	std::vector<float> mTargetDistSq;
 	// Adjust range of radar and radius
 	float mRadarRange;
 	float mRadarRadius;
 	// Whether the crosshair targets an enemy
 	bool mTargetEnemy;
+	// One texture per line of profiler text
+	std::vector<class Texture*> mProfilerLines;
+	// Time until the profiler text is redrawn
+	float mProfilerTimer;
+	bool mShowProfiler;
 };
@@ -0,0 +1,201 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "InputRecording.h"
+#include <SDL/SDL.h>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	const char cMagic[4] = { 'G', 'P', 'I', 'R' };
+	// (Version 1 also stored a random seed)
+	const Uint32 cVersion = 2;
+}
+
+InputRecording::InputRecording()
+	:mMode(ENone)
+	,mReadPos(0)
+{
+	memset(mPrevKeys, 0, sizeof(mPrevKeys));
+}
+
+InputRecording::~InputRecording()
+{
+	Finish();
+}
+
+bool InputRecording::StartRecording(const std::string& fileName)
+{
+	mOutFile.open(fileName, std::ios::out | std::ios::binary);
+	if (!mOutFile.is_open())
+	{
+		SDL_Log("Unable to create input recording %s", fileName.c_str());
+		return false;
+	}
+
+	mMode = ERecord;
+	mFileName = fileName;
+	mOutFile.write(cMagic, sizeof(cMagic));
+	Write(cVersion);
+	return true;
+}
+
+bool InputRecording::StartReplay(const std::string& fileName)
+{
+	std::ifstream file(fileName, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		SDL_Log("Input recording %s not found", fileName.c_str());
+		return false;
+	}
+	std::ifstream::pos_type fileSize = file.tellg();
+	file.seekg(0, std::ios::beg);
+	mData.resize(static_cast<size_t>(fileSize));
+	file.read(mData.data(), static_cast<size_t>(fileSize));
+	mReadPos = 0;
+
+	char magic[4];
+	Uint32 version = 0;
+	if (!Read(magic) || memcmp(magic, cMagic, sizeof(cMagic)) != 0 ||
+		!Read(version) || version != cVersion)
+	{
+		SDL_Log("%s is not a valid input recording", fileName.c_str());
+		mData.clear();
+		return false;
+	}
+
+	mMode = EReplay;
+	mFileName = fileName;
+	return true;
+}
+
+void InputRecording::Finish()
+{
+	if (mMode == ERecord)
+	{
+		mOutFile.close();
+		SDL_Log("Saved input recording to %s", mFileName.c_str());
+	}
+	else if (mMode == EReplay && !mFrameTimings.empty())
+	{
+		// One line per frame, for comparing builds
+		std::string csvName = mFileName + ".csv";
+		std::ofstream csv(csvName);
+		csv << "frame,ms\n";
+		for (size_t i = 0; i < mFrameTimings.size(); i++)
+		{
+			csv << i << "," << mFrameTimings[i] << "\n";
+		}
+
+		// And a summary in the log
+		std::vector<float> sorted = mFrameTimings;
+		std::sort(sorted.begin(), sorted.end());
+		float total = 0.0f;
+		for (float ms : sorted)
+		{
+			total += ms;
+		}
+		SDL_Log("Replayed %d frames: avg %.3f ms, median %.3f ms, 99th %.3f ms, max %.3f ms (saved %s)",
+			static_cast<int>(sorted.size()), total / sorted.size(),
+			sorted[sorted.size() / 2], sorted[sorted.size() * 99 / 100],
+			sorted.back(), csvName.c_str());
+		mFrameTimings.clear();
+	}
+	mMode = ENone;
+}
+
+void InputRecording::WriteFrame(const InputFrame& frame)
+{
+	Write(frame.mFrameTime);
+
+	Write(static_cast<Uint16>(frame.mEvents.size()));
+	for (const InputEvent& e : frame.mEvents)
+	{
+		Write(static_cast<Uint8>(e.mType));
+		Write(static_cast<Sint32>(e.mCode));
+	}
+
+	// Only the keys that changed since last frame
+	Uint16 numChanged = 0;
+	for (int i = 0; i < SDL_NUM_SCANCODES; i++)
+	{
+		if (frame.mKeys[i] != mPrevKeys[i])
+		{
+			numChanged++;
+		}
+	}
+	Write(numChanged);
+	for (int i = 0; i < SDL_NUM_SCANCODES; i++)
+	{
+		if (frame.mKeys[i] != mPrevKeys[i])
+		{
+			Write(static_cast<Uint16>(i));
+			Write(frame.mKeys[i]);
+		}
+	}
+	memcpy(mPrevKeys, frame.mKeys, sizeof(mPrevKeys));
+
+	Write(static_cast<Sint16>(frame.mMouseX));
+	Write(static_cast<Sint16>(frame.mMouseY));
+}
+
+bool InputRecording::ReadFrame(InputFrame& outFrame)
+{
+	if (!Read(outFrame.mFrameTime))
+	{
+		return false;
+	}
+
+	Uint16 numEvents = 0;
+	if (!Read(numEvents))
+	{
+		return false;
+	}
+	outFrame.mEvents.clear();
+	for (Uint16 i = 0; i < numEvents; i++)
+	{
+		Uint8 type = 0;
+		Sint32 code = 0;
+		if (!Read(type) || !Read(code))
+		{
+			return false;
+		}
+		InputEvent e;
+		e.mType = static_cast<InputEvent::Type>(type);
+		e.mCode = code;
+		outFrame.mEvents.emplace_back(e);
+	}
+
+	Uint16 numChanged = 0;
+	if (!Read(numChanged))
+	{
+		return false;
+	}
+	for (Uint16 i = 0; i < numChanged; i++)
+	{
+		Uint16 scancode = 0;
+		Uint8 state = 0;
+		if (!Read(scancode) || !Read(state) || scancode >= SDL_NUM_SCANCODES)
+		{
+			return false;
+		}
+		mPrevKeys[scancode] = state;
+	}
+	memcpy(outFrame.mKeys, mPrevKeys, sizeof(mPrevKeys));
+
+	Sint16 mouseX = 0;
+	Sint16 mouseY = 0;
+	if (!Read(mouseX) || !Read(mouseY))
+	{
+		return false;
+	}
+	outFrame.mMouseX = mouseX;
+	outFrame.mMouseY = mouseY;
+	return true;
+}
@@ -0,0 +1,98 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <SDL/SDL_scancode.h>
+#include <SDL/SDL_types.h>
+
+// An SDL event that Game::ProcessInput cares about
+struct InputEvent
+{
+	enum Type : Uint8
+	{
+		EQuit,
+		EKeyDown,
+		EMouseButtonDown
+	};
+	Type mType;
+	// Key code or mouse button
+	int mCode;
+};
+
+// Everything Game reads as input during one frame
+struct InputFrame
+{
+	// Real time since the previous frame (clamped)
+	float mFrameTime;
+	std::vector<InputEvent> mEvents;
+	Uint8 mKeys[SDL_NUM_SCANCODES];
+	int mMouseX;
+	int mMouseY;
+};
+
+// Writes each frame's input to a compact binary file, or reads
+// a file back so the same session plays out exactly the same way
+class InputRecording
+{
+public:
+	enum Mode
+	{
+		ENone,
+		ERecord,
+		EReplay
+	};
+
+	InputRecording();
+	~InputRecording();
+
+	bool StartRecording(const std::string& fileName);
+	// Loads the whole recording up front, so replay doesn't hit the disk
+	bool StartReplay(const std::string& fileName);
+	// Close the file (recording), or save the frame times (replay)
+	void Finish();
+
+	void WriteFrame(const InputFrame& frame);
+	// Returns false once all frames have been read
+	bool ReadFrame(InputFrame& outFrame);
+
+	// While replaying, remember how long each frame really took
+	void AddFrameTiming(float ms) { mFrameTimings.emplace_back(ms); }
+
+	Mode GetMode() const { return mMode; }
+private:
+	template <typename T>
+	void Write(const T& value)
+	{
+		mOutFile.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+	template <typename T>
+	bool Read(T& value)
+	{
+		if (mReadPos + sizeof(T) > mData.size())
+		{
+			return false;
+		}
+		memcpy(&value, mData.data() + mReadPos, sizeof(T));
+		mReadPos += sizeof(T);
+		return true;
+	}
+
+	Mode mMode;
+	std::string mFileName;
+	// Keyboard state of the previous frame (only changes are stored)
+	Uint8 mPrevKeys[SDL_NUM_SCANCODES];
+
+	std::ofstream mOutFile;
+	std::vector<char> mData;
+	size_t mReadPos;
+	std::vector<float> mFrameTimings;
+};
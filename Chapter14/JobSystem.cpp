@@ -0,0 +1,178 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace
+{
+	// Index of the queue owned by this thread
+	thread_local size_t tQueueIndex = 0;
+}
+
+JobSystem::JobSystem()
+	:mQueuedJobs(0)
+	,mQuit(false)
+{
+}
+
+JobSystem::~JobSystem()
+{
+	Shutdown();
+}
+
+void JobSystem::Initialize(int numWorkers)
+{
+	if (numWorkers < 0)
+	{
+		int hwThreads = static_cast<int>(std::thread::hardware_concurrency());
+		numWorkers = hwThreads > 1 ? hwThreads - 1 : 0;
+	}
+
+	mQuit = false;
+	tQueueIndex = 0;
+	for (int i = 0; i <= numWorkers; i++)
+	{
+		mQueues.emplace_back(new WorkQueue());
+	}
+	for (int i = 1; i <= numWorkers; i++)
+	{
+		mThreads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mQuit = true;
+	}
+	mWakeCondition.notify_all();
+	for (auto& thread : mThreads)
+	{
+		thread.join();
+	}
+	mThreads.clear();
+	mQueues.clear();
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize,
+	const std::function<void(size_t, size_t)>& func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (grainSize == 0)
+	{
+		grainSize = 1;
+	}
+
+	// Not worth queuing if there's no one to share with
+	if (mQueues.size() <= 1 || count <= grainSize)
+	{
+		func(0, count);
+		return;
+	}
+
+	std::atomic<size_t> remaining((count + grainSize - 1) / grainSize);
+	size_t index = tQueueIndex;
+	{
+		std::lock_guard<std::mutex> lock(mQueues[index]->mMutex);
+		for (size_t begin = 0; begin < count; begin += grainSize)
+		{
+			Job job;
+			job.mFunc = &func;
+			job.mBegin = begin;
+			job.mEnd = begin + grainSize < count ? begin + grainSize : count;
+			job.mRemaining = &remaining;
+			mQueues[index]->mJobs.emplace_back(job);
+		}
+		mQueuedJobs += remaining.load();
+	}
+	// Lock so a worker can't miss the wake between its check and wait
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+	}
+	mWakeCondition.notify_all();
+
+	// Help out until our batches are done
+	Job job;
+	while (remaining.load() > 0)
+	{
+		if (GetJob(index, job))
+		{
+			RunJob(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::WorkerLoop(size_t index)
+{
+	tQueueIndex = index;
+	Profiler::SetThreadName("Worker " + std::to_string(index));
+	Job job;
+	while (true)
+	{
+		if (GetJob(index, job))
+		{
+			RunJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mWakeCondition.wait(lock, [this] {
+			return mQuit || mQueuedJobs.load() > 0;
+		});
+		if (mQuit)
+		{
+			break;
+		}
+	}
+}
+
+bool JobSystem::GetJob(size_t index, Job& job)
+{
+	// Newest job from our own queue first (its data is likely in cache)
+	{
+		WorkQueue& queue = *mQueues[index];
+		std::lock_guard<std::mutex> lock(queue.mMutex);
+		if (!queue.mJobs.empty())
+		{
+			job = queue.mJobs.back();
+			queue.mJobs.pop_back();
+			mQueuedJobs--;
+			return true;
+		}
+	}
+
+	// Otherwise steal the oldest job from someone else
+	for (size_t i = 1; i < mQueues.size(); i++)
+	{
+		WorkQueue& queue = *mQueues[(index + i) % mQueues.size()];
+		std::lock_guard<std::mutex> lock(queue.mMutex);
+		if (!queue.mJobs.empty())
+		{
+			job = queue.mJobs.front();
+			queue.mJobs.pop_front();
+			mQueuedJobs--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::RunJob(const Job& job)
+{
+	(*job.mFunc)(job.mBegin, job.mEnd);
+	job.mRemaining->fetch_sub(1);
+}
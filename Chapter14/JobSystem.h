@@ -0,0 +1,70 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool where each thread has its own queue of jobs.
+// A thread takes work from the back of its own queue, and when
+// that runs dry it steals from the front of another thread's queue.
+class JobSystem
+{
+public:
+	JobSystem();
+	~JobSystem();
+
+	// numWorkers of -1 uses one worker per extra hardware thread
+	// (0 workers runs every job on the calling thread)
+	void Initialize(int numWorkers = -1);
+	void Shutdown();
+
+	// Call func(begin, end) over [0, count) in batches of at most
+	// grainSize, and return once every batch is done.
+	// The calling thread works on batches while it waits.
+	void ParallelFor(size_t count, size_t grainSize,
+		const std::function<void(size_t, size_t)>& func);
+
+	// Number of threads that run jobs (workers plus the caller)
+	size_t GetNumThreads() const { return mQueues.size(); }
+private:
+	struct Job
+	{
+		const std::function<void(size_t, size_t)>* mFunc;
+		size_t mBegin;
+		size_t mEnd;
+		// Decremented once the job finishes
+		std::atomic<size_t>* mRemaining;
+	};
+
+	struct WorkQueue
+	{
+		std::mutex mMutex;
+		std::deque<Job> mJobs;
+	};
+
+	void WorkerLoop(size_t index);
+	// Get a job from queue index, or steal one from another queue
+	bool GetJob(size_t index, Job& job);
+	void RunJob(const Job& job);
+
+	std::vector<std::thread> mThreads;
+	// Queue 0 belongs to the thread that called Initialize
+	std::vector<std::unique_ptr<WorkQueue>> mQueues;
+	// Idle workers sleep here until jobs are pushed
+	std::mutex mWakeMutex;
+	std::condition_variable mWakeCondition;
+	std::atomic<size_t> mQueuedJobs;
+	bool mQuit;
+};
@@ -30,6 +30,7 @@
 #include "MirrorCamera.h"
 #include "PointLightComponent.h"
 #include "TargetComponent.h"
+#include "Profiler.h"
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/prettywriter.h>
 
@@ -63,6 +64,7 @@ std::unordered_map<std::string, std::pair<int, ComponentFunc>> LevelLoader::sCom
 
 bool LevelLoader::LoadLevel(Game* game, const std::string& fileName)
 {
+	PROFILE_SCOPE("LevelLoader::LoadLevel");
 	rapidjson::Document doc;
 	if (!LoadJSON(fileName, doc))
 	{
@@ -86,10 +88,13 @@ bool LevelLoader::LoadLevel(Game* game, const std::string& fileName)
 	}
 
 	// Handle any actors
+	// (these live in the level arena until Game::UnloadData)
 	const rapidjson::Value& actors = doc["actors"];
 	if (actors.IsArray())
 	{
+		MemoryArena::SetActive(&game->GetLevelArena());
 		LoadActors(game, actors);
+		MemoryArena::SetActive(nullptr);
 	}
 	return true;
 }
@@ -179,6 +184,13 @@ void LevelLoader::LoadGlobalProperties(Game* game, const rapidjson::Value& inObj
 		JsonHelper::GetVector3(dirObj, "direction", light.mDirection);
 		JsonHelper::GetVector3(dirObj, "color", light.mDiffuseColor);
 	}
+
+	// Get simulation tick rate
+	float tickRate;
+	if (JsonHelper::GetFloat(inObject, "tickRate", tickRate))
+	{
+		game->SetTickRate(tickRate);
+	}
 }
 
 void LevelLoader::LoadActors(Game* game, const rapidjson::Value& inArray)
@@ -208,6 +220,14 @@ void LevelLoader::LoadActors(Game* game, const rapidjson::Value& inArray)
 							LoadComponents(actor, components);
 						}
 					}
+					// Only now that it has its components can the
+					// actor be frozen
+					bool isStatic = false;
+					if (JsonHelper::GetBool(actorObj["properties"], "static", isStatic) &&
+						isStatic)
+					{
+						actor->SetStatic(true);
+					}
 				}
 				else
 				{
@@ -270,12 +290,17 @@ void LevelLoader::SaveGlobalProperties(rapidjson::Document::AllocatorType& alloc
 	JsonHelper::AddVector3(alloc, dirObj, "direction", dirLight.mDirection);
 	JsonHelper::AddVector3(alloc, dirObj, "color", dirLight.mDiffuseColor);
 	inObject.AddMember("directionalLight", dirObj, alloc);
+
+	// Tick rate
+	JsonHelper::AddFloat(alloc, inObject, "tickRate", game->GetTickRate());
 }
 
 void LevelLoader::SaveActors(rapidjson::Document::AllocatorType& alloc, 
 	Game* game, rapidjson::Value& inArray)
 {
-	const auto& actors = game->GetActors();
+	std::vector<Actor*> actors = game->GetActors();
+	actors.insert(actors.end(), game->GetStaticActors().begin(),
+		game->GetStaticActors().end());
 	for (const Actor* actor : actors)
 	{
 		// Make a JSON object
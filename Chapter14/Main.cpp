@@ -7,14 +7,85 @@
 // ----------------------------------------------------------------
 
 #include "Game.h"
+#include "Benchmark.h"
+#include <cstring>
+#include <cstdlib>
 
 int main(int argc, char** argv)
 {
+	// "-bench" runs the microbenchmarks instead of the game
+	// ("-benchcsv" runs the suite that writes CSV, and "-benchscaling"
+	// the broadphase stress scenes, up to 100k boxes unless a bigger
+	// count follows it)
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-bench") == 0)
+		{
+			Benchmark::RunAll();
+			return 0;
+		}
+		else if (strcmp(argv[i], "-benchcsv") == 0)
+		{
+			Benchmark::RunSuite(stdout);
+			return 0;
+		}
+		else if (strcmp(argv[i], "-benchscaling") == 0)
+		{
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+			{
+				Benchmark::RunScaling(stdout, nullptr, strtoul(argv[i + 1], nullptr, 10));
+			}
+			else
+			{
+				Benchmark::RunScaling(stdout);
+			}
+			return 0;
+		}
+	}
+
+	// "-headless N" runs N ticks without a window or audio
+	int headlessTicks = 0;
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(argv[i], "-headless") == 0)
+		{
+			headlessTicks = atoi(argv[i + 1]);
+		}
+	}
+
 	Game game;
-	bool success = game.Initialize();
+	bool success = true;
+	// "-record file" saves the input, "-replay file" plays it back
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (strcmp(argv[i], "-record") == 0)
+		{
+			success = game.StartRecording(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-replay") == 0)
+		{
+			success = game.StartReplay(argv[i + 1]);
+		}
+	}
+	// "-physthread" steps physics on its own thread
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-physthread") == 0)
+		{
+			game.SetThreadedPhysics(true);
+		}
+	}
+	success = success && game.Initialize(headlessTicks > 0);
 	if (success)
 	{
-		game.RunLoop();
+		if (headlessTicks > 0)
+		{
+			game.RunTicks(headlessTicks);
+		}
+		else
+		{
+			game.RunLoop();
+		}
 	}
 	game.Shutdown();
 	return 0;
@@ -54,6 +54,22 @@ Vector2 Vector2::Transform(const Vector2& vec, const Matrix3& mat, float w /*= 1
 }
 
 Vector3 Vector3::Transform(const Vector3& vec, const Matrix4& mat, float w /*= 1.0f*/)
+{
+#ifdef MATH_SIMD
+	__m128 v = _mm_mul_ps(_mm_set1_ps(vec.x), _mm_loadu_ps(mat.mat[0]));
+	v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(vec.y), _mm_loadu_ps(mat.mat[1])));
+	v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(vec.z), _mm_loadu_ps(mat.mat[2])));
+	v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(w), _mm_loadu_ps(mat.mat[3])));
+	// Vector3 is only three floats, so store through a temporary
+	float result[4];
+	_mm_storeu_ps(result, v);
+	return Vector3(result[0], result[1], result[2]);
+#else
+	return TransformScalar(vec, mat, w);
+#endif
+}
+
+Vector3 Vector3::TransformScalar(const Vector3& vec, const Matrix4& mat, float w /*= 1.0f*/)
 {
 	Vector3 retVal;
 	retVal.x = vec.x * mat.mat[0][0] + vec.y * mat.mat[1][0] +
@@ -96,7 +112,162 @@ Vector3 Vector3::Transform(const Vector3& v, const Quaternion& q)
 	return retVal;
 }
 
+#ifdef MATH_SIMD
+namespace
+{
+	// Shuffle lanes x, y from a and z, w from b
+	#define MATH_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+
+	// The 2x2 matrix helpers below hold a 2x2 matrix
+	// in one register, row major
+	// a * b
+	inline __m128 Mat2Mul(__m128 a, __m128 b)
+	{
+		return _mm_add_ps(_mm_mul_ps(a, MATH_SHUFFLE(b, b, 0, 3, 0, 3)),
+			_mm_mul_ps(MATH_SHUFFLE(a, a, 1, 0, 3, 2), MATH_SHUFFLE(b, b, 2, 1, 2, 1)));
+	}
+
+	// adjugate(a) * b
+	inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(MATH_SHUFFLE(a, a, 3, 3, 0, 0), b),
+			_mm_mul_ps(MATH_SHUFFLE(a, a, 1, 1, 2, 2), MATH_SHUFFLE(b, b, 2, 3, 0, 1)));
+	}
+
+	// a * adjugate(b)
+	inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(a, MATH_SHUFFLE(b, b, 3, 0, 3, 0)),
+			_mm_mul_ps(MATH_SHUFFLE(a, a, 1, 0, 3, 2), MATH_SHUFFLE(b, b, 2, 1, 2, 1)));
+	}
+}
+#endif
+
 void Matrix4::Invert()
+{
+#ifdef MATH_SIMD
+	// Blockwise inverse, treating the matrix as four 2x2 matrices
+	//     | A B |
+	// M = | C D |
+	__m128 r0 = _mm_loadu_ps(mat[0]);
+	__m128 r1 = _mm_loadu_ps(mat[1]);
+	__m128 r2 = _mm_loadu_ps(mat[2]);
+	__m128 r3 = _mm_loadu_ps(mat[3]);
+	__m128 A = _mm_movelh_ps(r0, r1);
+	__m128 B = _mm_movehl_ps(r1, r0);
+	__m128 C = _mm_movelh_ps(r2, r3);
+	__m128 D = _mm_movehl_ps(r3, r2);
+
+	// Determinants of the blocks, as (|A|, |B|, |C|, |D|)
+	__m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(MATH_SHUFFLE(r0, r2, 0, 2, 0, 2), MATH_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+		_mm_mul_ps(MATH_SHUFFLE(r0, r2, 1, 3, 1, 3), MATH_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+	__m128 detA = MATH_SHUFFLE(detSub, detSub, 0, 0, 0, 0);
+	__m128 detB = MATH_SHUFFLE(detSub, detSub, 1, 1, 1, 1);
+	__m128 detC = MATH_SHUFFLE(detSub, detSub, 2, 2, 2, 2);
+	__m128 detD = MATH_SHUFFLE(detSub, detSub, 3, 3, 3, 3);
+
+	// The inverse is 1/|M| times the adjugates of
+	// | X Y |
+	// | Z W |
+	__m128 DC = Mat2AdjMul(D, C);
+	__m128 AB = Mat2AdjMul(A, B);
+	__m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, DC));
+	__m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, AB));
+	__m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, AB));
+	__m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, DC));
+
+	// |M| = |A||D| + |B||C| - trace(AB * DC)
+	__m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+	__m128 tr = _mm_mul_ps(AB, MATH_SHUFFLE(DC, DC, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, MATH_SHUFFLE(tr, tr, 1, 0, 3, 2));
+	tr = _mm_add_ps(tr, MATH_SHUFFLE(tr, tr, 2, 3, 0, 1));
+	detM = _mm_sub_ps(detM, tr);
+
+	// Signs of the adjugate, divided by the determinant
+	__m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+	X = _mm_mul_ps(X, invDet);
+	Y = _mm_mul_ps(Y, invDet);
+	Z = _mm_mul_ps(Z, invDet);
+	W = _mm_mul_ps(W, invDet);
+
+	// Take the adjugates and put the blocks back into rows
+	_mm_storeu_ps(mat[0], MATH_SHUFFLE(X, Y, 3, 1, 3, 1));
+	_mm_storeu_ps(mat[1], MATH_SHUFFLE(X, Y, 2, 0, 2, 0));
+	_mm_storeu_ps(mat[2], MATH_SHUFFLE(Z, W, 3, 1, 3, 1));
+	_mm_storeu_ps(mat[3], MATH_SHUFFLE(Z, W, 2, 0, 2, 0));
+#else
+	InvertScalar();
+#endif
+}
+
+void Matrix4::InvertRigid()
+{
+	// The rotation's inverse is its transpose
+	InvertWithScale(1.0f);
+}
+
+void Matrix4::InvertUniformScale()
+{
+	// As InvertRigid, but the transpose is also divided by the scale
+	// twice (once to undo the scale in it, and once to invert it)
+	float scaleSq = mat[0][0] * mat[0][0] + mat[0][1] * mat[0][1] +
+		mat[0][2] * mat[0][2];
+	InvertWithScale(1.0f / scaleSq);
+}
+
+void Matrix4::InvertWithScale(float scale)
+{
+#ifdef MATH_SIMD
+	__m128 s = _mm_set1_ps(scale);
+	__m128 r0 = _mm_loadu_ps(mat[0]);
+	__m128 r1 = _mm_loadu_ps(mat[1]);
+	__m128 r2 = _mm_loadu_ps(mat[2]);
+	__m128 r3 = _mm_setzero_ps();
+	__m128 t = _mm_loadu_ps(mat[3]);
+	// The last column is (0, 0, 0, 1), so this leaves
+	// a zero in the w of each row
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	r0 = _mm_mul_ps(r0, s);
+	r1 = _mm_mul_ps(r1, s);
+	r2 = _mm_mul_ps(r2, s);
+	// The translation is undone after the rotation
+	__m128 trans = _mm_mul_ps(MATH_SHUFFLE(t, t, 0, 0, 0, 0), r0);
+	trans = _mm_add_ps(trans, _mm_mul_ps(MATH_SHUFFLE(t, t, 1, 1, 1, 1), r1));
+	trans = _mm_add_ps(trans, _mm_mul_ps(MATH_SHUFFLE(t, t, 2, 2, 2, 2), r2));
+	trans = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), trans);
+	_mm_storeu_ps(mat[0], r0);
+	_mm_storeu_ps(mat[1], r1);
+	_mm_storeu_ps(mat[2], r2);
+	_mm_storeu_ps(mat[3], trans);
+#else
+	float inv[3][3];
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			inv[i][j] = mat[j][i] * scale;
+		}
+	}
+	Vector3 trans = GetTranslation();
+	for (int i = 0; i < 3; i++)
+	{
+		mat[i][0] = inv[i][0];
+		mat[i][1] = inv[i][1];
+		mat[i][2] = inv[i][2];
+		mat[i][3] = 0.0f;
+	}
+	// The translation is undone after the rotation
+	for (int j = 0; j < 3; j++)
+	{
+		mat[3][j] = -(trans.x * inv[0][j] + trans.y * inv[1][j] +
+			trans.z * inv[2][j]);
+	}
+	mat[3][3] = 1.0f;
+#endif
+}
+
+void Matrix4::InvertScalar()
 {
 	// Thanks slow math
 	// This is a really janky way to unroll everything...
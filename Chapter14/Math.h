@@ -12,6 +12,14 @@
 #include <memory.h>
 #include <limits>
 
+// Matrix4 and Quaternion use SSE when it's always available (x64, or
+// x86 with SSE2 enabled). Define MATH_NO_SIMD to use scalar code only.
+#if !defined(MATH_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MATH_SIMD 1
+#include <xmmintrin.h>
+#endif
+
 namespace Math
 {
 	const float Pi = 3.1415926535f;
@@ -400,6 +408,8 @@ public:
 	}
 
 	static Vector3 Transform(const Vector3& vec, const class Matrix4& mat, float w = 1.0f);
+	// Same as Transform, but never uses SIMD
+	static Vector3 TransformScalar(const Vector3& vec, const class Matrix4& mat, float w = 1.0f);
 	// This will transform the vector and renormalize the w component
 	static Vector3 TransformWithPerspDiv(const Vector3& vec, const class Matrix4& mat, float w = 1.0f);
 
@@ -555,6 +565,8 @@ public:
 class Matrix4
 {
 public:
+	// Not over-aligned: actors and components come from pools that only
+	// promise alignof(std::max_align_t), so SSE code loads rows unaligned
 	float mat[4][4];
 
 	Matrix4()
@@ -575,6 +587,26 @@ public:
 
 	// Matrix multiplication (a * b)
 	friend Matrix4 operator*(const Matrix4& a, const Matrix4& b)
+	{
+#ifdef MATH_SIMD
+		// Each row of the result is a's row times the rows of b
+		__m128 b0 = _mm_loadu_ps(b.mat[0]);
+		__m128 b1 = _mm_loadu_ps(b.mat[1]);
+		__m128 b2 = _mm_loadu_ps(b.mat[2]);
+		__m128 b3 = _mm_loadu_ps(b.mat[3]);
+		Matrix4 retVal(NoInit);
+		_mm_storeu_ps(retVal.mat[0], MultiplyRow(_mm_loadu_ps(a.mat[0]), b0, b1, b2, b3));
+		_mm_storeu_ps(retVal.mat[1], MultiplyRow(_mm_loadu_ps(a.mat[1]), b0, b1, b2, b3));
+		_mm_storeu_ps(retVal.mat[2], MultiplyRow(_mm_loadu_ps(a.mat[2]), b0, b1, b2, b3));
+		_mm_storeu_ps(retVal.mat[3], MultiplyRow(_mm_loadu_ps(a.mat[3]), b0, b1, b2, b3));
+		return retVal;
+#else
+		return MultiplyScalar(a, b);
+#endif
+	}
+
+	// Matrix multiplication (a * b), one float at a time
+	static Matrix4 MultiplyScalar(const Matrix4& a, const Matrix4& b)
 	{
 		Matrix4 retVal;
 		// row 0
@@ -686,8 +718,50 @@ public:
 		return *this;
 	}
 
-	// Invert the matrix - super slow
+	// Invert any invertible matrix (with SSE, when available)
 	void Invert();
+	// Same as Invert, with the original cofactor expansion - super slow
+	void InvertScalar();
+	// Cheaper inverses for more limited matrices. Both assume the
+	// last column is (0, 0, 0, 1), as it is for world and view
+	// transforms, but not for projections.
+	// Only rotation and translation (such as a view matrix)
+	void InvertRigid();
+	// Rotation, translation, and the same scale on every axis
+	void InvertUniformScale();
+
+	// Swap rows and columns
+	void Transpose()
+	{
+#ifdef MATH_SIMD
+		__m128 r0 = _mm_loadu_ps(mat[0]);
+		__m128 r1 = _mm_loadu_ps(mat[1]);
+		__m128 r2 = _mm_loadu_ps(mat[2]);
+		__m128 r3 = _mm_loadu_ps(mat[3]);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(mat[0], r0);
+		_mm_storeu_ps(mat[1], r1);
+		_mm_storeu_ps(mat[2], r2);
+		_mm_storeu_ps(mat[3], r3);
+#else
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = i + 1; j < 4; j++)
+			{
+				float temp = mat[i][j];
+				mat[i][j] = mat[j][i];
+				mat[j][i] = temp;
+			}
+		}
+#endif
+	}
+
+	static Matrix4 Transpose(const Matrix4& m)
+	{
+		Matrix4 retVal = m;
+		retVal.Transpose();
+		return retVal;
+	}
 
 	// Get the translation component of the matrix
 	Vector3 GetTranslation() const
@@ -861,6 +935,25 @@ public:
 	}
 	
 	static const Matrix4 Identity;
+private:
+	// Transpose the rotation part times scale, and invert the translation
+	void InvertWithScale(float scale);
+
+	// For results that are about to be overwritten anyway
+	enum NoInitTag { NoInit };
+	explicit Matrix4(NoInitTag) { }
+
+#ifdef MATH_SIMD
+	// row * b, where b0-b3 are the rows of b
+	static __m128 MultiplyRow(__m128 row, __m128 b0, __m128 b1, __m128 b2, __m128 b3)
+	{
+		__m128 r = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+		return r;
+	}
+#endif
 };
 
 // (Unit) Quaternion
@@ -924,11 +1017,15 @@ public:
 
 	void Normalize()
 	{
+#ifdef MATH_SIMD
+		Store(NormalizeSIMD(Load(*this)));
+#else
 		float length = Length();
 		x /= length;
 		y /= length;
 		z /= length;
 		w /= length;
+#endif
 	}
 
 	// Normalize the provided quaternion
@@ -942,6 +1039,14 @@ public:
 	// Linear interpolation
 	static Quaternion Lerp(const Quaternion& a, const Quaternion& b, float f)
 	{
+#ifdef MATH_SIMD
+		__m128 va = Load(a);
+		__m128 blend = _mm_add_ps(va,
+			_mm_mul_ps(_mm_set1_ps(f), _mm_sub_ps(Load(b), va)));
+		Quaternion retVal;
+		retVal.Store(NormalizeSIMD(blend));
+		return retVal;
+#else
 		Quaternion retVal;
 		retVal.x = Math::Lerp(a.x, b.x, f);
 		retVal.y = Math::Lerp(a.y, b.y, f);
@@ -949,6 +1054,7 @@ public:
 		retVal.w = Math::Lerp(a.w, b.w, f);
 		retVal.Normalize();
 		return retVal;
+#endif
 	}
 
 	static float Dot(const Quaternion& a, const Quaternion& b)
@@ -959,6 +1065,92 @@ public:
 	// Spherical Linear Interpolation
 	static Quaternion Slerp(const Quaternion& a, const Quaternion& b, float f)
 	{
+#ifdef MATH_SIMD
+		float scale0, scale1;
+		SlerpScales(a, b, f, scale0, scale1);
+		// Blend all four components at once
+		__m128 blend = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(scale0), Load(a)),
+			_mm_mul_ps(_mm_set1_ps(scale1), Load(b)));
+		Quaternion retVal;
+		retVal.Store(NormalizeSIMD(blend));
+		return retVal;
+#else
+		return SlerpScalar(a, b, f);
+#endif
+	}
+
+	// Same as Slerp, but never uses SIMD
+	static Quaternion SlerpScalar(const Quaternion& a, const Quaternion& b, float f)
+	{
+		float scale0, scale1;
+		SlerpScales(a, b, f, scale0, scale1);
+
+		Quaternion retVal;
+		retVal.x = scale0 * a.x + scale1 * b.x;
+		retVal.y = scale0 * a.y + scale1 * b.y;
+		retVal.z = scale0 * a.z + scale1 * b.z;
+		retVal.w = scale0 * a.w + scale1 * b.w;
+		float length = retVal.Length();
+		retVal.x /= length;
+		retVal.y /= length;
+		retVal.z /= length;
+		retVal.w /= length;
+		return retVal;
+	}
+
+	// Concatenate
+	// Rotate by q FOLLOWED BY p
+	static Quaternion Concatenate(const Quaternion& q, const Quaternion& p)
+	{
+#ifdef MATH_SIMD
+		// The product p * q, as four multiplies of q (shuffled
+		// and with signs flipped) by each component of p
+		__m128 vq = Load(q);
+		__m128 r = _mm_mul_ps(_mm_set1_ps(p.w), vq);
+		__m128 t = _mm_shuffle_ps(vq, vq, _MM_SHUFFLE(0, 1, 2, 3));
+		t = _mm_mul_ps(t, _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(p.x), t));
+		t = _mm_shuffle_ps(vq, vq, _MM_SHUFFLE(1, 0, 3, 2));
+		t = _mm_mul_ps(t, _mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(p.y), t));
+		t = _mm_shuffle_ps(vq, vq, _MM_SHUFFLE(2, 3, 0, 1));
+		t = _mm_mul_ps(t, _mm_setr_ps(-1.0f, 1.0f, 1.0f, -1.0f));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(p.z), t));
+		Quaternion retVal;
+		retVal.Store(r);
+		return retVal;
+#else
+		return ConcatenateScalar(q, p);
+#endif
+	}
+
+	// Same as Concatenate, but never uses SIMD
+	static Quaternion ConcatenateScalar(const Quaternion& q, const Quaternion& p)
+	{
+		Quaternion retVal;
+
+		// Vector component is:
+		// ps * qv + qs * pv + pv x qv
+		Vector3 qv(q.x, q.y, q.z);
+		Vector3 pv(p.x, p.y, p.z);
+		Vector3 newVec = p.w * qv + q.w * pv + Vector3::Cross(pv, qv);
+		retVal.x = newVec.x;
+		retVal.y = newVec.y;
+		retVal.z = newVec.z;
+
+		// Scalar component is:
+		// ps * qs - pv . qv
+		retVal.w = p.w * q.w - Vector3::Dot(pv, qv);
+
+		return retVal;
+	}
+
+	static const Quaternion Identity;
+private:
+	// Weights of a and b for Slerp
+	static void SlerpScales(const Quaternion& a, const Quaternion& b, float f,
+		float& outScale0, float& outScale1)
+	{
 		float rawCosm = Quaternion::Dot(a, b);
 
 		float cosom = -rawCosm;
@@ -988,39 +1180,30 @@ public:
 		{
 			scale1 = -scale1;
 		}
-
-		Quaternion retVal;
-		retVal.x = scale0 * a.x + scale1 * b.x;
-		retVal.y = scale0 * a.y + scale1 * b.y;
-		retVal.z = scale0 * a.z + scale1 * b.z;
-		retVal.w = scale0 * a.w + scale1 * b.w;
-		retVal.Normalize();
-		return retVal;
+		outScale0 = scale0;
+		outScale1 = scale1;
 	}
 
-	// Concatenate
-	// Rotate by q FOLLOWED BY p
-	static Quaternion Concatenate(const Quaternion& q, const Quaternion& p)
+#ifdef MATH_SIMD
+	static __m128 Load(const Quaternion& q)
 	{
-		Quaternion retVal;
-
-		// Vector component is:
-		// ps * qv + qs * pv + pv x qv
-		Vector3 qv(q.x, q.y, q.z);
-		Vector3 pv(p.x, p.y, p.z);
-		Vector3 newVec = p.w * qv + q.w * pv + Vector3::Cross(pv, qv);
-		retVal.x = newVec.x;
-		retVal.y = newVec.y;
-		retVal.z = newVec.z;
-
-		// Scalar component is:
-		// ps * qs - pv . qv
-		retVal.w = p.w * q.w - Vector3::Dot(pv, qv);
+		return _mm_loadu_ps(&q.x);
+	}
 
-		return retVal;
+	void Store(__m128 v)
+	{
+		_mm_storeu_ps(&x, v);
 	}
 
-	static const Quaternion Identity;
+	static __m128 NormalizeSIMD(__m128 v)
+	{
+		// Sum the squares into every lane, then divide by the length
+		__m128 sq = _mm_mul_ps(v, v);
+		sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+		sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_div_ps(v, _mm_sqrt_ps(sq));
+	}
+#endif
 };
 
 namespace Color
@@ -0,0 +1,204 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "Memory.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<size_t> gHeapAllocs(0);
+	std::atomic<size_t> gHeapBytes(0);
+}
+
+// Replace the global operator new/delete to count heap allocations
+void* operator new(size_t size)
+{
+	gHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+	gHeapBytes.fetch_add(size, std::memory_order_relaxed);
+	void* ptr = std::malloc(size > 0 ? size : 1);
+	if (!ptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+std::atomic<size_t> MemoryStats::sPoolAllocs(0);
+std::atomic<size_t> MemoryStats::sArenaAllocs(0);
+
+size_t MemoryStats::GetHeapAllocs()
+{
+	return gHeapAllocs.load(std::memory_order_relaxed);
+}
+
+size_t MemoryStats::GetHeapBytes()
+{
+	return gHeapBytes.load(std::memory_order_relaxed);
+}
+
+MemoryArena* MemoryArena::sActive = nullptr;
+
+MemoryArena::MemoryArena(size_t blockSize)
+	:mBlockUsed(0)
+	,mBlockSize(blockSize)
+	,mBytesUsed(0)
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+	Reset();
+}
+
+void* MemoryArena::Allocate(size_t size, size_t align)
+{
+	// Round up to the alignment within the current block
+	size_t offset = (mBlockUsed + align - 1) / align * align;
+	if (mBlocks.empty() || offset + size > mBlocks.back().mSize)
+	{
+		// Start a new block (bigger than usual if need be)
+		Block block;
+		block.mSize = size > mBlockSize ? size : mBlockSize;
+		block.mData = static_cast<char*>(::operator new(block.mSize));
+		mBlocks.emplace_back(block);
+		offset = 0;
+	}
+
+	mBlockUsed = offset + size;
+	mBytesUsed += size;
+	MemoryStats::sArenaAllocs.fetch_add(1, std::memory_order_relaxed);
+	return mBlocks.back().mData + offset;
+}
+
+void MemoryArena::Reset()
+{
+	for (auto& block : mBlocks)
+	{
+		::operator delete(block.mData);
+	}
+	mBlocks.clear();
+	mBlockUsed = 0;
+	mBytesUsed = 0;
+}
+
+bool MemoryArena::Owns(const void* ptr) const
+{
+	const char* p = static_cast<const char*>(ptr);
+	for (const auto& block : mBlocks)
+	{
+		if (p >= block.mData && p < block.mData + block.mSize)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+PoolAllocator::PoolAllocator(size_t objectSize, size_t objectsPerChunk)
+	:mTypeSize(objectSize)
+	,mObjectSize(objectSize)
+	,mObjectsPerChunk(objectsPerChunk)
+	,mNumLive(0)
+{
+	// Keep every slot aligned like the heap would
+	size_t align = alignof(std::max_align_t);
+	mObjectSize = (mObjectSize + align - 1) / align * align;
+}
+
+PoolAllocator::~PoolAllocator()
+{
+	for (char* chunk : mChunks)
+	{
+		::operator delete(chunk);
+	}
+}
+
+void* PoolAllocator::New(size_t size)
+{
+	if (size != mTypeSize)
+	{
+		return ::operator new(size);
+	}
+
+	MemoryArena* arena = MemoryArena::GetActive();
+	if (arena)
+	{
+		return arena->Allocate(size);
+	}
+
+	if (mFreeSlots.empty())
+	{
+		char* chunk = static_cast<char*>(::operator new(mObjectsPerChunk * mObjectSize));
+		mChunks.emplace_back(chunk);
+		// Push in reverse so the lowest address is handed out first
+		for (size_t i = mObjectsPerChunk; i > 0; i--)
+		{
+			mFreeSlots.emplace_back(chunk + (i - 1) * mObjectSize);
+		}
+	}
+
+	void* ptr = mFreeSlots.back();
+	mFreeSlots.pop_back();
+	mNumLive++;
+	MemoryStats::sPoolAllocs.fetch_add(1, std::memory_order_relaxed);
+	return ptr;
+}
+
+void PoolAllocator::Delete(void* ptr, size_t size)
+{
+	if (size != mTypeSize)
+	{
+		::operator delete(ptr);
+	}
+	else if (Owns(ptr))
+	{
+		mFreeSlots.emplace_back(ptr);
+		mNumLive--;
+	}
+	// Otherwise it's in an arena, which frees it on Reset
+}
+
+bool PoolAllocator::Owns(const void* ptr) const
+{
+	const char* p = static_cast<const char*>(ptr);
+	for (const char* chunk : mChunks)
+	{
+		if (p >= chunk && p < chunk + mObjectsPerChunk * mObjectSize)
+		{
+			return true;
+		}
+	}
+	return false;
+}
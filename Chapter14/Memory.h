@@ -0,0 +1,107 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <atomic>
+
+// Counts allocations, so we can check the game doesn't
+// hit the heap every frame once it's up and running
+class MemoryStats
+{
+public:
+	// Calls to the global operator new (from any thread)
+	static size_t GetHeapAllocs();
+	static size_t GetHeapBytes();
+	// Objects handed out by pools and arenas
+	static size_t GetPoolAllocs() { return sPoolAllocs.load(std::memory_order_relaxed); }
+	static size_t GetArenaAllocs() { return sArenaAllocs.load(std::memory_order_relaxed); }
+
+	// Atomic like the heap counts, so reading the stats never races.
+	// (PoolAllocator and MemoryArena themselves aren't thread safe, so
+	// each one must only be used from one thread.)
+	static std::atomic<size_t> sPoolAllocs;
+	static std::atomic<size_t> sArenaAllocs;
+};
+
+// Hands out memory by bumping a pointer, and frees everything at once
+// on Reset. Objects in an arena can still be deleted (their destructor
+// runs as usual) but the memory only comes back on Reset.
+class MemoryArena
+{
+public:
+	MemoryArena(size_t blockSize = 256 * 1024);
+	~MemoryArena();
+
+	void* Allocate(size_t size, size_t align = alignof(std::max_align_t));
+	// Free every block (anything still in the arena must be dead by now)
+	void Reset();
+	bool Owns(const void* ptr) const;
+	size_t GetBytesUsed() const { return mBytesUsed; }
+
+	// Pooled actor types allocate from the active arena, if there is one
+	// (LevelLoader makes the level arena active while it loads)
+	static MemoryArena* GetActive() { return sActive; }
+	static void SetActive(MemoryArena* arena) { sActive = arena; }
+private:
+	struct Block
+	{
+		char* mData;
+		size_t mSize;
+	};
+	std::vector<Block> mBlocks;
+	// Bytes used in the last block
+	size_t mBlockUsed;
+	size_t mBlockSize;
+	size_t mBytesUsed;
+
+	static MemoryArena* sActive;
+};
+
+// Fixed-size slots handed out from a free list. Memory is allocated in
+// chunks of slots, and kept for reuse until the pool is destroyed.
+class PoolAllocator
+{
+public:
+	PoolAllocator(size_t objectSize, size_t objectsPerChunk = 64);
+	~PoolAllocator();
+
+	// Get the pool for a type (created on first use)
+	template <typename T>
+	static PoolAllocator& Get()
+	{
+		static PoolAllocator pool(sizeof(T));
+		return pool;
+	}
+
+	// Called from the operator new/delete of the pool's type. Uses the
+	// active arena if there is one, and the regular heap for derived
+	// types (which have a different size) without their own pool.
+	void* New(size_t size);
+	void Delete(void* ptr, size_t size);
+
+	size_t GetNumLive() const { return mNumLive; }
+private:
+	bool Owns(const void* ptr) const;
+
+	std::vector<char*> mChunks;
+	std::vector<void*> mFreeSlots;
+	size_t mTypeSize;
+	size_t mObjectSize;
+	size_t mObjectsPerChunk;
+	size_t mNumLive;
+};
+
+// Add to the class declaration of each concrete actor type,
+// so it is allocated from its own PoolAllocator
+#define ACTOR_POOL(T) \
+	static void* operator new(size_t size) \
+	{ return PoolAllocator::Get<T>().New(size); } \
+	static void operator delete(void* ptr, size_t size) \
+	{ PoolAllocator::Get<T>().Delete(ptr, size); }
@@ -212,10 +212,13 @@ bool Mesh::Load(const std::string& fileName, Renderer* renderer)
 		indices.emplace_back(ind[2].GetUint());
 	}
 
-	// Now create a vertex array
+	// Now create a vertex array (unless there's no GL context)
 	unsigned int numVerts = static_cast<unsigned>(vertices.size()) / vertSize;
-	mVertexArray = new VertexArray(vertices.data(), numVerts,
-		layout, indices.data(), static_cast<unsigned>(indices.size()));
+	if (!renderer->IsHeadless())
+	{
+		mVertexArray = new VertexArray(vertices.data(), numVerts,
+			layout, indices.data(), static_cast<unsigned>(indices.size()));
+	}
 
 	// Save the binary mesh
 	SaveBinary(fileName + ".bin", vertices.data(),
@@ -343,9 +346,12 @@ bool Mesh::LoadBinary(const std::string& fileName, Renderer* renderer)
 		inFile.read(reinterpret_cast<char*>(indices), 
 			header.mNumIndices * sizeof(uint32_t));
 
-		// Now create the vertex array
-		mVertexArray = new VertexArray(verts, header.mNumVerts,
-			header.mLayout, indices, header.mNumIndices);
+		// Now create the vertex array (unless there's no GL context)
+		if (!renderer->IsHeadless())
+		{
+			mVertexArray = new VertexArray(verts, header.mNumVerts,
+				header.mLayout, indices, header.mNumIndices);
+		}
 
 		// Cleanup memory
 		delete[] verts;
@@ -16,6 +16,13 @@
 #include "VertexArray.h"
 #include "LevelLoader.h"
 
+namespace
+{
+	const Shader::Uniform<Matrix4> cWorldTransform =
+		Shader::GetUniform<Matrix4>("uWorldTransform");
+	const Shader::Uniform<float> cSpecPower = Shader::GetUniform<float>("uSpecPower");
+}
+
 MeshComponent::MeshComponent(Actor* owner, bool isSkeletal)
 	:Component(owner)
 	,mMesh(nullptr)
@@ -23,7 +30,7 @@ MeshComponent::MeshComponent(Actor* owner, bool isSkeletal)
 	,mVisible(true)
 	,mIsSkeletal(isSkeletal)
 {
-	mOwner->GetGame()->GetRenderer()->AddMeshComp(this);
+	mRenderHandle = mOwner->GetGame()->GetRenderer()->AddMeshComp(this);
 }
 
 MeshComponent::~MeshComponent()
@@ -35,11 +42,7 @@ void MeshComponent::Draw(Shader* shader)
 {
 	if (mMesh)
 	{
-		// Set the world transform
-		shader->SetMatrixUniform("uWorldTransform", 
-			mOwner->GetWorldTransform());
-		// Set specular power
-		shader->SetFloatUniform("uSpecPower", mMesh->GetSpecPower());
+		SetDrawUniforms(shader);
 		// Set the active texture
 		Texture* t = mMesh->GetTexture(mTextureIndex);
 		if (t)
@@ -54,6 +57,19 @@ void MeshComponent::Draw(Shader* shader)
 	}
 }
 
+void MeshComponent::SetDrawUniforms(Shader* shader)
+{
+	// Set the world transform
+	shader->SetUniform(cWorldTransform, mOwner->GetRenderTransform());
+	// Set specular power
+	shader->SetUniform(cSpecPower, mMesh->GetSpecPower());
+}
+
+Texture* MeshComponent::GetTexture() const
+{
+	return mMesh ? mMesh->GetTexture(mTextureIndex) : nullptr;
+}
+
 void MeshComponent::LoadProperties(const rapidjson::Value& inObj)
 {
 	Component::LoadProperties(inObj);
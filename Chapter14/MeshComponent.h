@@ -8,6 +8,7 @@
 
 #pragma once
 #include "Component.h"
+#include "SlotMap.h"
 
 class MeshComponent : public Component
 {
@@ -16,16 +17,24 @@ public:
 	~MeshComponent();
 	// Draw this mesh component
 	virtual void Draw(class Shader* shader);
+	// Sets this component's uniforms (the rest of Draw, without
+	// binding the texture or vertex array)
+	virtual void SetDrawUniforms(class Shader* shader);
 	// Set the mesh/texture index used by mesh component
 	virtual void SetMesh(class Mesh* mesh) { mMesh = mesh; }
 	void SetTextureIndex(size_t index) { mTextureIndex = index; }
+	class Mesh* GetMesh() const { return mMesh; }
+	// The texture Draw uses (may be null)
+	class Texture* GetTexture() const;
 
 	void SetVisible(bool visible) { mVisible = visible; }
 	bool GetVisible() const { return mVisible; }
 
 	bool GetIsSkeletal() const { return mIsSkeletal; }
+	const SlotHandle& GetRenderHandle() const { return mRenderHandle; }
 
 	TypeID GetType() const override { return TMeshComponent; }
+	COMPONENT_POOL(MeshComponent)
 
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
@@ -35,4 +44,6 @@ protected:
 	size_t mTextureIndex;
 	bool mVisible;
 	bool mIsSkeletal;
+	// Handle from Renderer::AddMeshComp
+	SlotHandle mRenderHandle;
 };
\ No newline at end of file
@@ -23,6 +23,7 @@ public:
 	void SetTargetDist(float dist) { mTargetDist = dist; }
 
 	TypeID GetType() const override { return TMirrorCamera; }
+	COMPONENT_POOL(MirrorCamera)
 
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
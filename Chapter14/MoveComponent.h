@@ -15,6 +15,7 @@ public:
 	// Lower update order to update first
 	MoveComponent(class Actor* owner, int updateOrder = 10);
 	void Update(float deltaTime) override;
+	bool CanUpdateInParallel() const override { return true; }
 	
 	float GetAngularSpeed() const { return mAngularSpeed; }
 	float GetForwardSpeed() const { return mForwardSpeed; }
@@ -24,6 +25,7 @@ public:
 	void SetStrafeSpeed(float speed) { mStrafeSpeed = speed; }
 
 	TypeID GetType() const override { return TMoveComponent; }
+	COMPONENT_POOL(MoveComponent)
 
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
@@ -9,14 +9,229 @@
 #include "PhysWorld.h"
 #include <algorithm>
 #include "BoxComponent.h"
-#include <SDL/SDL.h>
+#include "Actor.h"
+#include "Profiler.h"
+
+namespace
+{
+	// How far a box can move before its leaf in the tree is reinserted
+	const float cTreeMargin = 10.0f;
+	// About the size of Chapter14's walls and targets
+	const float cDefaultCellSize = 250.0f;
+}
 
 PhysWorld::PhysWorld(Game* game)
 	:mGame(game)
+	,mTree(cTreeMargin)
+	,mSweepAndPrune(true)
+	,mSpatialHash(cDefaultCellSize)
+	,mStaticChanged(false)
+	,mStepPending(false)
+	,mStepDone(false)
+	,mQuit(false)
+	,mThreaded(false)
+	,mFindContacts(false)
+{
+}
+
+PhysWorld::~PhysWorld()
+{
+	SetThreaded(false);
+}
+
+void PhysWorld::SetThreaded(bool threaded)
+{
+	if (threaded == mThreaded)
+	{
+		return;
+	}
+
+	if (threaded)
+	{
+		mQuit = false;
+		mStepThread = std::thread(&PhysWorld::StepLoop, this);
+	}
+	else
+	{
+		WaitForStep();
+		{
+			std::lock_guard<std::mutex> lock(mStepMutex);
+			mQuit = true;
+		}
+		mStepCondition.notify_all();
+		mStepThread.join();
+	}
+	mThreaded = threaded;
+}
+
+void PhysWorld::SetContactEvents(bool enabled)
+{
+	WaitForStep();
+	mFindContacts = enabled;
+	// Contacts from before they were turned off would be out of date
+	mContacts.clear();
+}
+
+void PhysWorld::BeginTick()
+{
+	WaitForStep();
+	if (mStepDone)
+	{
+		std::swap(mContactEvents, mStepContacts);
+		std::swap(mCastResults, mStepCastResults);
+		mStepDone = false;
+	}
+}
+
+void PhysWorld::EndTick()
+{
+	WaitForStep();
+	// Hand this tick's boxes and casts to the step. UpdateBox can
+	// keep filling the other buffers while a threaded step runs.
+	std::swap(mBoxWrites, mStepBoxes);
+	mBoxWrites.resize(mStepBoxes.size(), BoxWrite{ AABB(Vector3::Zero, Vector3::Zero),
+		SlotHandle(), false });
+	std::swap(mCastQueue, mStepCasts);
+	mCastQueue.clear();
+
+	if (!mThreaded)
+	{
+		RunStep();
+		mStepDone = true;
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mStepMutex);
+		mStepPending = true;
+	}
+	mStepCondition.notify_all();
+}
+
+size_t PhysWorld::QueueSegmentCast(const LineSegment& l)
 {
+	std::lock_guard<std::mutex> lock(mCastMutex);
+	mCastQueue.emplace_back(l);
+	return mCastQueue.size() - 1;
 }
 
 bool PhysWorld::SegmentCast(const LineSegment& l, CollisionInfo& outColl)
+{
+	PROFILE_SCOPE("PhysWorld::SegmentCast");
+	bool collided = false;
+	Vector3 norm;
+	// The tree visits boxes nearest first, and skips any that are
+	// farther than the closest hit so far
+	mTree.SegmentCast(l, [&](const SlotHandle& handle, float closestT) {
+		const Body* body = mBodies.Get(handle);
+		float t;
+		if (Intersect(l, body->mBox, t, norm) && t < closestT)
+		{
+			outColl.mPoint = l.PointOnSegment(t);
+			outColl.mNormal = norm;
+			outColl.mBox = body->mComp;
+			outColl.mActor = body->mActor;
+			collided = true;
+			return t;
+		}
+		return closestT;
+	});
+	return collided;
+}
+
+size_t PhysWorld::SegmentCastBatch(const LineSegment* segments, size_t count,
+	CollisionInfo* outColl, bool* outHits, size_t packetSize)
+{
+	PROFILE_SCOPE("PhysWorld::SegmentCastBatch");
+	for (size_t i = 0; i < count; i++)
+	{
+		outHits[i] = false;
+	}
+
+	size_t numHits = 0;
+	mTree.SegmentCastPacket(segments, count, packetSize,
+		[&](const SlotHandle& handle, size_t i, float closestT) {
+		const Body* body = mBodies.Get(handle);
+		const LineSegment& l = segments[i];
+		float t;
+		Vector3 norm;
+		if (Intersect(l, body->mBox, t, norm) && t < closestT)
+		{
+			outColl[i].mPoint = l.PointOnSegment(t);
+			outColl[i].mNormal = norm;
+			outColl[i].mBox = body->mComp;
+			outColl[i].mActor = body->mActor;
+			if (!outHits[i])
+			{
+				outHits[i] = true;
+				numHits++;
+			}
+			return t;
+		}
+		return closestT;
+	});
+	return numHits;
+}
+
+bool PhysWorld::SweepBox(const AABB& box, const Vector3& delta, CollisionInfo& outColl,
+	float& outT, const Actor* ignore)
+{
+	PROFILE_SCOPE("PhysWorld::SweepBox");
+	bool collided = false;
+	Vector3 half = (box.mMax - box.mMin) * 0.5f;
+	Vector3 center = box.mMin + half;
+	mTree.SweepCast(LineSegment(center, center + delta), half,
+		[&](const SlotHandle& handle, float closestT) {
+		const Body* body = mBodies.Get(handle);
+		float t;
+		Vector3 norm;
+		if ((!ignore || body->mActor != ignore) && SweptAABB(box, delta, body->mBox, t, norm) &&
+			t < closestT)
+		{
+			// The nearest point of the box hit to the mover's center
+			Vector3 moved = center + delta * t;
+			outColl.mPoint = Vector3(Math::Clamp(moved.x, body->mBox.mMin.x, body->mBox.mMax.x),
+				Math::Clamp(moved.y, body->mBox.mMin.y, body->mBox.mMax.y),
+				Math::Clamp(moved.z, body->mBox.mMin.z, body->mBox.mMax.z));
+			outColl.mNormal = norm;
+			outColl.mBox = body->mComp;
+			outColl.mActor = body->mActor;
+			outT = t;
+			collided = true;
+			return t;
+		}
+		return closestT;
+	});
+	return collided;
+}
+
+bool PhysWorld::SweepSphere(const Sphere& sphere, const Vector3& delta, CollisionInfo& outColl,
+	float& outT, const Actor* ignore)
+{
+	PROFILE_SCOPE("PhysWorld::SweepSphere");
+	bool collided = false;
+	Vector3 extents(sphere.mRadius, sphere.mRadius, sphere.mRadius);
+	mTree.SweepCast(LineSegment(sphere.mCenter, sphere.mCenter + delta), extents,
+		[&](const SlotHandle& handle, float closestT) {
+		const Body* body = mBodies.Get(handle);
+		float t;
+		Vector3 norm;
+		if ((!ignore || body->mActor != ignore) && SweptSphere(sphere, delta, body->mBox, t, norm) &&
+			t < closestT)
+		{
+			outColl.mPoint = sphere.mCenter + delta * t - norm * sphere.mRadius;
+			outColl.mNormal = norm;
+			outColl.mBox = body->mComp;
+			outColl.mActor = body->mActor;
+			outT = t;
+			collided = true;
+			return t;
+		}
+		return closestT;
+	});
+	return collided;
+}
+
+bool PhysWorld::SegmentCastLinear(const LineSegment& l, CollisionInfo& outColl)
 {
 	bool collided = false;
 	// Initialize closestT to infinity, so first
@@ -24,11 +239,11 @@ bool PhysWorld::SegmentCast(const LineSegment& l, CollisionInfo& outColl)
 	float closestT = Math::Infinity;
 	Vector3 norm;
 	// Test against all boxes
-	for (auto box : mBoxes)
+	for (const Body& body : mBodies)
 	{
 		float t;
 		// Does the segment intersect with the box?
-		if (Intersect(l, box->GetWorldBox(), t, norm))
+		if (Intersect(l, body.mBox, t, norm))
 		{
 			// Is this closer than previous intersection?
 			if (t < closestT)
@@ -36,8 +251,8 @@ bool PhysWorld::SegmentCast(const LineSegment& l, CollisionInfo& outColl)
 				closestT = t;
 				outColl.mPoint = l.PointOnSegment(t);
 				outColl.mNormal = norm;
-				outColl.mBox = box;
-				outColl.mActor = box->GetOwner();
+				outColl.mBox = body.mComp;
+				outColl.mActor = body.mActor;
 				collided = true;
 			}
 		}
@@ -48,17 +263,18 @@ bool PhysWorld::SegmentCast(const LineSegment& l, CollisionInfo& outColl)
 void PhysWorld::TestPairwise(std::function<void(Actor*, Actor*)> f)
 {
 	// Naive implementation O(n^2)
-	for (size_t i = 0; i < mBoxes.size(); i++)
+	const std::vector<Body>& bodies = mBodies.GetDense();
+	for (size_t i = 0; i < bodies.size(); i++)
 	{
 		// Don't need to test vs itself and any previous i values
-		for (size_t j = i + 1; j < mBoxes.size(); j++)
+		for (size_t j = i + 1; j < bodies.size(); j++)
 		{
-			BoxComponent* a = mBoxes[i];
-			BoxComponent* b = mBoxes[j];
-			if (Intersect(a->GetWorldBox(), b->GetWorldBox()))
+			const Body& a = bodies[i];
+			const Body& b = bodies[j];
+			if (CanCollide(a, b) && Intersect(a.mBox, b.mBox))
 			{
 				// Call supplied function to handle intersection
-				f(a->GetOwner(), b->GetOwner());
+				f(a.mActor, b.mActor);
 			}
 		}
 	}
@@ -66,48 +282,295 @@ void PhysWorld::TestPairwise(std::function<void(Actor*, Actor*)> f)
 
 void PhysWorld::TestSweepAndPrune(std::function<void(Actor*, Actor*)> f)
 {
-	// Sort by min.x
-	std::sort(mBoxes.begin(), mBoxes.end(),
-		[](BoxComponent* a, BoxComponent* b) {
-			return a->GetWorldBox().mMin.x <
-				b->GetWorldBox().mMin.x;
+	PROFILE_SCOPE("PhysWorld::TestSweepAndPrune");
+	ForEachOverlap([&f](const Body& a, const Body& b) {
+		f(a.mActor, b.mActor);
 	});
+}
+
+void PhysWorld::TestSweepAndPruneFullSort(std::function<void(Actor*, Actor*)> f)
+{
+	auto lessMinX = [](const Body& a, const Body& b) {
+		return a.mBox.mMin.x < b.mBox.mMin.x;
+	};
+
+	// Sort by min.x (static boxes only when they change)
+	mSortedBoxes.clear();
+	for (const Body& body : mBodies)
+	{
+		if (!body.mStatic)
+		{
+			mSortedBoxes.emplace_back(body);
+		}
+	}
+	std::sort(mSortedBoxes.begin(), mSortedBoxes.end(), lessMinX);
+	if (mStaticChanged)
+	{
+		mSortedStaticBoxes.clear();
+		for (const Body& body : mBodies)
+		{
+			if (body.mStatic)
+			{
+				mSortedStaticBoxes.emplace_back(body);
+			}
+		}
+		std::sort(mSortedStaticBoxes.begin(), mSortedStaticBoxes.end(), lessMinX);
+		mStaticMaxX.resize(mSortedStaticBoxes.size());
+		float maxX = -Math::Infinity;
+		for (size_t i = 0; i < mSortedStaticBoxes.size(); i++)
+		{
+			maxX = Math::Max(maxX, mSortedStaticBoxes[i].mBox.mMax.x);
+			mStaticMaxX[i] = maxX;
+		}
+		mStaticChanged = false;
+	}
 
-	for (size_t i = 0; i < mBoxes.size(); i++)
+	for (size_t i = 0; i < mSortedBoxes.size(); i++)
 	{
 		// Get max.x for current box
-		BoxComponent* a = mBoxes[i];
-		float max = a->GetWorldBox().mMax.x;
-		for (size_t j = i + 1; j < mBoxes.size(); j++)
+		const Body& a = mSortedBoxes[i];
+		float max = a.mBox.mMax.x;
+		for (size_t j = i + 1; j < mSortedBoxes.size(); j++)
 		{
-			BoxComponent* b = mBoxes[j];
+			const Body& b = mSortedBoxes[j];
 			// If AABB[j] min is past the max bounds of AABB[i],
 			// then there aren't any other possible intersections
 			// against AABB[i]
-			if (b->GetWorldBox().mMin.x > max)
+			if (b.mBox.mMin.x > max)
+			{
+				break;
+			}
+			else if (CanCollide(a, b) && Intersect(a.mBox, b.mBox))
+			{
+				f(a.mActor, b.mActor);
+			}
+		}
+
+		if (mSortedStaticBoxes.empty())
+		{
+			continue;
+		}
+		// Static boxes that start inside AABB[i]'s x range...
+		float min = a.mBox.mMin.x;
+		auto first = std::lower_bound(mSortedStaticBoxes.begin(),
+			mSortedStaticBoxes.end(), a, lessMinX);
+		size_t start = first - mSortedStaticBoxes.begin();
+		for (size_t j = start; j < mSortedStaticBoxes.size(); j++)
+		{
+			const Body& b = mSortedStaticBoxes[j];
+			if (b.mBox.mMin.x > max)
 			{
 				break;
 			}
-			else if (Intersect(a->GetWorldBox(), b->GetWorldBox()))
+			else if (CanCollide(a, b) && Intersect(a.mBox, b.mBox))
+			{
+				f(a.mActor, b.mActor);
+			}
+		}
+		// ...and ones that start before it, but reach into it
+		for (size_t j = start; j > 0 && mStaticMaxX[j - 1] >= min; j--)
+		{
+			const Body& b = mSortedStaticBoxes[j - 1];
+			if (CanCollide(a, b) && Intersect(a.mBox, b.mBox))
+			{
+				f(a.mActor, b.mActor);
+			}
+		}
+	}
+}
+
+void PhysWorld::TestSpatialHash(std::function<void(Actor*, Actor*)> f)
+{
+	PROFILE_SCOPE("PhysWorld::TestSpatialHash");
+	mSpatialHash.ForEachPair([this, &f](const SlotHandle& a, const SlotHandle& b) {
+		f(mBodies.Get(a)->mActor, mBodies.Get(b)->mActor);
+	});
+}
+
+void PhysWorld::FindContacts()
+{
+	PROFILE_SCOPE("PhysWorld::FindContacts");
+	mNewContacts.clear();
+	mSweepAndPrune.Sync();
+	mSweepAndPrune.ForEachPair([this](const SlotHandle& a, const SlotHandle& b) {
+		uint64_t low = Math::Min(a.mIndex, b.mIndex);
+		uint64_t high = Math::Max(a.mIndex, b.mIndex);
+		mNewContacts.emplace_back(Contact{ (low << 32) | high, a, b });
+	});
+	std::sort(mNewContacts.begin(), mNewContacts.end(),
+		[](const Contact& a, const Contact& b) {
+		return a.mKey < b.mKey;
+	});
+}
+
+void PhysWorld::FindNearest(const Vector3& point, size_t k, float maxDist,
+	std::vector<const Body*>& outBodies, uint32_t layer, uint32_t mask)
+{
+	mSpatialHash.FindNearest(point, k, maxDist, layer, mask, mNearest);
+	outBodies.clear();
+	for (const SlotHandle& handle : mNearest)
+	{
+		outBodies.emplace_back(mBodies.Get(handle));
+	}
+}
+
+void PhysWorld::StepLoop()
+{
+	Profiler::SetThreadName("Physics");
+	std::unique_lock<std::mutex> lock(mStepMutex);
+	while (true)
+	{
+		mStepCondition.wait(lock, [this] { return mQuit || mStepPending; });
+		if (mQuit)
+		{
+			break;
+		}
+		lock.unlock();
+		RunStep();
+		lock.lock();
+		mStepPending = false;
+		mStepDone = true;
+		mStepCondition.notify_all();
+	}
+}
+
+void PhysWorld::RunStep()
+{
+	PROFILE_SCOPE("PhysWorld::RunStep");
+	ApplyBoxWrites(mStepBoxes);
+
+	mStepContacts.clear();
+	if (mFindContacts)
+	{
+		DiffContacts([this](ContactState state, const Contact& c) {
+			mStepContacts.emplace_back(ContactEvent{ state, c.mA, c.mB });
+		});
+	}
+
+	mStepCastResults.resize(mStepCasts.size());
+	for (size_t i = 0; i < mStepCasts.size(); i++)
+	{
+		CastResult& result = mStepCastResults[i];
+		result.mHit = SegmentCast(mStepCasts[i], result.mInfo);
+	}
+}
+
+void PhysWorld::WaitForStep()
+{
+	if (!mThreaded)
+	{
+		return;
+	}
+	std::unique_lock<std::mutex> lock(mStepMutex);
+	mStepCondition.wait(lock, [this] { return !mStepPending; });
+}
+
+void PhysWorld::ApplyBox(Body& body, const AABB& box)
+{
+	body.mBox = box;
+	mStaticChanged |= body.mStatic;
+	mTree.Update(body.mProxy, box);
+	mSweepAndPrune.Update(body.mSapProxy, box);
+	mSpatialHash.Update(body.mHashProxy, box);
+}
+
+void PhysWorld::ApplyBoxWrites(std::vector<BoxWrite>& writes)
+{
+	for (BoxWrite& write : writes)
+	{
+		if (write.mDirty)
+		{
+			write.mDirty = false;
+			// (The box may have been removed since)
+			Body* body = mBodies.Get(write.mHandle);
+			if (body)
 			{
-				f(a->GetOwner(), b->GetOwner());
+				ApplyBox(*body, write.mBox);
 			}
 		}
 	}
 }
 
-void PhysWorld::AddBox(BoxComponent* box)
+SlotHandle PhysWorld::AddBox(BoxComponent* box)
 {
-	mBoxes.emplace_back(box);
+	Actor* owner = box->GetOwner();
+	return AddBox(box->GetWorldBox(), box, owner, owner->IsStatic());
+}
+
+SlotHandle PhysWorld::AddBox(const AABB& box, BoxComponent* comp,
+	Actor* actor, bool isStatic)
+{
+	WaitForStep();
+	if (isStatic)
+	{
+		mStaticChanged = true;
+	}
+	SlotHandle handle = mBodies.Insert(Body{ box, comp, actor, isStatic, 1, UINT32_MAX,
+		0, 0, 0 });
+	Body* body = mBodies.Get(handle);
+	body->mProxy = mTree.Insert(box, handle);
+	body->mSapProxy = mSweepAndPrune.Add(box, handle, isStatic);
+	body->mHashProxy = mSpatialHash.Add(box, handle, isStatic);
+	// Room for it in the buffer UpdateBox writes to
+	if (handle.mIndex >= mBoxWrites.size())
+	{
+		mBoxWrites.resize(handle.mIndex + 1, BoxWrite{ box, SlotHandle(), false });
+	}
+	return handle;
+}
+
+void PhysWorld::RemoveBox(const SlotHandle& handle)
+{
+	WaitForStep();
+	Body* body = mBodies.Get(handle);
+	if (body)
+	{
+		mStaticChanged |= body->mStatic;
+		mTree.Remove(body->mProxy);
+		mSweepAndPrune.Remove(body->mSapProxy);
+		mSpatialHash.Remove(body->mHashProxy);
+		// Its contacts just go away (there's no body left for an EEnd)
+		uint32_t index = handle.mIndex;
+		mContacts.erase(std::remove_if(mContacts.begin(), mContacts.end(),
+			[index](const Contact& c) {
+			return c.mA.mIndex == index || c.mB.mIndex == index;
+		}), mContacts.end());
+		mBodies.Remove(handle);
+	}
+}
+
+void PhysWorld::UpdateBox(const SlotHandle& handle, const AABB& box)
+{
+	// Only this box's slot is written, so there's no need to lock
+	// (the broadphase itself isn't touched until the step)
+	if (handle.mIndex < mBoxWrites.size())
+	{
+		mBoxWrites[handle.mIndex] = BoxWrite{ box, handle, true };
+	}
+}
+
+void PhysWorld::SetBoxStatic(const SlotHandle& handle, bool isStatic)
+{
+	WaitForStep();
+	Body* body = mBodies.Get(handle);
+	if (body && body->mStatic != isStatic)
+	{
+		body->mStatic = isStatic;
+		mStaticChanged = true;
+		mSweepAndPrune.SetStatic(body->mSapProxy, isStatic);
+		mSpatialHash.SetStatic(body->mHashProxy, isStatic);
+	}
 }
 
-void PhysWorld::RemoveBox(BoxComponent* box)
+void PhysWorld::SetBoxFilter(const SlotHandle& handle, uint32_t layer, uint32_t mask)
 {
-	auto iter = std::find(mBoxes.begin(), mBoxes.end(), box);
-	if (iter != mBoxes.end())
+	WaitForStep();
+	Body* body = mBodies.Get(handle);
+	if (body)
 	{
-		// Swap to end of vector and pop off (avoid erase copies)
-		std::iter_swap(iter, mBoxes.end() - 1);
-		mBoxes.pop_back();
+		body->mLayer = layer;
+		body->mMask = mask;
+		mSweepAndPrune.SetFilter(body->mSapProxy, layer, mask);
+		mSpatialHash.SetFilter(body->mHashProxy, layer, mask);
 	}
 }
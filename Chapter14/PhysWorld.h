@@ -9,13 +9,22 @@
 #pragma once
 #include <vector>
 #include <functional>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "Math.h"
 #include "Collision.h"
+#include "SlotMap.h"
+#include "AABBTree.h"
+#include "SweepAndPrune.h"
+#include "SpatialHash.h"
 
 class PhysWorld
 {
 public:
 	PhysWorld(class Game* game);
+	~PhysWorld();
 
 	// Used to give helpful information about collision results
 	struct CollisionInfo
@@ -30,19 +39,321 @@ public:
 		class Actor* mActor;
 	};
 
+	// What the world keeps for each box. The broadphase only reads
+	// these packed copies, rather than going through the components.
+	struct Body
+	{
+		AABB mBox;
+		class BoxComponent* mComp;
+		class Actor* mActor;
+		bool mStatic;
+		// Only paired with boxes whose layer is in mMask (and whose
+		// mask has mLayer)
+		uint32_t mLayer;
+		uint32_t mMask;
+		// Leaf in mTree, and proxies in mSweepAndPrune and mSpatialHash
+		int mProxy;
+		int mSapProxy;
+		int mHashProxy;
+	};
+
+	// The queries below only read the broadphase, which only changes
+	// at EndTick (or when boxes are added or removed), so job threads
+	// can make them while other jobs call UpdateBox. A change that
+	// writes the broadphase outside the step would break that.
+
 	// Test a line segment against boxes
 	// Returns true if it collides against a box
 	bool SegmentCast(const LineSegment& l, CollisionInfo& outColl);
+	// Same result, but tests every box instead of using the tree
+	// (for comparison)
+	bool SegmentCastLinear(const LineSegment& l, CollisionInfo& outColl);
+	// Casts count segments, several at a time (see
+	// AABBTree::SegmentCastPacket). For each segment i, outHits[i] says
+	// if it hit, and outColl[i] is as from SegmentCast. Returns the
+	// number of hits.
+	size_t SegmentCastBatch(const LineSegment* segments, size_t count,
+		CollisionInfo* outColl, bool* outHits, size_t packetSize = 8);
+
+	// Continuous collision: moves a box or sphere by delta, and finds
+	// the first box it touches (skipping the boxes of ignore). outT is
+	// the fraction of delta it can move before then, and outColl has
+	// the point where they touch.
+	bool SweepBox(const AABB& box, const Vector3& delta, CollisionInfo& outColl,
+		float& outT, const class Actor* ignore = nullptr);
+	bool SweepSphere(const Sphere& sphere, const Vector3& delta, CollisionInfo& outColl,
+		float& outT, const class Actor* ignore = nullptr);
 
 	// Tests collisions using naive pairwise
+	// (like sweep and prune, pairs of static boxes aren't reported)
 	void TestPairwise(std::function<void(class Actor*, class Actor*)> f);
-	// Test collisions using sweep and prune
+	// Test collisions using sweep and prune (kept sorted between calls)
 	void TestSweepAndPrune(std::function<void(class Actor*, class Actor*)> f);
+	// Same pairs, but sorts every box from scratch each call
+	// (for comparison)
+	void TestSweepAndPruneFullSort(std::function<void(class Actor*, class Actor*)> f);
+	// Test collisions using the spatial hash
+	void TestSpatialHash(std::function<void(class Actor*, class Actor*)> f);
+
+	// Same pairs as TestSweepAndPrune, but func(const Body&, const Body&)
+	// is called directly (and can be inlined)
+	template <typename Func>
+	void ForEachOverlap(Func func);
+
+	enum ContactState
+	{
+		EBegin,
+		EPersist,
+		EEnd
+	};
+	// Finds the overlapping pairs (with sweep and prune) and compares
+	// them with the last call's. func(state, const Body&, const Body&)
+	// is called for each pair that began, still overlaps, or ended.
+	// Contacts of a removed box end without an EEnd, and func mustn't
+	// add or remove boxes.
+	template <typename Func>
+	void UpdateContacts(Func func);
+	size_t GetNumContacts() const { return mContacts.size(); }
+
+	// Once a tick, the world takes a step: it moves the boxes from
+	// UpdateBox in the broadphase, runs the queued segment casts, and
+	// (if contact events are on) finds the contacts that began,
+	// persist or ended. The results are published at the start of the
+	// next tick.
+	//
+	// UpdateBox only records the box, so queries see the boxes as they
+	// were at the last step. It writes nothing but that box's slot, so
+	// job threads may call it, and query, while other jobs move their
+	// boxes. Everything else is for the main thread.
+	//
+	// Threaded, the step runs on its own thread while the main thread
+	// renders. Adding or removing boxes waits for it, and no queries
+	// may be made between EndTick and BeginTick.
+	void SetThreaded(bool threaded);
+	bool IsThreaded() const { return mThreaded; }
+	// Whether the step finds contact events (off by default, as it's a
+	// full broadphase pass). The step keeps the same contacts as
+	// UpdateContacts, so use one or the other.
+	void SetContactEvents(bool enabled);
+	// Waits for the step, and publishes its results
+	void BeginTick();
+	// Starts the step with this tick's boxes and casts
+	void EndTick();
+
+	// Casts l in the next step. Returns its index in GetCastResults,
+	// once that step's results are published.
+	size_t QueueSegmentCast(const LineSegment& l);
+	struct CastResult
+	{
+		CollisionInfo mInfo;
+		bool mHit;
+	};
+	const std::vector<CastResult>& GetCastResults() const { return mCastResults; }
+	// Calls func(state, const Body&, const Body&) for each contact
+	// change from the last published step (skipping removed boxes)
+	template <typename Func>
+	void ForEachContactEvent(Func func);
+
+	// Region queries (with the spatial hash). func(const Body&) is
+	// called once for each box that overlaps. A query only finds the
+	// boxes a box with its layer and mask would collide with. (Nothing
+	// in the game makes these yet, only the benchmarks.)
+	template <typename Func>
+	void OverlapBox(const AABB& box, Func func, uint32_t layer = 1,
+		uint32_t mask = UINT32_MAX);
+	template <typename Func>
+	void OverlapSphere(const Sphere& sphere, Func func, uint32_t layer = 1,
+		uint32_t mask = UINT32_MAX);
+	// Up to k boxes nearest to point, no farther than maxDist
+	// (pointers are only good until boxes are added or removed)
+	void FindNearest(const Vector3& point, size_t k, float maxDist,
+		std::vector<const Body*>& outBodies, uint32_t layer = 1,
+		uint32_t mask = UINT32_MAX);
+	// Best about the size of a typical box
+	void SetCellSize(float cellSize) { WaitForStep(); mSpatialHash.SetCellSize(cellSize); }
+
+	// Sweep and prune on all three axes (the default), or on x only
+	// (one list to keep sorted, but every pair that overlaps on x
+	// is tested each call)
+	void SetSweepAndPruneAxes(bool threeAxes)
+	{
+		WaitForStep();
+		mSweepAndPrune.SetThreeAxes(threeAxes);
+	}
 
 	// Add/remove box components from world
-	void AddBox(class BoxComponent* box);
-	void RemoveBox(class BoxComponent* box);
+	SlotHandle AddBox(class BoxComponent* box);
+	// Add a box that isn't from a component (comp may be null)
+	SlotHandle AddBox(const AABB& box, class BoxComponent* comp,
+		class Actor* actor, bool isStatic);
+	void RemoveBox(const SlotHandle& handle);
+	// Call when the box's world bounds change (the broadphase sees the
+	// new bounds at EndTick)
+	void UpdateBox(const SlotHandle& handle, const AABB& box);
+	// Static boxes never move, so they are sorted once and never
+	// tested against each other
+	void SetBoxStatic(const SlotHandle& handle, bool isStatic);
+	// Collision layer of the box, and the layers it collides with
+	// (boxes start on layer 1, colliding with everything)
+	void SetBoxFilter(const SlotHandle& handle, uint32_t layer, uint32_t mask);
+
+	size_t GetNumBoxes() const { return mBodies.GetSize(); }
+	const AABBTree& GetTree() const { return mTree; }
 private:
+	struct Contact
+	{
+		uint64_t mKey;
+		SlotHandle mA;
+		SlotHandle mB;
+	};
+
+	struct ContactEvent
+	{
+		ContactState mState;
+		SlotHandle mA;
+		SlotHandle mB;
+	};
+
+	// A box from UpdateBox, waiting for the next step
+	struct BoxWrite
+	{
+		AABB mBox;
+		SlotHandle mHandle;
+		bool mDirty;
+	};
+
+	// Whether a pair is worth testing at all
+	static bool CanCollide(const Body& a, const Body& b)
+	{
+		return !(a.mStatic && b.mStatic) && (a.mLayer & b.mMask) != 0 &&
+			(b.mLayer & a.mMask) != 0;
+	}
+	// Fills mNewContacts with this frame's pairs, sorted by key
+	void FindContacts();
+	// UpdateContacts, but func(state, const Contact&)
+	template <typename Func>
+	void DiffContacts(Func func);
+	// Moves the body's box in each broadphase
+	void ApplyBox(Body& body, const AABB& box);
+	void ApplyBoxWrites(std::vector<BoxWrite>& writes);
+
+	void StepLoop();
+	void RunStep();
+	void WaitForStep();
+
 	class Game* mGame;
-	std::vector<class BoxComponent*> mBoxes;
+	SlotMap<Body> mBodies;
+	// Every box (moving and static), for segment casts
+	AABBTree mTree;
+	SweepAndPrune mSweepAndPrune;
+	SpatialHash mSpatialHash;
+	std::vector<SlotHandle> mNearest;
+	// Pairs from the last UpdateContacts, and the current ones
+	std::vector<Contact> mContacts;
+	std::vector<Contact> mNewContacts;
+	// Moving boxes sorted by min.x for TestSweepAndPruneFullSort
+	// (the slot map's own order can't be changed)
+	std::vector<Body> mSortedBoxes;
+	// Static boxes sorted by min.x, only redone when they change
+	std::vector<Body> mSortedStaticBoxes;
+	// Largest max.x of mSortedStaticBoxes[0..i]
+	std::vector<float> mStaticMaxX;
+	bool mStaticChanged;
+
+	// Threaded step (see SetThreaded). Boxes and casts from this tick,
+	// and the ones the step is working on.
+	std::vector<BoxWrite> mBoxWrites;
+	std::vector<BoxWrite> mStepBoxes;
+	std::vector<LineSegment> mCastQueue;
+	std::vector<LineSegment> mStepCasts;
+	// Results of the running step, and the published ones
+	std::vector<ContactEvent> mStepContacts;
+	std::vector<ContactEvent> mContactEvents;
+	std::vector<CastResult> mStepCastResults;
+	std::vector<CastResult> mCastResults;
+	std::thread mStepThread;
+	std::mutex mStepMutex;
+	std::condition_variable mStepCondition;
+	std::mutex mCastMutex;
+	bool mStepPending;
+	bool mStepDone;
+	bool mQuit;
+	bool mThreaded;
+	bool mFindContacts;
 };
+
+template <typename Func>
+void PhysWorld::ForEachOverlap(Func func)
+{
+	mSweepAndPrune.Sync();
+	mSweepAndPrune.ForEachPair([this, &func](const SlotHandle& a, const SlotHandle& b) {
+		func(*mBodies.Get(a), *mBodies.Get(b));
+	});
+}
+
+template <typename Func>
+void PhysWorld::UpdateContacts(Func func)
+{
+	DiffContacts([this, &func](ContactState state, const Contact& c) {
+		func(state, *mBodies.Get(c.mA), *mBodies.Get(c.mB));
+	});
+}
+
+template <typename Func>
+void PhysWorld::DiffContacts(Func func)
+{
+	FindContacts();
+	// Both lists are sorted by key, so walk them together
+	size_t i = 0;
+	size_t j = 0;
+	while (i < mContacts.size() || j < mNewContacts.size())
+	{
+		if (j == mNewContacts.size() ||
+			(i < mContacts.size() && mContacts[i].mKey < mNewContacts[j].mKey))
+		{
+			// Only in the old list
+			func(EEnd, mContacts[i++]);
+		}
+		else if (i == mContacts.size() || mNewContacts[j].mKey < mContacts[i].mKey)
+		{
+			// Only in the new list
+			func(EBegin, mNewContacts[j++]);
+		}
+		else
+		{
+			i++;
+			func(EPersist, mNewContacts[j++]);
+		}
+	}
+	std::swap(mContacts, mNewContacts);
+}
+
+template <typename Func>
+void PhysWorld::ForEachContactEvent(Func func)
+{
+	for (const ContactEvent& e : mContactEvents)
+	{
+		const Body* a = mBodies.Get(e.mA);
+		const Body* b = mBodies.Get(e.mB);
+		if (a && b)
+		{
+			func(e.mState, *a, *b);
+		}
+	}
+}
+
+template <typename Func>
+void PhysWorld::OverlapBox(const AABB& box, Func func, uint32_t layer, uint32_t mask)
+{
+	mSpatialHash.QueryBox(box, layer, mask, [this, &func](const SlotHandle& handle) {
+		func(*mBodies.Get(handle));
+	});
+}
+
+template <typename Func>
+void PhysWorld::OverlapSphere(const Sphere& sphere, Func func, uint32_t layer, uint32_t mask)
+{
+	mSpatialHash.QuerySphere(sphere, layer, mask, [this, &func](const SlotHandle& handle) {
+		func(*mBodies.Get(handle));
+	});
+}
@@ -14,4 +14,5 @@ class PlaneActor : public Actor
 public:
 	PlaneActor(class Game* game);
 	TypeID GetType() const override { return TPlaneActor; }
+	ACTOR_POOL(PlaneActor)
 };
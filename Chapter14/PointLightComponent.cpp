@@ -15,10 +15,24 @@
 #include "Actor.h"
 #include "LevelLoader.h"
 
+namespace
+{
+	const Shader::Uniform<Matrix4> cWorldTransform =
+		Shader::GetUniform<Matrix4>("uWorldTransform");
+	const Shader::Uniform<Vector3> cWorldPos =
+		Shader::GetUniform<Vector3>("uPointLight.mWorldPos");
+	const Shader::Uniform<Vector3> cDiffuseColor =
+		Shader::GetUniform<Vector3>("uPointLight.mDiffuseColor");
+	const Shader::Uniform<float> cInnerRadius =
+		Shader::GetUniform<float>("uPointLight.mInnerRadius");
+	const Shader::Uniform<float> cOuterRadius =
+		Shader::GetUniform<float>("uPointLight.mOuterRadius");
+}
+
 PointLightComponent::PointLightComponent(Actor* owner)
 	:Component(owner)
 {
-	owner->GetGame()->GetRenderer()->AddPointLight(this);
+	mRenderHandle = owner->GetGame()->GetRenderer()->AddPointLight(this);
 }
 
 PointLightComponent::~PointLightComponent()
@@ -37,12 +51,12 @@ void PointLightComponent::Draw(Shader* shader, Mesh* mesh)
 		mOuterRadius / mesh->GetRadius());
 	Matrix4 trans = Matrix4::CreateTranslation(mOwner->GetPosition());
 	Matrix4 worldTransform = scale * trans;
-	shader->SetMatrixUniform("uWorldTransform", worldTransform);
+	shader->SetUniform(cWorldTransform, worldTransform);
 	// Set point light shader constants
-	shader->SetVectorUniform("uPointLight.mWorldPos", mOwner->GetPosition());
-	shader->SetVectorUniform("uPointLight.mDiffuseColor", mDiffuseColor);
-	shader->SetFloatUniform("uPointLight.mInnerRadius", mInnerRadius);
-	shader->SetFloatUniform("uPointLight.mOuterRadius", mOuterRadius);
+	shader->SetUniform(cWorldPos, mOwner->GetPosition());
+	shader->SetUniform(cDiffuseColor, mDiffuseColor);
+	shader->SetUniform(cInnerRadius, mInnerRadius);
+	shader->SetUniform(cOuterRadius, mOuterRadius);
 
 	// Draw the sphere
 	glDrawElements(GL_TRIANGLES, mesh->GetVertexArray()->GetNumIndices(), 
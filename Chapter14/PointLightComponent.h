@@ -9,6 +9,7 @@
 #pragma once
 #include "Math.h"
 #include "Component.h"
+#include "SlotMap.h"
 
 class PointLightComponent : public Component
 {
@@ -26,8 +27,14 @@ public:
 	float mOuterRadius;
 
 	TypeID GetType() const override { return TPointLightComponent; }
+	COMPONENT_POOL(PointLightComponent)
+
+	const SlotHandle& GetRenderHandle() const { return mRenderHandle; }
 
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
 		rapidjson::Value& inObj) const override;
+private:
+	// Handle from Renderer::AddPointLight
+	SlotHandle mRenderHandle;
 };
@@ -0,0 +1,281 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <SDL/SDL.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+namespace
+{
+	// Zones each thread can record between calls to EndFrame
+	const size_t cRingSize = 16384;
+	// Frames in the rolling average
+	const int cAverageFrames = 60;
+
+	struct ZoneEvent
+	{
+		const char* mName;
+		uint64_t mStart;
+		uint64_t mEnd;
+	};
+
+	struct ThreadBuffer
+	{
+		ThreadBuffer(int id)
+			:mEvents(cRingSize)
+			,mWriteIndex(0)
+			,mReadIndex(0)
+			,mThreadID(id)
+			,mName("Thread " + std::to_string(id))
+		{}
+		std::vector<ZoneEvent> mEvents;
+		// Only the owning thread writes; EndFrame reads up to here
+		std::atomic<size_t> mWriteIndex;
+		size_t mReadIndex;
+		int mThreadID;
+		std::string mName;
+	};
+
+	struct ZoneHistory
+	{
+		const char* mName;
+		float mMS[cAverageFrames];
+		int mCalls[cAverageFrames];
+	};
+
+	struct CapturedEvent
+	{
+		ZoneEvent mEvent;
+		int mThreadID;
+	};
+
+	std::mutex gBufferMutex;
+	// Buffers stay around even if their thread exits
+	std::vector<std::unique_ptr<ThreadBuffer>> gBuffers;
+	thread_local ThreadBuffer* tBuffer = nullptr;
+
+	std::unordered_map<const char*, size_t> gZoneIndices;
+	std::vector<ZoneHistory> gHistory;
+	std::vector<Profiler::ZoneStats> gStats;
+	int gFrameSlot = 0;
+	int gFramesSeen = 0;
+
+	int gCaptureFramesLeft = 0;
+	std::string gCaptureFile;
+	uint64_t gCaptureStart = 0;
+	std::vector<CapturedEvent> gCaptured;
+
+	ThreadBuffer* GetThreadBuffer()
+	{
+		if (!tBuffer)
+		{
+			std::lock_guard<std::mutex> lock(gBufferMutex);
+			gBuffers.emplace_back(new ThreadBuffer(static_cast<int>(gBuffers.size())));
+			tBuffer = gBuffers.back().get();
+		}
+		return tBuffer;
+	}
+
+	void SaveCapture()
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+		writer.StartObject();
+		writer.Key("traceEvents");
+		writer.StartArray();
+
+		// Thread names
+		{
+			std::lock_guard<std::mutex> lock(gBufferMutex);
+			for (auto& buf : gBuffers)
+			{
+				writer.StartObject();
+				writer.Key("name"); writer.String("thread_name");
+				writer.Key("ph"); writer.String("M");
+				writer.Key("pid"); writer.Int(1);
+				writer.Key("tid"); writer.Int(buf->mThreadID);
+				writer.Key("args");
+				writer.StartObject();
+				writer.Key("name"); writer.String(buf->mName.c_str());
+				writer.EndObject();
+				writer.EndObject();
+			}
+		}
+
+		// Complete ("X") events, with times in microseconds
+		for (const CapturedEvent& c : gCaptured)
+		{
+			uint64_t start = c.mEvent.mStart > gCaptureStart ?
+				c.mEvent.mStart - gCaptureStart : 0;
+			writer.StartObject();
+			writer.Key("name"); writer.String(c.mEvent.mName);
+			writer.Key("ph"); writer.String("X");
+			writer.Key("pid"); writer.Int(1);
+			writer.Key("tid"); writer.Int(c.mThreadID);
+			writer.Key("ts"); writer.Double(start / 1000.0);
+			writer.Key("dur"); writer.Double((c.mEvent.mEnd - c.mEvent.mStart) / 1000.0);
+			writer.EndObject();
+		}
+
+		writer.EndArray();
+		writer.EndObject();
+
+		std::ofstream outFile(gCaptureFile);
+		if (outFile.is_open())
+		{
+			outFile << buffer.GetString();
+			SDL_Log("Saved profile capture to %s", gCaptureFile.c_str());
+		}
+		else
+		{
+			SDL_Log("Unable to save profile capture to %s", gCaptureFile.c_str());
+		}
+		gCaptured.clear();
+	}
+}
+
+Profiler::Zone::Zone(const char* name)
+	:mName(name)
+	,mStart(GetTimeNS())
+{
+}
+
+Profiler::Zone::~Zone()
+{
+	ThreadBuffer* buf = GetThreadBuffer();
+	size_t index = buf->mWriteIndex.load(std::memory_order_relaxed);
+	ZoneEvent& e = buf->mEvents[index % cRingSize];
+	e.mName = mName;
+	e.mStart = mStart;
+	e.mEnd = GetTimeNS();
+	buf->mWriteIndex.store(index + 1, std::memory_order_release);
+}
+
+uint64_t Profiler::GetTimeNS()
+{
+	using namespace std::chrono;
+	return static_cast<uint64_t>(duration_cast<nanoseconds>(
+		steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::EndFrame()
+{
+	// Clear this frame's slot in the history
+	for (auto& h : gHistory)
+	{
+		h.mMS[gFrameSlot] = 0.0f;
+		h.mCalls[gFrameSlot] = 0;
+	}
+
+	bool capturing = gCaptureFramesLeft > 0;
+	{
+		std::lock_guard<std::mutex> lock(gBufferMutex);
+		for (auto& buf : gBuffers)
+		{
+			size_t write = buf->mWriteIndex.load(std::memory_order_acquire);
+			// If the ring wrapped, the oldest zones are gone
+			size_t read = buf->mReadIndex;
+			if (write - read > cRingSize)
+			{
+				read = write - cRingSize;
+			}
+
+			for (; read < write; read++)
+			{
+				const ZoneEvent& e = buf->mEvents[read % cRingSize];
+				auto iter = gZoneIndices.find(e.mName);
+				if (iter == gZoneIndices.end())
+				{
+					ZoneHistory h;
+					h.mName = e.mName;
+					std::fill(h.mMS, h.mMS + cAverageFrames, 0.0f);
+					std::fill(h.mCalls, h.mCalls + cAverageFrames, 0);
+					iter = gZoneIndices.emplace(e.mName, gHistory.size()).first;
+					gHistory.emplace_back(h);
+				}
+				ZoneHistory& h = gHistory[iter->second];
+				h.mMS[gFrameSlot] += (e.mEnd - e.mStart) / 1000000.0f;
+				h.mCalls[gFrameSlot]++;
+
+				if (capturing)
+				{
+					CapturedEvent c;
+					c.mEvent = e;
+					c.mThreadID = buf->mThreadID;
+					gCaptured.emplace_back(c);
+				}
+			}
+			buf->mReadIndex = write;
+		}
+	}
+
+	// Update the rolling averages
+	gFramesSeen = gFramesSeen < cAverageFrames ? gFramesSeen + 1 : cAverageFrames;
+	gStats.resize(gHistory.size());
+	for (size_t i = 0; i < gHistory.size(); i++)
+	{
+		float ms = 0.0f;
+		int calls = 0;
+		for (int j = 0; j < cAverageFrames; j++)
+		{
+			ms += gHistory[i].mMS[j];
+			calls += gHistory[i].mCalls[j];
+		}
+		gStats[i].mName = gHistory[i].mName;
+		gStats[i].mAverageMS = ms / gFramesSeen;
+		gStats[i].mAverageCalls = static_cast<float>(calls) / gFramesSeen;
+	}
+	gFrameSlot = (gFrameSlot + 1) % cAverageFrames;
+
+	if (capturing)
+	{
+		gCaptureFramesLeft--;
+		if (gCaptureFramesLeft == 0)
+		{
+			SaveCapture();
+		}
+	}
+}
+
+void Profiler::StartCapture(int numFrames, const std::string& fileName)
+{
+	if (gCaptureFramesLeft > 0)
+	{
+		return;
+	}
+	gCaptureFramesLeft = numFrames;
+	gCaptureFile = fileName;
+	gCaptureStart = GetTimeNS();
+	gCaptured.clear();
+	SDL_Log("Capturing %d frames to %s", numFrames, fileName.c_str());
+}
+
+bool Profiler::IsCapturing()
+{
+	return gCaptureFramesLeft > 0;
+}
+
+const std::vector<Profiler::ZoneStats>& Profiler::GetZoneStats()
+{
+	return gStats;
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	ThreadBuffer* buf = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(gBufferMutex);
+	buf->mName = name;
+}
@@ -0,0 +1,62 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CPU profiler. Zones are timed blocks of code, recorded into a ring
+// buffer per thread. Once per frame the buffers are gathered into
+// rolling per-zone averages, and optionally into a capture that's
+// saved in the Chrome trace format.
+class Profiler
+{
+public:
+	// Times the enclosing block (use PROFILE_SCOPE)
+	// name must be a string literal, since only the pointer is kept
+	class Zone
+	{
+	public:
+		Zone(const char* name);
+		~Zone();
+	private:
+		const char* mName;
+		uint64_t mStart;
+	};
+
+	struct ZoneStats
+	{
+		const char* mName;
+		// Averages per frame, over the last few frames
+		float mAverageMS;
+		float mAverageCalls;
+	};
+
+	// Nanoseconds since some fixed point
+	static uint64_t GetTimeNS();
+
+	// Call once per frame, from the main thread
+	static void EndFrame();
+
+	// Record the next numFrames frames, then save them as a Chrome
+	// trace (open with chrome://tracing or ui.perfetto.dev)
+	static void StartCapture(int numFrames, const std::string& fileName);
+	static bool IsCapturing();
+
+	// Rolling averages for every zone seen so far
+	static const std::vector<ZoneStats>& GetZoneStats();
+
+	// Name the calling thread in captures
+	static void SetThreadName(const std::string& name);
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// Profile from here to the end of the enclosing block
+#define PROFILE_SCOPE(name) Profiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
@@ -0,0 +1,122 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "RenderQueue.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+uint64_t RenderQueue::MakeKey(uint32_t shader, uint32_t texture,
+	uint32_t vertexArray, float depth)
+{
+	const uint32_t cMaxDepth = (1 << 24) - 1;
+	// Written so NaN ends up at 0
+	uint32_t quantized = 0;
+	if (depth >= 1.0f)
+	{
+		quantized = cMaxDepth;
+	}
+	else if (depth > 0.0f)
+	{
+		quantized = static_cast<uint32_t>(depth * cMaxDepth);
+	}
+	return (static_cast<uint64_t>(shader & 0xFF) << 56) |
+		(static_cast<uint64_t>(texture & 0xFFFF) << 40) |
+		(static_cast<uint64_t>(vertexArray & 0xFFFF) << 24) |
+		quantized;
+}
+
+void RenderQueue::Sort()
+{
+	const size_t count = mItems.size();
+	// Below about a thousand draws, the eight radix passes cost
+	// more than a comparison sort (see Benchmark's RenderQueue cases)
+	const size_t cMinRadixItems = 1024;
+	if (count < cMinRadixItems)
+	{
+		std::stable_sort(mItems.begin(), mItems.end(),
+			[](const Item& a, const Item& b) {
+			return a.mKey < b.mKey;
+		});
+		return;
+	}
+	mScratch.resize(count);
+
+	// Counts for each byte of the key, all in one pass
+	size_t counts[8][256];
+	memset(counts, 0, sizeof(counts));
+	for (const Item& item : mItems)
+	{
+		for (int b = 0; b < 8; b++)
+		{
+			counts[b][(item.mKey >> (b * 8)) & 0xFF]++;
+		}
+	}
+
+	// Least significant byte first. Each pass is stable, so the
+	// earlier bytes stay in order within each value of this one.
+	Item* src = mItems.data();
+	Item* dst = mScratch.data();
+	for (int b = 0; b < 8; b++)
+	{
+		int shift = b * 8;
+		// Skip the pass if every key has the same byte here
+		// (common for the shader byte)
+		if (counts[b][(src[0].mKey >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+		size_t offsets[256];
+		size_t total = 0;
+		for (int i = 0; i < 256; i++)
+		{
+			offsets[i] = total;
+			total += counts[b][i];
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			dst[offsets[(src[i].mKey >> shift) & 0xFF]++] = src[i];
+		}
+		std::swap(src, dst);
+	}
+	// An odd number of passes leaves the result in mScratch
+	if (src != mItems.data())
+	{
+		mItems.swap(mScratch);
+	}
+}
+
+RenderQueue::Stats RenderQueue::CountStateChanges() const
+{
+	Stats stats = { mItems.size(), 0, 0, 0 };
+	// Nothing is bound at the start (texture 0 means no texture, so
+	// whatever is bound is kept)
+	const uint32_t cNone = 0xFFFFFFFF;
+	uint32_t shader = cNone;
+	uint32_t texture = cNone;
+	uint32_t vertexArray = cNone;
+	for (const Item& item : mItems)
+	{
+		if (GetShader(item.mKey) != shader)
+		{
+			shader = GetShader(item.mKey);
+			stats.mShaderBinds++;
+		}
+		if (GetTexture(item.mKey) != 0 && GetTexture(item.mKey) != texture)
+		{
+			texture = GetTexture(item.mKey);
+			stats.mTextureBinds++;
+		}
+		if (GetVertexArray(item.mKey) != vertexArray)
+		{
+			vertexArray = GetVertexArray(item.mKey);
+			stats.mVertexArrayBinds++;
+		}
+	}
+	return stats;
+}
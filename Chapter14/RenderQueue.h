@@ -0,0 +1,81 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A frame's draws, sorted so draws that use the same state are next to
+// each other. Each draw gets a 64-bit key:
+//   shader (8 bits) | texture (16) | vertex array (16) | depth (24)
+// so sorting by key groups the draws by shader, then texture, then
+// vertex array, and draws each group front to back.
+class RenderQueue
+{
+public:
+	struct Item
+	{
+		uint64_t mKey;
+		// The caller's index for the draw
+		uint32_t mIndex;
+	};
+
+	// Binds needed to draw the items in some order, if binding what's
+	// already bound is skipped
+	struct Stats
+	{
+		size_t mDraws;
+		size_t mShaderBinds;
+		size_t mTextureBinds;
+		size_t mVertexArrayBinds;
+		size_t GetBinds() const
+		{
+			return mShaderBinds + mTextureBinds + mVertexArrayBinds;
+		}
+		Stats& operator+=(const Stats& other)
+		{
+			mDraws += other.mDraws;
+			mShaderBinds += other.mShaderBinds;
+			mTextureBinds += other.mTextureBinds;
+			mVertexArrayBinds += other.mVertexArrayBinds;
+			return *this;
+		}
+	};
+
+	// IDs only need to be different for different state (GL names are
+	// fine, though only their low bits are used), and texture 0 means
+	// no texture. depth is from 0 (nearest) to 1 (farthest), and is
+	// clamped.
+	static uint64_t MakeKey(uint32_t shader, uint32_t texture,
+		uint32_t vertexArray, float depth);
+	static uint32_t GetShader(uint64_t key) { return static_cast<uint32_t>(key >> 56); }
+	static uint32_t GetTexture(uint64_t key) { return static_cast<uint32_t>(key >> 40) & 0xFFFF; }
+	static uint32_t GetVertexArray(uint64_t key) { return static_cast<uint32_t>(key >> 24) & 0xFFFF; }
+
+	void Clear() { mItems.clear(); }
+	void Submit(uint32_t shader, uint32_t texture, uint32_t vertexArray,
+		float depth, uint32_t index)
+	{
+		mItems.emplace_back(Item{ MakeKey(shader, texture, vertexArray, depth), index });
+	}
+	// Sorts the items by key, with a radix sort if there are many
+	// (draws with the same key keep the order they were submitted in)
+	void Sort();
+
+	// Counts the binds for the items' current order (the keys' state
+	// IDs stand in for the real state)
+	Stats CountStateChanges() const;
+
+	const std::vector<Item>& GetItems() const { return mItems; }
+	size_t GetSize() const { return mItems.size(); }
+private:
+	std::vector<Item> mItems;
+	// Sort's other buffer
+	std::vector<Item> mScratch;
+};
@@ -20,17 +20,48 @@
 #include "SkeletalMeshComponent.h"
 #include "GBuffer.h"
 #include "PointLightComponent.h"
+#include "Profiler.h"
+#include "Actor.h"
+
+namespace
+{
+	// Uniforms set every frame
+	const Shader::Uniform<Matrix4> cViewProj = Shader::GetUniform<Matrix4>("uViewProj");
+	const Shader::Uniform<Vector3> cCameraPos = Shader::GetUniform<Vector3>("uCameraPos");
+	const Shader::Uniform<Vector3> cAmbientLight =
+		Shader::GetUniform<Vector3>("uAmbientLight");
+	const Shader::Uniform<Vector3> cDirLightDirection =
+		Shader::GetUniform<Vector3>("uDirLight.mDirection");
+	const Shader::Uniform<Vector3> cDirLightDiffuse =
+		Shader::GetUniform<Vector3>("uDirLight.mDiffuseColor");
+	const Shader::Uniform<Vector3> cDirLightSpec =
+		Shader::GetUniform<Vector3>("uDirLight.mSpecColor");
+
+	// Shader IDs in render queue keys
+	const uint32_t cMeshShaderID = 0;
+	const uint32_t cSkinnedShaderID = 1;
+	// Queue depths are view space z over this (the far plane)
+	const float cQueueDepthRange = 10000.0f;
+}
 
 Renderer::Renderer(Game* game)
-	:mGame(game)
+	:mUnsortedStats()
+	,mDrawStats()
+	,mUnfilteredStats()
+	,mGame(game)
 	,mSpriteShader(nullptr)
+	,mSpriteVerts(nullptr)
 	,mMeshShader(nullptr)
 	,mSkinnedShader(nullptr)
+	,mWindow(nullptr)
+	,mContext(nullptr)
+	,mHeadless(false)
 	,mMirrorBuffer(0)
 	,mMirrorTexture(nullptr)
 	,mGBuffer(nullptr)
 	,mGGlobalShader(nullptr)
 	,mGPointLightShader(nullptr)
+	,mPointLightMesh(nullptr)
 {
 }
 
@@ -38,10 +69,20 @@ Renderer::~Renderer()
 {
 }
 
-bool Renderer::Initialize(float screenWidth, float screenHeight)
+bool Renderer::Initialize(float screenWidth, float screenHeight, bool headless)
 {
 	mScreenWidth = screenWidth;
 	mScreenHeight = screenHeight;
+	mHeadless = headless;
+
+	if (mHeadless)
+	{
+		// Still need view/projection for unprojecting (aiming)
+		mView = Matrix4::CreateLookAt(Vector3::Zero, Vector3::UnitX, Vector3::UnitZ);
+		mProjection = Matrix4::CreatePerspectiveFOV(Math::ToRadians(70.0f),
+			mScreenWidth, mScreenHeight, 10.0f, 10000.0f);
+		return true;
+	}
 
 	// Set OpenGL attributes
 	// Use the core OpenGL profile
@@ -132,9 +173,14 @@ void Renderer::Shutdown()
 		delete mGBuffer;
 	}
 	// Delete point lights
-	while (!mPointLights.empty())
+	while (mPointLights.GetSize() > 0)
+	{
+		delete mPointLights.GetDense().back();
+	}
+	// Nothing else was created without a GL context
+	if (mHeadless)
 	{
-		delete mPointLights.back();
+		return;
 	}
 	delete mSpriteVerts;
 	mSpriteShader->Unload();
@@ -166,6 +212,15 @@ void Renderer::UnloadData()
 
 void Renderer::Draw()
 {
+	if (mHeadless)
+	{
+		return;
+	}
+
+	// Each 3D pass adds its draws to these
+	mUnsortedStats = RenderQueue::Stats();
+	mDrawStats = RenderQueue::Stats();
+	mUnfilteredStats = RenderQueue::Stats();
 	// Draw to the mirror texture first
 	//Draw3DScene(mMirrorBuffer, mMirrorView, mProjection);
 	// Draw the 3D scene to the G-buffer
@@ -230,16 +285,16 @@ void Renderer::RemoveSprite(SpriteComponent* sprite)
 	mSprites.erase(iter);
 }
 
-void Renderer::AddMeshComp(MeshComponent* mesh)
+SlotHandle Renderer::AddMeshComp(MeshComponent* mesh)
 {
 	if (mesh->GetIsSkeletal())
 	{
 		SkeletalMeshComponent* sk = static_cast<SkeletalMeshComponent*>(mesh);
-		mSkeletalMeshes.emplace_back(sk);
+		return mSkeletalMeshes.Insert(sk);
 	}
 	else
 	{
-		mMeshComps.emplace_back(mesh);
+		return mMeshComps.Insert(mesh);
 	}
 }
 
@@ -247,31 +302,32 @@ void Renderer::RemoveMeshComp(MeshComponent* mesh)
 {
 	if (mesh->GetIsSkeletal())
 	{
-		SkeletalMeshComponent* sk = static_cast<SkeletalMeshComponent*>(mesh);
-		auto iter = std::find(mSkeletalMeshes.begin(), mSkeletalMeshes.end(), sk);
-		mSkeletalMeshes.erase(iter);
+		mSkeletalMeshes.Remove(mesh->GetRenderHandle());
 	}
 	else
 	{
-		auto iter = std::find(mMeshComps.begin(), mMeshComps.end(), mesh);
-		mMeshComps.erase(iter);
+		mMeshComps.Remove(mesh->GetRenderHandle());
 	}
 }
 
-void Renderer::AddPointLight(PointLightComponent * light)
+SlotHandle Renderer::AddPointLight(PointLightComponent * light)
 {
-	mPointLights.emplace_back(light);
+	return mPointLights.Insert(light);
 }
 
 void Renderer::RemovePointLight(PointLightComponent * light)
 {
-	auto iter = std::find(mPointLights.begin(), mPointLights.end(), light);
-	mPointLights.erase(iter);
+	mPointLights.Remove(light->GetRenderHandle());
 }
 
 Texture* Renderer::GetTexture(const std::string& fileName)
 {
 	Texture* tex = nullptr;
+	// Textures only exist on the GPU
+	if (mHeadless)
+	{
+		return tex;
+	}
 	auto iter = mTextures.find(fileName);
 	if (iter != mTextures.end())
 	{
@@ -319,6 +375,7 @@ Mesh* Renderer::GetMesh(const std::string & fileName)
 
 void Renderer::Draw3DScene(unsigned int framebuffer, const Matrix4& view, const Matrix4& proj, bool lit)
 {
+	PROFILE_SCOPE("Renderer::Draw3DScene");
 	// Set the current frame buffer
 	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 	// Clear color buffer/depth buffer
@@ -330,38 +387,81 @@ void Renderer::Draw3DScene(unsigned int framebuffer, const Matrix4& view, const
 	// Enable depth buffering/disable alpha blend
 	glEnable(GL_DEPTH_TEST);
 	glDisable(GL_BLEND);
-	// Set the mesh shader active
-	mMeshShader->SetActive();
-	// Update view-projection matrix
-	mMeshShader->SetMatrixUniform("uViewProj", view * proj);
-	// Update lighting uniforms
-	if (lit)
-	{
-		SetLightUniforms(mMeshShader, view);
-	}
-	for (auto mc : mMeshComps)
-	{
-		if (mc->GetVisible())
+
+	// Queue the visible meshes (skinned ones too), and sort them
+	// so the ones with the same state are drawn together
+	mRenderQueue.Clear();
+	mQueuedMeshes.clear();
+	auto submit = [this, &view](MeshComponent* mc, uint32_t shaderID) {
+		if (!mc->GetVisible() || !mc->GetMesh())
 		{
-			mc->Draw(mMeshShader);
+			return;
 		}
-	}
-
-	// Draw any skinned meshes now
-	mSkinnedShader->SetActive();
-	// Update view-projection matrix
-	mSkinnedShader->SetMatrixUniform("uViewProj", view * proj);
-	// Update lighting uniforms
-	if (lit)
+		Texture* t = mc->GetTexture();
+		VertexArray* va = mc->GetMesh()->GetVertexArray();
+		Vector3 pos = mc->GetOwner()->GetRenderTransform().GetTranslation();
+		float depth = Vector3::Transform(pos, view).z / cQueueDepthRange;
+		mRenderQueue.Submit(shaderID, t ? t->GetTextureID() : 0,
+			va->GetVertexArrayID(), depth,
+			static_cast<uint32_t>(mQueuedMeshes.size()));
+		mQueuedMeshes.emplace_back(mc);
+	};
+	for (auto mc : mMeshComps)
 	{
-		SetLightUniforms(mSkinnedShader, view);
+		submit(mc, cMeshShaderID);
 	}
 	for (auto sk : mSkeletalMeshes)
 	{
-		if (sk->GetVisible())
+		submit(sk, cSkinnedShaderID);
+	}
+	mUnsortedStats += mRenderQueue.CountStateChanges();
+	mRenderQueue.Sort();
+
+	// Only bind what isn't bound already
+	Shader* shader = nullptr;
+	Texture* texture = nullptr;
+	VertexArray* vertexArray = nullptr;
+	for (const RenderQueue::Item& item : mRenderQueue.GetItems())
+	{
+		MeshComponent* mc = mQueuedMeshes[item.mIndex];
+		Shader* itemShader = RenderQueue::GetShader(item.mKey) == cSkinnedShaderID ?
+			mSkinnedShader : mMeshShader;
+		if (itemShader != shader)
+		{
+			shader = itemShader;
+			shader->SetActive();
+			// Update view-projection matrix
+			shader->SetUniform(cViewProj, view * proj);
+			// Update lighting uniforms
+			if (lit)
+			{
+				SetLightUniforms(shader, view);
+			}
+			mDrawStats.mShaderBinds++;
+		}
+		// (Like Draw, a mesh without a texture uses whatever is bound)
+		Texture* t = mc->GetTexture();
+		// Without the checks, every draw would bind all of its state
+		mUnfilteredStats.mShaderBinds++;
+		mUnfilteredStats.mTextureBinds += t ? 1 : 0;
+		mUnfilteredStats.mVertexArrayBinds++;
+		mUnfilteredStats.mDraws++;
+		if (t && t != texture)
+		{
+			texture = t;
+			texture->SetActive();
+			mDrawStats.mTextureBinds++;
+		}
+		VertexArray* va = mc->GetMesh()->GetVertexArray();
+		if (va != vertexArray)
 		{
-			sk->Draw(mSkinnedShader);
+			vertexArray = va;
+			vertexArray->SetActive();
+			mDrawStats.mVertexArrayBinds++;
 		}
+		mc->SetDrawUniforms(shader);
+		glDrawElements(GL_TRIANGLES, va->GetNumIndices(), GL_UNSIGNED_INT, nullptr);
+		mDrawStats.mDraws++;
 	}
 }
 
@@ -407,6 +507,7 @@ bool Renderer::CreateMirrorTarget()
 
 void Renderer::DrawFromGBuffer()
 {
+	PROFILE_SCOPE("Renderer::DrawFromGBuffer");
 	// Clear the current framebuffer
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -440,8 +541,7 @@ void Renderer::DrawFromGBuffer()
 	mGPointLightShader->SetActive();
 	mPointLightMesh->GetVertexArray()->SetActive();
 	// Set the view-projection matrix
-	mGPointLightShader->SetMatrixUniform("uViewProj",
-		mView * mProjection);
+	mGPointLightShader->SetUniform(cViewProj, mView * mProjection);
 	// Set the G-buffer textures for sampling
 	mGBuffer->SetTexturesActive();
 
@@ -550,17 +650,14 @@ void Renderer::SetLightUniforms(Shader* shader, const Matrix4& view)
 {
 	// Camera position is from inverted view
 	Matrix4 invView = view;
-	invView.Invert();
-	shader->SetVectorUniform("uCameraPos", invView.GetTranslation());
+	invView.InvertRigid();
+	shader->SetUniform(cCameraPos, invView.GetTranslation());
 	// Ambient light
-	shader->SetVectorUniform("uAmbientLight", mAmbientLight);
+	shader->SetUniform(cAmbientLight, mAmbientLight);
 	// Directional light
-	shader->SetVectorUniform("uDirLight.mDirection",
-		mDirLight.mDirection);
-	shader->SetVectorUniform("uDirLight.mDiffuseColor",
-		mDirLight.mDiffuseColor);
-	shader->SetVectorUniform("uDirLight.mSpecColor",
-		mDirLight.mSpecColor);
+	shader->SetUniform(cDirLightDirection, mDirLight.mDirection);
+	shader->SetUniform(cDirLightDiffuse, mDirLight.mDiffuseColor);
+	shader->SetUniform(cDirLightSpec, mDirLight.mSpecColor);
 }
 
 Vector3 Renderer::Unproject(const Vector3& screenPoint) const
@@ -12,6 +12,8 @@
 #include <unordered_map>
 #include <SDL/SDL.h>
 #include "Math.h"
+#include "SlotMap.h"
+#include "RenderQueue.h"
 
 struct DirectionalLight
 {
@@ -29,7 +31,9 @@ public:
 	Renderer(class Game* game);
 	~Renderer();
 
-	bool Initialize(float screenWidth, float screenHeight);
+	// A headless renderer creates no window or GL context,
+	// and only loads the CPU-side data of meshes
+	bool Initialize(float screenWidth, float screenHeight, bool headless = false);
 	void Shutdown();
 	void UnloadData();
 
@@ -38,10 +42,10 @@ public:
 	void AddSprite(class SpriteComponent* sprite);
 	void RemoveSprite(class SpriteComponent* sprite);
 
-	void AddMeshComp(class MeshComponent* mesh);
+	SlotHandle AddMeshComp(class MeshComponent* mesh);
 	void RemoveMeshComp(class MeshComponent* mesh);
 
-	void AddPointLight(class PointLightComponent* light);
+	SlotHandle AddPointLight(class PointLightComponent* light);
 	void RemovePointLight(class PointLightComponent* light);
 
 	class Texture* GetTexture(const std::string& fileName);
@@ -52,7 +56,7 @@ public:
 	const Vector3& GetAmbientLight() const { return mAmbientLight; }
 	void SetAmbientLight(const Vector3& ambient) { mAmbientLight = ambient; }
 	DirectionalLight& GetDirectionalLight() { return mDirLight; }
-	const std::vector<class PointLightComponent*>& GetPointLights() const { return mPointLights; }
+	const std::vector<class PointLightComponent*>& GetPointLights() const { return mPointLights.GetDense(); }
 
 	// Given a screen space point, unprojects it into world space,
 	// based on the current 3D view/projection matrices
@@ -65,12 +69,21 @@ public:
 	// Gets start point and direction of screen vector
 	void GetScreenDirection(Vector3& outStart, Vector3& outDir) const;
 
+	bool IsHeadless() const { return mHeadless; }
+
 	float GetScreenWidth() const { return mScreenWidth; }
 	float GetScreenHeight() const { return mScreenHeight; }
 
 	void SetMirrorView(const Matrix4& view) { mMirrorView = view; }
 	class Texture* GetMirrorTexture() { return mMirrorTexture; }
 	class GBuffer* GetGBuffer() { return mGBuffer; }
+
+	// Last frame's mesh draws (over every pass): the binds they would
+	// have needed in the order the meshes were added, the binds once
+	// sorted, and the binds if nothing already bound were skipped
+	const RenderQueue::Stats& GetUnsortedDrawStats() const { return mUnsortedStats; }
+	const RenderQueue::Stats& GetDrawStats() const { return mDrawStats; }
+	const RenderQueue::Stats& GetUnfilteredDrawStats() const { return mUnfilteredStats; }
 private:
 	// Chapter 14 additions
 	void Draw3DScene(unsigned int framebuffer, const Matrix4& view, const Matrix4& proj, bool lit = true);
@@ -91,8 +104,14 @@ private:
 	std::vector<class SpriteComponent*> mSprites;
 
 	// All (non-skeletal) mesh components drawn
-	std::vector<class MeshComponent*> mMeshComps;
-	std::vector<class SkeletalMeshComponent*> mSkeletalMeshes;
+	SlotMap<class MeshComponent*> mMeshComps;
+	SlotMap<class SkeletalMeshComponent*> mSkeletalMeshes;
+	// This frame's visible meshes (items in mRenderQueue index this)
+	RenderQueue mRenderQueue;
+	std::vector<class MeshComponent*> mQueuedMeshes;
+	RenderQueue::Stats mUnsortedStats;
+	RenderQueue::Stats mDrawStats;
+	RenderQueue::Stats mUnfilteredStats;
 
 	// Game
 	class Game* mGame;
@@ -122,6 +141,8 @@ private:
 	// Width/height
 	float mScreenWidth;
 	float mScreenHeight;
+	// Whether there's no window/GL context
+	bool mHeadless;
 
 	unsigned int mMirrorBuffer;
 	class Texture* mMirrorTexture;
@@ -131,6 +152,6 @@ private:
 	// GBuffer shader
 	class Shader* mGGlobalShader;
 	class Shader* mGPointLightShader;
-	std::vector<class PointLightComponent*> mPointLights;
+	SlotMap<class PointLightComponent*> mPointLights;
 	class Mesh* mPointLightMesh;
 };
@@ -11,6 +11,50 @@
 #include <SDL/SDL.h>
 #include <fstream>
 #include <sstream>
+#include <map>
+
+namespace
+{
+	// Every uniform name (and type) given an ID, shared by all shaders
+	struct UniformRegistry
+	{
+		std::map<std::pair<std::string, GLenum>, int> mIDs;
+		std::vector<std::string> mNames;
+		std::vector<GLenum> mTypes;
+	};
+
+	UniformRegistry& GetRegistry()
+	{
+		static UniformRegistry registry;
+		return registry;
+	}
+
+	// Whether a uniform of type actual can be set as type expected
+	bool IsCompatible(GLenum expected, GLenum actual)
+	{
+		if (expected == actual)
+		{
+			return true;
+		}
+		// Samplers and bools are set as ints
+		if (expected == GL_INT)
+		{
+			switch (actual)
+			{
+			case GL_BOOL:
+			case GL_SAMPLER_2D:
+			case GL_SAMPLER_3D:
+			case GL_SAMPLER_CUBE:
+			case GL_SAMPLER_2D_SHADOW:
+			case GL_SAMPLER_2D_ARRAY:
+				return true;
+			default:
+				break;
+			}
+		}
+		return false;
+	}
+}
 
 Shader::Shader()
 	: mShaderProgram(0)
@@ -50,7 +94,9 @@ bool Shader::Load(const std::string& vertName, const std::string& fragName)
 	{
 		return false;
 	}
-	
+
+	// Find its uniforms now, rather than on each set
+	ReflectUniforms();
 	return true;
 }
 
@@ -60,6 +106,8 @@ void Shader::Unload()
 	glDeleteProgram(mShaderProgram);
 	glDeleteShader(mVertexShader);
 	glDeleteShader(mFragShader);
+	mUniforms.clear();
+	mSlots.clear();
 }
 
 void Shader::SetActive()
@@ -68,49 +116,153 @@ void Shader::SetActive()
 	glUseProgram(mShaderProgram);
 }
 
+void Shader::SetUniforms(const Uniform<Matrix4>& uniform, const Matrix4* matrices,
+	unsigned count)
+{
+	UniformSlot* slot = FindSlot(uniform.mID);
+	if (slot)
+	{
+		// Send the matrix data to the uniform
+		glUniformMatrix4fv(slot->mLocation, count, GL_TRUE, matrices->GetAsFloatPtr());
+		// Too big to keep a copy of, so always send it
+		slot->mHasValue = false;
+	}
+}
+
 void Shader::SetMatrixUniform(const char* name, const Matrix4& matrix)
 {
-	// Find the uniform by this name
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
-	// Send the matrix data to the uniform
-	glUniformMatrix4fv(loc, 1, GL_TRUE, matrix.GetAsFloatPtr());
+	SetUniform(GetUniform<Matrix4>(name), matrix);
 }
 
 void Shader::SetMatrixUniforms(const char* name, Matrix4* matrices, unsigned count)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
-	// Send the matrix data to the uniform
-	glUniformMatrix4fv(loc, count, GL_TRUE, matrices->GetAsFloatPtr());
+	SetUniforms(GetUniform<Matrix4>(name), matrices, count);
 }
 
 void Shader::SetVectorUniform(const char* name, const Vector3& vector)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
-	// Send the vector data
-	glUniform3fv(loc, 1, vector.GetAsFloatPtr());
+	SetUniform(GetUniform<Vector3>(name), vector);
 }
 
 void Shader::SetVector2Uniform(const char* name, const Vector2& vector)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
-	// Send the vector data
-	glUniform2fv(loc, 1, vector.GetAsFloatPtr());
+	SetUniform(GetUniform<Vector2>(name), vector);
 }
 
 void Shader::SetFloatUniform(const char* name, float value)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
-	// Send the float data
-	glUniform1f(loc, value);
+	SetUniform(GetUniform<float>(name), value);
 }
 
 void Shader::SetIntUniform(const char* name, int value)
 {
-	GLuint loc = glGetUniformLocation(mShaderProgram, name);
-	// Send the float data
+	SetUniform(GetUniform<int>(name), value);
+}
+
+int Shader::RegisterUniform(const char* name, GLenum type)
+{
+	UniformRegistry& registry = GetRegistry();
+	auto key = std::make_pair(std::string(name), type);
+	auto iter = registry.mIDs.find(key);
+	if (iter != registry.mIDs.end())
+	{
+		return iter->second;
+	}
+	int id = static_cast<int>(registry.mNames.size());
+	registry.mIDs.emplace(key, id);
+	registry.mNames.emplace_back(name);
+	registry.mTypes.emplace_back(type);
+	return id;
+}
+
+void Shader::Upload(GLint loc, const Matrix4& matrix)
+{
+	glUniformMatrix4fv(loc, 1, GL_TRUE, matrix.GetAsFloatPtr());
+}
+
+void Shader::Upload(GLint loc, const Vector3& vector)
+{
+	glUniform3fv(loc, 1, vector.GetAsFloatPtr());
+}
+
+void Shader::Upload(GLint loc, const Vector2& vector)
+{
+	glUniform2fv(loc, 1, vector.GetAsFloatPtr());
+}
+
+void Shader::Upload(GLint loc, float value)
+{
+	glUniform1f(loc, value);
+}
+
+void Shader::Upload(GLint loc, int value)
+{
 	glUniform1i(loc, value);
 }
 
+void Shader::ResolveSlots()
+{
+	const UniformRegistry& registry = GetRegistry();
+	for (size_t id = mSlots.size(); id < registry.mNames.size(); id++)
+	{
+		int index = -1;
+		for (size_t i = 0; i < mUniforms.size(); i++)
+		{
+			if (mUniforms[i].mName == registry.mNames[id])
+			{
+				if (IsCompatible(registry.mTypes[id], mUniforms[i].mType))
+				{
+					index = static_cast<int>(i);
+				}
+				else
+				{
+					SDL_Log("Uniform %s is set with the wrong type",
+						registry.mNames[id].c_str());
+				}
+				break;
+			}
+		}
+		mSlots.emplace_back(index);
+	}
+}
+
+void Shader::ReflectUniforms()
+{
+	mUniforms.clear();
+	mSlots.clear();
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(mShaderProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<char> name(maxLength + 1, '\0');
+	for (GLint i = 0; i < count; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = GL_NONE;
+		glGetActiveUniform(mShaderProgram, i, maxLength + 1, &length, &size,
+			&type, name.data());
+		GLint loc = glGetUniformLocation(mShaderProgram, name.data());
+		// Uniforms in blocks don't have a location
+		if (loc < 0)
+		{
+			continue;
+		}
+		UniformSlot slot;
+		slot.mName.assign(name.data(), length);
+		// Arrays are listed as their first element
+		if (slot.mName.size() > 3 &&
+			slot.mName.compare(slot.mName.size() - 3, 3, "[0]") == 0)
+		{
+			slot.mName.resize(slot.mName.size() - 3);
+		}
+		slot.mLocation = loc;
+		slot.mType = type;
+		slot.mHasValue = false;
+		mUniforms.emplace_back(slot);
+	}
+}
+
 bool Shader::CompileShader(const std::string& fileName,
 				   GLenum shaderType,
 				   GLuint& outShader)
@@ -9,17 +9,45 @@
 #pragma once
 #include <GL/glew.h>
 #include <string>
+#include <vector>
+#include <cstring>
 #include "Math.h"
 
 class Shader
 {
 public:
+	// Handle to a uniform, set with a value of type T. A handle is for
+	// a name rather than a shader, so it works with every shader that
+	// has the uniform (see GetUniform).
+	template <typename T>
+	struct Uniform
+	{
+		int mID;
+	};
+
 	Shader();
 	~Shader();
 	bool Load(const std::string& vertName, const std::string& fragName);
 	void Unload();
 	// Set this as the active shader program
 	void SetActive();
+
+	// Gets the handle for a uniform name. This looks up a string, so draw
+	// code should get its handles once and hold on to them.
+	template <typename T>
+	static Uniform<T> GetUniform(const char* name)
+	{
+		return Uniform<T>{ RegisterUniform(name, GetGLType(static_cast<const T*>(nullptr))) };
+	}
+	// Sets a uniform (this must be the active shader). Does nothing if
+	// the program doesn't have it, or if it's already set to value.
+	template <typename T>
+	void SetUniform(const Uniform<T>& uniform, const T& value);
+	// Sets an array of matrix uniforms (always sent)
+	void SetUniforms(const Uniform<Matrix4>& uniform, const Matrix4* matrices,
+		unsigned count);
+
+	// Same as above, but look up the name each call
 	// Sets a Matrix uniform
 	void SetMatrixUniform(const char* name, const Matrix4& matrix);
 	// Sets an array of matrix uniforms
@@ -32,11 +60,42 @@ public:
 	// Sets an integer uniform
 	void SetIntUniform(const char* name, int value);
 private:
+	// An active uniform of the linked program
+	struct UniformSlot
+	{
+		std::string mName;
+		GLint mLocation;
+		GLenum mType;
+		// Last value sent (if mHasValue), so the same one isn't sent again
+		float mValue[16];
+		bool mHasValue;
+	};
+
+	// Returns the ID for name and type, adding it if it's new
+	static int RegisterUniform(const char* name, GLenum type);
+	static GLenum GetGLType(const Matrix4*) { return GL_FLOAT_MAT4; }
+	static GLenum GetGLType(const Vector3*) { return GL_FLOAT_VEC3; }
+	static GLenum GetGLType(const Vector2*) { return GL_FLOAT_VEC2; }
+	static GLenum GetGLType(const float*) { return GL_FLOAT; }
+	static GLenum GetGLType(const int*) { return GL_INT; }
+	static void Upload(GLint loc, const Matrix4& matrix);
+	static void Upload(GLint loc, const Vector3& vector);
+	static void Upload(GLint loc, const Vector2& vector);
+	static void Upload(GLint loc, float value);
+	static void Upload(GLint loc, int value);
+
+	// The program's slot for a uniform ID (or null if it doesn't have it)
+	UniformSlot* FindSlot(int id);
+	// Maps the IDs registered since the last call to slots
+	void ResolveSlots();
+	// Fills mUniforms from the linked program
+	void ReflectUniforms();
+
 	// Tries to compile the specified shader
 	bool CompileShader(const std::string& fileName,
 					   GLenum shaderType,
 					   GLuint& outShader);
-	
+
 	// Tests whether shader compiled successfully
 	bool IsCompiled(GLuint shader);
 	// Tests whether vertex/fragment programs link
@@ -46,4 +105,32 @@ private:
 	GLuint mVertexShader;
 	GLuint mFragShader;
 	GLuint mShaderProgram;
+	// Active uniforms, found once when the program links
+	std::vector<UniformSlot> mUniforms;
+	// Index in mUniforms for each uniform ID (-1 if there's no such uniform)
+	std::vector<int> mSlots;
 };
+
+inline Shader::UniformSlot* Shader::FindSlot(int id)
+{
+	if (id >= static_cast<int>(mSlots.size()))
+	{
+		ResolveSlots();
+	}
+	int index = mSlots[id];
+	return index >= 0 ? &mUniforms[index] : nullptr;
+}
+
+template <typename T>
+void Shader::SetUniform(const Uniform<T>& uniform, const T& value)
+{
+	static_assert(sizeof(T) <= sizeof(UniformSlot::mValue), "Uniform type is too big");
+	UniformSlot* slot = FindSlot(uniform.mID);
+	if (slot && (!slot->mHasValue ||
+		memcmp(slot->mValue, &value, sizeof(T)) != 0))
+	{
+		memcpy(slot->mValue, &value, sizeof(T));
+		slot->mHasValue = true;
+		Upload(slot->mLocation, value);
+	}
+}
@@ -18,36 +18,30 @@
 #include "Skeleton.h"
 #include "LevelLoader.h"
 
+namespace
+{
+	const Shader::Uniform<Matrix4> cWorldTransform =
+		Shader::GetUniform<Matrix4>("uWorldTransform");
+	const Shader::Uniform<Matrix4> cMatrixPalette =
+		Shader::GetUniform<Matrix4>("uMatrixPalette");
+	const Shader::Uniform<float> cSpecPower = Shader::GetUniform<float>("uSpecPower");
+}
+
 SkeletalMeshComponent::SkeletalMeshComponent(Actor* owner)
 	:MeshComponent(owner, true)
 	,mSkeleton(nullptr)
 {
 }
 
-void SkeletalMeshComponent::Draw(Shader* shader)
+void SkeletalMeshComponent::SetDrawUniforms(Shader* shader)
 {
-	if (mMesh)
-	{
-		// Set the world transform
-		shader->SetMatrixUniform("uWorldTransform", 
-			mOwner->GetWorldTransform());
-		// Set the matrix palette
-		shader->SetMatrixUniforms("uMatrixPalette", &mPalette.mEntry[0], 
-			MAX_SKELETON_BONES);
-		// Set specular power
-		shader->SetFloatUniform("uSpecPower", mMesh->GetSpecPower());
-		// Set the active texture
-		Texture* t = mMesh->GetTexture(mTextureIndex);
-		if (t)
-		{
-			t->SetActive();
-		}
-		// Set the mesh's vertex array as active
-		VertexArray* va = mMesh->GetVertexArray();
-		va->SetActive();
-		// Draw
-		glDrawElements(GL_TRIANGLES, va->GetNumIndices(), GL_UNSIGNED_INT, nullptr);
-	}
+	// Set the world transform
+	shader->SetUniform(cWorldTransform, mOwner->GetRenderTransform());
+	// Set the matrix palette
+	shader->SetUniforms(cMatrixPalette, &mPalette.mEntry[0],
+		MAX_SKELETON_BONES);
+	// Set specular power
+	shader->SetUniform(cSpecPower, mMesh->GetSpecPower());
 }
 
 void SkeletalMeshComponent::Update(float deltaTime)
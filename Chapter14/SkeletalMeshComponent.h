@@ -14,10 +14,11 @@ class SkeletalMeshComponent : public MeshComponent
 {
 public:
 	SkeletalMeshComponent(class Actor* owner);
-	// Draw this mesh component
-	void Draw(class Shader* shader) override;
+	// Also sets the matrix palette
+	void SetDrawUniforms(class Shader* shader) override;
 
 	void Update(float deltaTime) override;
+	bool CanUpdateInParallel() const override { return true; }
 
 	// Setters
 	void SetSkeleton(class Skeleton* sk) { mSkeleton = sk; }
@@ -26,6 +27,7 @@ public:
 	float PlayAnimation(class Animation* anim, float playRate = 1.0f);
 
 	TypeID GetType() const override { return TSkeletalMeshComponent; }
+	COMPONENT_POOL(SkeletalMeshComponent)
 
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
@@ -111,6 +111,12 @@ bool Skeleton::Load(const std::string& fileName)
 	return true;
 }
 
+void Skeleton::SetBones(const std::vector<Bone>& bones)
+{
+	mBones = bones;
+	ComputeGlobalInvBindPose();
+}
+
 void Skeleton::ComputeGlobalInvBindPose()
 {
 	// Resize to number of bones, which automatically fills identity
@@ -129,9 +135,9 @@ void Skeleton::ComputeGlobalInvBindPose()
 		mGlobalInvBindPoses[i] = localMat * mGlobalInvBindPoses[mBones[i].mParent];
 	}
 
-	// Step 2: Invert
+	// Step 2: Invert (bone transforms have no scale, so these are rigid)
 	for (size_t i = 0; i < mGlobalInvBindPoses.size(); i++)
 	{
-		mGlobalInvBindPoses[i].Invert();
+		mGlobalInvBindPoses[i].InvertRigid();
 	}
 }
@@ -24,6 +24,8 @@ public:
 
 	// Load from a file
 	bool Load(const std::string& fileName);
+	// Or set up the bones directly (parents must come before children)
+	void SetBones(const std::vector<Bone>& bones);
 
 	// Getter functions
 	size_t GetNumBones() const { return mBones.size(); }
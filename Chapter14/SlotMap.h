@@ -0,0 +1,139 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Refers to an element in a SlotMap. Each slot's generation changes
+// when its element is removed, so an old handle no longer matches.
+struct SlotHandle
+{
+	SlotHandle()
+		:mIndex(UINT32_MAX)
+		,mGeneration(0)
+	{}
+	SlotHandle(uint32_t index, uint32_t generation)
+		:mIndex(index)
+		,mGeneration(generation)
+	{}
+
+	uint32_t mIndex;
+	uint32_t mGeneration;
+};
+
+// Values are kept packed in a vector for fast iteration, and handles
+// find them through an indirection table. Insert and Remove are O(1)
+// (Remove swaps the last value into the hole, so order isn't kept).
+template <typename T>
+class SlotMap
+{
+public:
+	SlotHandle Insert(const T& value)
+	{
+		uint32_t index;
+		if (!mFreeSlots.empty())
+		{
+			index = mFreeSlots.back();
+			mFreeSlots.pop_back();
+		}
+		else
+		{
+			index = static_cast<uint32_t>(mSlots.size());
+			mSlots.emplace_back();
+		}
+
+		Slot& slot = mSlots[index];
+		slot.mDenseIndex = static_cast<uint32_t>(mDense.size());
+		mDense.emplace_back(value);
+		mDenseToSlot.emplace_back(index);
+		return SlotHandle(index, slot.mGeneration);
+	}
+
+	// Returns false if the handle is stale
+	bool Remove(const SlotHandle& handle)
+	{
+		if (!IsValid(handle))
+		{
+			return false;
+		}
+
+		Slot& slot = mSlots[handle.mIndex];
+		uint32_t hole = slot.mDenseIndex;
+		uint32_t last = static_cast<uint32_t>(mDense.size()) - 1;
+		if (hole != last)
+		{
+			// Move the last value into the hole, and fix up its slot
+			mDense[hole] = std::move(mDense[last]);
+			mDenseToSlot[hole] = mDenseToSlot[last];
+			mSlots[mDenseToSlot[hole]].mDenseIndex = hole;
+		}
+		mDense.pop_back();
+		mDenseToSlot.pop_back();
+
+		slot.mDenseIndex = cNoValue;
+		slot.mGeneration++;
+		mFreeSlots.emplace_back(handle.mIndex);
+		return true;
+	}
+
+	void Clear()
+	{
+		for (uint32_t index : mDenseToSlot)
+		{
+			mSlots[index].mDenseIndex = cNoValue;
+			mSlots[index].mGeneration++;
+			mFreeSlots.emplace_back(index);
+		}
+		mDense.clear();
+		mDenseToSlot.clear();
+	}
+
+	bool IsValid(const SlotHandle& handle) const
+	{
+		return handle.mIndex < mSlots.size() &&
+			mSlots[handle.mIndex].mGeneration == handle.mGeneration &&
+			mSlots[handle.mIndex].mDenseIndex != cNoValue;
+	}
+
+	// Returns nullptr if the handle is stale
+	T* Get(const SlotHandle& handle)
+	{
+		return IsValid(handle) ? &mDense[mSlots[handle.mIndex].mDenseIndex] : nullptr;
+	}
+
+	// Packed values (in no particular order)
+	const std::vector<T>& GetDense() const { return mDense; }
+	size_t GetSize() const { return mDense.size(); }
+	T& operator[](size_t denseIndex) { return mDense[denseIndex]; }
+	typename std::vector<T>::iterator begin() { return mDense.begin(); }
+	typename std::vector<T>::iterator end() { return mDense.end(); }
+	typename std::vector<T>::const_iterator begin() const { return mDense.begin(); }
+	typename std::vector<T>::const_iterator end() const { return mDense.end(); }
+private:
+	static const uint32_t cNoValue = UINT32_MAX;
+
+	struct Slot
+	{
+		Slot()
+			:mDenseIndex(cNoValue)
+			,mGeneration(0)
+		{}
+		uint32_t mDenseIndex;
+		uint32_t mGeneration;
+	};
+
+	std::vector<Slot> mSlots;
+	// Slots free to reuse
+	std::vector<uint32_t> mFreeSlots;
+	std::vector<T> mDense;
+	// Which slot points at each packed value
+	std::vector<uint32_t> mDenseToSlot;
+};
@@ -0,0 +1,405 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "SpatialHash.h"
+#include <algorithm>
+
+namespace
+{
+	// Cell coordinates are clamped to 21 bits each, to fit in a key
+	const int cCellLimit = (1 << 20) - 1;
+	// Boxes covering more cells than this go in the oversized list
+	const size_t cMaxCellsPerBox = 64;
+
+	int ClampCell(float value)
+	{
+		float cell = Math::Clamp(value, static_cast<float>(-cCellLimit),
+			static_cast<float>(cCellLimit));
+		return static_cast<int>(std::floor(cell));
+	}
+}
+
+bool SpatialHash::CellRange::operator==(const CellRange& other) const
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (mMin[i] != other.mMin[i] || mMax[i] != other.mMax[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SpatialHash::CellRange::Contains(int x, int y, int z) const
+{
+	return x >= mMin[0] && x <= mMax[0] && y >= mMin[1] && y <= mMax[1] &&
+		z >= mMin[2] && z <= mMax[2];
+}
+
+size_t SpatialHash::CellRange::GetNumCells() const
+{
+	size_t count = 1;
+	for (int i = 0; i < 3; i++)
+	{
+		count *= static_cast<size_t>(mMax[i] - mMin[i] + 1);
+	}
+	return count;
+}
+
+SpatialHash::SpatialHash(float cellSize)
+	:mCellSize(cellSize)
+	,mInvCellSize(1.0f / cellSize)
+	,mBounds{ { 0, 0, 0 }, { -1, -1, -1 } }
+{
+}
+
+int SpatialHash::Add(const AABB& box, const SlotHandle& userData, bool isStatic)
+{
+	uint32_t index;
+	if (!mFreeProxies.empty())
+	{
+		index = mFreeProxies.back();
+		mFreeProxies.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(mProxies.size());
+		mProxies.emplace_back(Proxy{ box, userData, CellRange(), 1, UINT32_MAX,
+			false, false, false });
+	}
+
+	Proxy& p = mProxies[index];
+	p.mBox = box;
+	p.mUserData = userData;
+	p.mLayer = 1;
+	p.mMask = UINT32_MAX;
+	p.mStatic = isStatic;
+	p.mRemoved = false;
+	InsertProxy(index);
+	return static_cast<int>(index);
+}
+
+void SpatialHash::Remove(int proxy)
+{
+	uint32_t index = static_cast<uint32_t>(proxy);
+	RemoveProxy(index);
+	mProxies[index].mRemoved = true;
+	mFreeProxies.emplace_back(index);
+}
+
+void SpatialHash::Update(int proxy, const AABB& box)
+{
+	uint32_t index = static_cast<uint32_t>(proxy);
+	Proxy& p = mProxies[index];
+	p.mBox = box;
+	CellRange range = GetCellRange(box);
+	if (range == p.mCells)
+	{
+		return;
+	}
+
+	bool oversized = range.GetNumCells() > cMaxCellsPerBox;
+	if (oversized || p.mOversized)
+	{
+		RemoveProxy(index);
+		InsertProxy(index);
+	}
+	else
+	{
+		// Only the cells it left and the cells it entered
+		CellRange old = p.mCells;
+		p.mCells = range;
+		RemoveCells(index, old, &range);
+		InsertCells(index, range, &old);
+	}
+}
+
+void SpatialHash::SetStatic(int proxy, bool isStatic)
+{
+	mProxies[proxy].mStatic = isStatic;
+}
+
+void SpatialHash::SetFilter(int proxy, uint32_t layer, uint32_t mask)
+{
+	mProxies[proxy].mLayer = layer;
+	mProxies[proxy].mMask = mask;
+}
+
+void SpatialHash::SetCellSize(float cellSize)
+{
+	mCells.clear();
+	mOversized.clear();
+	mCellSize = cellSize;
+	mInvCellSize = 1.0f / cellSize;
+	mBounds = CellRange{ { 0, 0, 0 }, { -1, -1, -1 } };
+	for (uint32_t i = 0; i < mProxies.size(); i++)
+	{
+		if (!mProxies[i].mRemoved)
+		{
+			InsertProxy(i);
+		}
+	}
+}
+
+void SpatialHash::FindNearest(const Vector3& point, size_t k, float maxDist, uint32_t layer,
+	uint32_t mask, std::vector<SlotHandle>& outUserData) const
+{
+	outUserData.clear();
+	if (k == 0)
+	{
+		return;
+	}
+
+	// The k best so far, sorted by distance squared
+	std::vector<std::pair<float, uint32_t>> best;
+	float maxDistSq = maxDist * maxDist;
+	auto consider = [&](uint32_t index) {
+		if (!CanFind(mProxies[index], layer, mask))
+		{
+			return;
+		}
+		float distSq = mProxies[index].mBox.MinDistSq(point);
+		if (distSq > maxDistSq || (best.size() == k && distSq >= best.back().first))
+		{
+			return;
+		}
+		// A box is in several cells, so it can come up more than once
+		for (const auto& entry : best)
+		{
+			if (entry.second == index)
+			{
+				return;
+			}
+		}
+		if (best.size() == k)
+		{
+			best.pop_back();
+		}
+		auto pos = std::upper_bound(best.begin(), best.end(), std::make_pair(distSq, index));
+		best.insert(pos, std::make_pair(distSq, index));
+	};
+
+	for (uint32_t index : mOversized)
+	{
+		consider(index);
+	}
+
+	// Search shells of cells around the point's cell, moving out until
+	// nothing farther away could be closer than what's been found
+	int center[3];
+	int maxShell = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		center[i] = ClampCell(point.GetAsFloatPtr()[i] * mInvCellSize);
+		maxShell = Math::Max(maxShell, Math::Max(center[i] - mBounds.mMin[i],
+			mBounds.mMax[i] - center[i]));
+	}
+	for (int shell = 0; shell <= maxShell; shell++)
+	{
+		// Every cell in this shell is at least this far away
+		float shellDist = (shell - 1) * mCellSize;
+		if (shell > 0 && shellDist > maxDist)
+		{
+			break;
+		}
+		if (best.size() == k && shell > 0 && best.back().first <= shellDist * shellDist)
+		{
+			break;
+		}
+
+		// Once a shell has more cells than the map, just test the rest
+		size_t side = 2 * static_cast<size_t>(shell) + 1;
+		if (side * side * 6 > mCells.size())
+		{
+			for (uint32_t i = 0; i < mProxies.size(); i++)
+			{
+				if (!mProxies[i].mRemoved && !mProxies[i].mOversized)
+				{
+					consider(i);
+				}
+			}
+			break;
+		}
+
+		for (int x = center[0] - shell; x <= center[0] + shell; x++)
+		{
+			for (int y = center[1] - shell; y <= center[1] + shell; y++)
+			{
+				// Inside the shell, only the two z faces
+				bool onSide = x == center[0] - shell || x == center[0] + shell ||
+					y == center[1] - shell || y == center[1] + shell;
+				int zStep = onSide || shell == 0 ? 1 : 2 * shell;
+				for (int z = center[2] - shell; z <= center[2] + shell; z += zStep)
+				{
+					auto iter = mCells.find(CellKey(x, y, z));
+					if (iter != mCells.end())
+					{
+						for (uint32_t index : iter->second)
+						{
+							consider(index);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	for (const auto& entry : best)
+	{
+		outUserData.emplace_back(mProxies[entry.second].mUserData);
+	}
+}
+
+size_t SpatialHash::GetMemoryUsage() const
+{
+	size_t bytes = mProxies.capacity() * sizeof(Proxy) +
+		mFreeProxies.capacity() * sizeof(uint32_t) +
+		mOversized.capacity() * sizeof(uint32_t);
+	// A pointer per bucket, and a node per cell with a next pointer
+	bytes += mCells.bucket_count() * sizeof(void*);
+	for (const auto& cell : mCells)
+	{
+		bytes += sizeof(cell) + sizeof(void*) + cell.second.capacity() * sizeof(uint32_t);
+	}
+	return bytes;
+}
+
+uint64_t SpatialHash::CellKey(int x, int y, int z)
+{
+	const uint64_t cMask = (1 << 21) - 1;
+	return ((static_cast<uint64_t>(x + cCellLimit) & cMask) << 42) |
+		((static_cast<uint64_t>(y + cCellLimit) & cMask) << 21) |
+		(static_cast<uint64_t>(z + cCellLimit) & cMask);
+}
+
+void SpatialHash::CellFromKey(uint64_t key, int& outX, int& outY, int& outZ)
+{
+	const uint64_t cMask = (1 << 21) - 1;
+	outX = static_cast<int>((key >> 42) & cMask) - cCellLimit;
+	outY = static_cast<int>((key >> 21) & cMask) - cCellLimit;
+	outZ = static_cast<int>(key & cMask) - cCellLimit;
+}
+
+SpatialHash::CellRange SpatialHash::GetCellRange(const AABB& box) const
+{
+	CellRange range;
+	for (int i = 0; i < 3; i++)
+	{
+		range.mMin[i] = ClampCell(box.mMin.GetAsFloatPtr()[i] * mInvCellSize);
+		range.mMax[i] = ClampCell(box.mMax.GetAsFloatPtr()[i] * mInvCellSize);
+	}
+	return range;
+}
+
+bool SpatialHash::GetQueryRange(const AABB& box, CellRange& outRange) const
+{
+	// Nothing is outside the cells that have been used, so a query
+	// sticking out past them only needs the part inside
+	outRange = GetCellRange(box);
+	for (int i = 0; i < 3; i++)
+	{
+		outRange.mMin[i] = Math::Max(outRange.mMin[i], mBounds.mMin[i]);
+		outRange.mMax[i] = Math::Min(outRange.mMax[i], mBounds.mMax[i]);
+		if (outRange.mMin[i] > outRange.mMax[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void SpatialHash::InsertCells(uint32_t proxy, const CellRange& range, const CellRange* skip)
+{
+	for (int x = range.mMin[0]; x <= range.mMax[0]; x++)
+	{
+		for (int y = range.mMin[1]; y <= range.mMax[1]; y++)
+		{
+			for (int z = range.mMin[2]; z <= range.mMax[2]; z++)
+			{
+				if (!skip || !skip->Contains(x, y, z))
+				{
+					mCells[CellKey(x, y, z)].emplace_back(proxy);
+				}
+			}
+		}
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (mBounds.mMin[i] > mBounds.mMax[i])
+		{
+			mBounds = range;
+			break;
+		}
+		mBounds.mMin[i] = Math::Min(mBounds.mMin[i], range.mMin[i]);
+		mBounds.mMax[i] = Math::Max(mBounds.mMax[i], range.mMax[i]);
+	}
+}
+
+void SpatialHash::RemoveCells(uint32_t proxy, const CellRange& range, const CellRange* skip)
+{
+	for (int x = range.mMin[0]; x <= range.mMax[0]; x++)
+	{
+		for (int y = range.mMin[1]; y <= range.mMax[1]; y++)
+		{
+			for (int z = range.mMin[2]; z <= range.mMax[2]; z++)
+			{
+				if (skip && skip->Contains(x, y, z))
+				{
+					continue;
+				}
+				auto iter = mCells.find(CellKey(x, y, z));
+				if (iter == mCells.end())
+				{
+					continue;
+				}
+				std::vector<uint32_t>& proxies = iter->second;
+				auto pos = std::find(proxies.begin(), proxies.end(), proxy);
+				if (pos != proxies.end())
+				{
+					*pos = proxies.back();
+					proxies.pop_back();
+				}
+				// Don't keep empty cells around
+				if (proxies.empty())
+				{
+					mCells.erase(iter);
+				}
+			}
+		}
+	}
+}
+
+void SpatialHash::InsertProxy(uint32_t proxy)
+{
+	Proxy& p = mProxies[proxy];
+	p.mCells = GetCellRange(p.mBox);
+	p.mOversized = p.mCells.GetNumCells() > cMaxCellsPerBox;
+	if (p.mOversized)
+	{
+		mOversized.emplace_back(proxy);
+	}
+	else
+	{
+		InsertCells(proxy, p.mCells, nullptr);
+	}
+}
+
+void SpatialHash::RemoveProxy(uint32_t proxy)
+{
+	Proxy& p = mProxies[proxy];
+	if (p.mOversized)
+	{
+		mOversized.erase(std::find(mOversized.begin(), mOversized.end(), proxy));
+	}
+	else
+	{
+		RemoveCells(proxy, p.mCells, nullptr);
+	}
+}
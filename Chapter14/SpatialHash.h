@@ -0,0 +1,263 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include "Math.h"
+#include "Collision.h"
+#include "SlotMap.h"
+
+// Uniform grid of cubes, stored in a hash map so only cells with
+// something in them take up memory. Each box is in every cell it
+// touches (or, if that's too many cells, in a list that every query
+// checks). Works best when most boxes are about a cell in size.
+class SpatialHash
+{
+public:
+	SpatialHash(float cellSize);
+
+	// Returns the proxy for the box
+	int Add(const AABB& box, const SlotHandle& userData, bool isStatic);
+	void Remove(int proxy);
+	// Only touches the cells if the box moved into different ones
+	void Update(int proxy, const AABB& box);
+	// Pairs of static boxes aren't reported
+	void SetStatic(int proxy, bool isStatic);
+	// Two boxes are only paired if each one's layer is in the other's
+	// mask, and queries have a layer and mask of their own (by default
+	// every box is on layer 1 and takes every layer)
+	void SetFilter(int proxy, uint32_t layer, uint32_t mask);
+
+	// Puts every box in its new cells
+	void SetCellSize(float cellSize);
+	float GetCellSize() const { return mCellSize; }
+	size_t GetNumCells() const { return mCells.size(); }
+	// Bytes allocated (the cell map's is estimated)
+	size_t GetMemoryUsage() const;
+
+	// Calls func(userData) once for each box that overlaps
+	template <typename Func>
+	void QueryBox(const AABB& box, uint32_t layer, uint32_t mask, Func func) const;
+	template <typename Func>
+	void QuerySphere(const Sphere& sphere, uint32_t layer, uint32_t mask, Func func) const;
+	// Up to k boxes closest to point (measured to the nearest point of
+	// each box) and no farther than maxDist, nearest first
+	void FindNearest(const Vector3& point, size_t k, float maxDist, uint32_t layer,
+		uint32_t mask, std::vector<SlotHandle>& outUserData) const;
+	// Calls func(userDataA, userDataB) once for each overlapping pair
+	template <typename Func>
+	void ForEachPair(Func func) const;
+private:
+	// Inclusive range of cells on each axis
+	struct CellRange
+	{
+		int mMin[3];
+		int mMax[3];
+
+		bool operator==(const CellRange& other) const;
+		bool Contains(int x, int y, int z) const;
+		size_t GetNumCells() const;
+	};
+
+	struct Proxy
+	{
+		AABB mBox;
+		SlotHandle mUserData;
+		CellRange mCells;
+		uint32_t mLayer;
+		uint32_t mMask;
+		bool mStatic;
+		bool mOversized;
+		bool mRemoved;
+	};
+
+	// Whether the pair is worth testing at all
+	static bool CanCollide(const Proxy& a, const Proxy& b)
+	{
+		return !(a.mStatic && b.mStatic) && (a.mLayer & b.mMask) != 0 &&
+			(b.mLayer & a.mMask) != 0;
+	}
+	// Whether a query with this layer and mask can find the box
+	static bool CanFind(const Proxy& p, uint32_t layer, uint32_t mask)
+	{
+		return (p.mLayer & mask) != 0 && (layer & p.mMask) != 0;
+	}
+
+	static uint64_t CellKey(int x, int y, int z);
+	static void CellFromKey(uint64_t key, int& outX, int& outY, int& outZ);
+	CellRange GetCellRange(const AABB& box) const;
+	// Cells of box that could have anything in them (false if none)
+	bool GetQueryRange(const AABB& box, CellRange& outRange) const;
+	void InsertCells(uint32_t proxy, const CellRange& range, const CellRange* skip);
+	void RemoveCells(uint32_t proxy, const CellRange& range, const CellRange* skip);
+	void InsertProxy(uint32_t proxy);
+	void RemoveProxy(uint32_t proxy);
+
+	// A box found in cell (x, y, z) is also in the cells next to it, so
+	// only report it from the first cell it shares with the query
+	static bool IsFirstCell(const CellRange& a, const CellRange& b, int x, int y, int z);
+	// Calls func(cellX, cellY, cellZ, proxies) for each cell in range
+	template <typename Func>
+	void ForEachCell(const CellRange& range, Func func) const;
+
+	std::vector<Proxy> mProxies;
+	std::vector<uint32_t> mFreeProxies;
+	std::unordered_map<uint64_t, std::vector<uint32_t>> mCells;
+	// Boxes that cover too many cells
+	std::vector<uint32_t> mOversized;
+	float mCellSize;
+	float mInvCellSize;
+	// Cells that have ever had something in them
+	CellRange mBounds;
+};
+
+inline bool SpatialHash::IsFirstCell(const CellRange& a, const CellRange& b, int x, int y, int z)
+{
+	return Math::Max(a.mMin[0], b.mMin[0]) == x &&
+		Math::Max(a.mMin[1], b.mMin[1]) == y &&
+		Math::Max(a.mMin[2], b.mMin[2]) == z;
+}
+
+template <typename Func>
+void SpatialHash::ForEachCell(const CellRange& range, Func func) const
+{
+	// A big range can have far more cells than there are in the map
+	if (range.GetNumCells() > mCells.size())
+	{
+		for (const auto& cell : mCells)
+		{
+			int x, y, z;
+			CellFromKey(cell.first, x, y, z);
+			if (range.Contains(x, y, z))
+			{
+				func(x, y, z, cell.second);
+			}
+		}
+		return;
+	}
+
+	for (int x = range.mMin[0]; x <= range.mMax[0]; x++)
+	{
+		for (int y = range.mMin[1]; y <= range.mMax[1]; y++)
+		{
+			for (int z = range.mMin[2]; z <= range.mMax[2]; z++)
+			{
+				auto iter = mCells.find(CellKey(x, y, z));
+				if (iter != mCells.end())
+				{
+					func(x, y, z, iter->second);
+				}
+			}
+		}
+	}
+}
+
+template <typename Func>
+void SpatialHash::QueryBox(const AABB& box, uint32_t layer, uint32_t mask, Func func) const
+{
+	CellRange range;
+	if (GetQueryRange(box, range))
+	{
+		ForEachCell(range, [&](int x, int y, int z, const std::vector<uint32_t>& proxies) {
+			for (uint32_t index : proxies)
+			{
+				const Proxy& p = mProxies[index];
+				if (IsFirstCell(p.mCells, range, x, y, z) && CanFind(p, layer, mask) &&
+					Intersect(p.mBox, box))
+				{
+					func(p.mUserData);
+				}
+			}
+		});
+	}
+	for (uint32_t index : mOversized)
+	{
+		const Proxy& p = mProxies[index];
+		if (CanFind(p, layer, mask) && Intersect(p.mBox, box))
+		{
+			func(p.mUserData);
+		}
+	}
+}
+
+template <typename Func>
+void SpatialHash::QuerySphere(const Sphere& sphere, uint32_t layer, uint32_t mask,
+	Func func) const
+{
+	Vector3 radius(sphere.mRadius, sphere.mRadius, sphere.mRadius);
+	AABB bounds(sphere.mCenter - radius, sphere.mCenter + radius);
+	CellRange range;
+	if (GetQueryRange(bounds, range))
+	{
+		ForEachCell(range, [&](int x, int y, int z, const std::vector<uint32_t>& proxies) {
+			for (uint32_t index : proxies)
+			{
+				const Proxy& p = mProxies[index];
+				if (IsFirstCell(p.mCells, range, x, y, z) && CanFind(p, layer, mask) &&
+					Intersect(sphere, p.mBox))
+				{
+					func(p.mUserData);
+				}
+			}
+		});
+	}
+	for (uint32_t index : mOversized)
+	{
+		const Proxy& p = mProxies[index];
+		if (CanFind(p, layer, mask) && Intersect(sphere, p.mBox))
+		{
+			func(p.mUserData);
+		}
+	}
+}
+
+template <typename Func>
+void SpatialHash::ForEachPair(Func func) const
+{
+	for (const auto& cell : mCells)
+	{
+		int x, y, z;
+		CellFromKey(cell.first, x, y, z);
+		const std::vector<uint32_t>& proxies = cell.second;
+		for (size_t i = 0; i < proxies.size(); i++)
+		{
+			const Proxy& a = mProxies[proxies[i]];
+			for (size_t j = i + 1; j < proxies.size(); j++)
+			{
+				const Proxy& b = mProxies[proxies[j]];
+				if (CanCollide(a, b) && IsFirstCell(a.mCells, b.mCells, x, y, z) &&
+					Intersect(a.mBox, b.mBox))
+				{
+					func(a.mUserData, b.mUserData);
+				}
+			}
+		}
+	}
+
+	// Oversized boxes against everything (and each other once)
+	for (size_t i = 0; i < mOversized.size(); i++)
+	{
+		const Proxy& a = mProxies[mOversized[i]];
+		for (size_t j = 0; j < mProxies.size(); j++)
+		{
+			const Proxy& b = mProxies[j];
+			if (b.mRemoved || (b.mOversized && j <= mOversized[i]) ||
+				!CanCollide(a, b))
+			{
+				continue;
+			}
+			if (Intersect(a.mBox, b.mBox))
+			{
+				func(a.mUserData, b.mUserData);
+			}
+		}
+	}
+}
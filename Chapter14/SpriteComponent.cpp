@@ -14,6 +14,12 @@
 #include "Renderer.h"
 #include "LevelLoader.h"
 
+namespace
+{
+	const Shader::Uniform<Matrix4> cWorldTransform =
+		Shader::GetUniform<Matrix4>("uWorldTransform");
+}
+
 SpriteComponent::SpriteComponent(Actor* owner, int drawOrder)
 	:Component(owner)
 	,mTexture(nullptr)
@@ -40,13 +46,13 @@ void SpriteComponent::Draw(Shader* shader)
 			static_cast<float>(mTexHeight),
 			1.0f);
 		
-		Matrix4 world = scaleMat * mOwner->GetWorldTransform();
+		Matrix4 world = scaleMat * mOwner->GetRenderTransform();
 		
 		// Since all sprites use the same shader/vertices,
 		// the game first sets them active before any sprite draws
 		
 		// Set world transform
-		shader->SetMatrixUniform("uWorldTransform", world);
+		shader->SetUniform(cWorldTransform, world);
 		// Set current texture
 		mTexture->SetActive();
 		// Draw quad
@@ -28,6 +28,7 @@ public:
 	bool GetVisible() const { return mVisible; }
 
 	TypeID GetType() const override { return TSpriteComponent; }
+	COMPONENT_POOL(SpriteComponent)
 
 	void LoadProperties(const rapidjson::Value& inObj) override;
 	void SaveProperties(rapidjson::Document::AllocatorType& alloc,
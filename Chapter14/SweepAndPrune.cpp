@@ -0,0 +1,432 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "SweepAndPrune.h"
+#include <algorithm>
+
+namespace
+{
+	// Marks a proxy whose endpoints aren't in the lists yet
+	const uint32_t cNotPlaced = UINT32_MAX;
+}
+
+SweepAndPrune::SweepAndPrune(bool threeAxes)
+	:mNumAxes(threeAxes ? 3 : 1)
+	,mNumAdded(0)
+	,mNeedsRebuild(false)
+	,mNumSwaps(0)
+{
+}
+
+int SweepAndPrune::Add(const AABB& box, const SlotHandle& userData, bool isStatic)
+{
+	uint32_t index;
+	if (!mFreeProxies.empty())
+	{
+		index = mFreeProxies.back();
+		mFreeProxies.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(mProxies.size());
+		mProxies.emplace_back(Proxy{ box, userData, {}, {}, 1, UINT32_MAX, false, false });
+	}
+
+	Proxy& proxy = mProxies[index];
+	proxy.mBox = box;
+	proxy.mUserData = userData;
+	proxy.mLayer = 1;
+	proxy.mMask = UINT32_MAX;
+	proxy.mStatic = isStatic;
+	proxy.mRemoved = false;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		proxy.mMin[axis] = cNotPlaced;
+		proxy.mMax[axis] = cNotPlaced;
+	}
+	// The endpoints go in at the next Sync
+	mPending.emplace_back(index);
+	mNumAdded++;
+	return static_cast<int>(index);
+}
+
+void SweepAndPrune::Remove(int proxy)
+{
+	uint32_t index = static_cast<uint32_t>(proxy);
+	RemovePairsWith(index, false);
+	Proxy& p = mProxies[index];
+	p.mRemoved = true;
+	// Its endpoints sort to the end of the lists, where Sync drops
+	// them (and then frees the proxy)
+	p.mBox = AABB(Vector3::Infinity, Vector3::Infinity);
+	// (If it was never placed, it's already pending)
+	if (p.mMin[0] != cNotPlaced)
+	{
+		SetEndpoints(index);
+		mPending.emplace_back(index);
+	}
+}
+
+void SweepAndPrune::Update(int proxy, const AABB& box)
+{
+	mProxies[proxy].mBox = box;
+	SetEndpoints(static_cast<uint32_t>(proxy));
+}
+
+void SweepAndPrune::SetStatic(int proxy, bool isStatic)
+{
+	Proxy& p = mProxies[proxy];
+	if (p.mStatic == isStatic)
+	{
+		return;
+	}
+
+	p.mStatic = isStatic;
+	if (isStatic)
+	{
+		RemovePairsWith(static_cast<uint32_t>(proxy), true);
+	}
+	else if (mNumAxes == 3)
+	{
+		// Pairs with static boxes that were never kept
+		mNeedsRebuild = true;
+	}
+}
+
+void SweepAndPrune::SetFilter(int proxy, uint32_t layer, uint32_t mask)
+{
+	Proxy& p = mProxies[proxy];
+	if (p.mLayer == layer && p.mMask == mask)
+	{
+		return;
+	}
+
+	p.mLayer = layer;
+	p.mMask = mask;
+	if (mNumAxes == 3)
+	{
+		// Its pairs could go either way, so find them again
+		RemovePairsWith(static_cast<uint32_t>(proxy), false);
+		mNeedsRebuild = true;
+	}
+}
+
+void SweepAndPrune::SetThreeAxes(bool threeAxes)
+{
+	int numAxes = threeAxes ? 3 : 1;
+	if (numAxes != mNumAxes)
+	{
+		// Right away, since Update needs the lists for every axis
+		mNumAxes = numAxes;
+		Rebuild();
+	}
+}
+
+void SweepAndPrune::Sync()
+{
+	mNumSwaps = 0;
+	// Sorting in lots of new boxes one at a time is O(n^2), so then
+	// start over instead (as for the first Sync)
+	if (mNeedsRebuild || mNumAdded * 8 > mProxies.size())
+	{
+		Rebuild();
+	}
+	else
+	{
+		// New boxes go at the end, and are sorted in from there
+		for (uint32_t index : mPending)
+		{
+			Proxy& p = mProxies[index];
+			if (p.mRemoved || p.mMin[0] != cNotPlaced)
+			{
+				continue;
+			}
+			for (int axis = 0; axis < mNumAxes; axis++)
+			{
+				std::vector<Endpoint>& endpoints = mEndpoints[axis];
+				p.mMin[axis] = static_cast<uint32_t>(endpoints.size());
+				endpoints.emplace_back(Endpoint{ p.mBox.mMin.GetAsFloatPtr()[axis], index << 1 });
+				p.mMax[axis] = static_cast<uint32_t>(endpoints.size());
+				endpoints.emplace_back(Endpoint{ p.mBox.mMax.GetAsFloatPtr()[axis], (index << 1) | 1 });
+			}
+		}
+
+		for (int axis = 0; axis < mNumAxes; axis++)
+		{
+			InsertionSort(axis);
+			// Removed boxes are now all at the end
+			std::vector<Endpoint>& endpoints = mEndpoints[axis];
+			while (!endpoints.empty() && mProxies[endpoints.back().GetProxy()].mRemoved)
+			{
+				endpoints.pop_back();
+			}
+		}
+	}
+
+	for (uint32_t index : mPending)
+	{
+		if (mProxies[index].mRemoved)
+		{
+			mFreeProxies.emplace_back(index);
+		}
+	}
+	mPending.clear();
+	mNumAdded = 0;
+
+	if (mNumAxes != 3)
+	{
+		GatherSortedBoxes();
+	}
+}
+
+void SweepAndPrune::GatherSortedBoxes()
+{
+	// Reading these in order is much faster than going through the
+	// proxies for every test
+	mSortedBoxes.clear();
+	for (const Endpoint& e : mEndpoints[0])
+	{
+		if (!e.IsMax())
+		{
+			const Proxy& p = mProxies[e.GetProxy()];
+			mSortedBoxes.emplace_back(SortedBox{ p.mBox, e.GetProxy(), p.mLayer, p.mMask,
+				p.mStatic });
+		}
+	}
+}
+
+size_t SweepAndPrune::GetMemoryUsage() const
+{
+	size_t bytes = mProxies.capacity() * sizeof(Proxy) +
+		mFreeProxies.capacity() * sizeof(uint32_t) +
+		mPairs.capacity() * sizeof(Pair) +
+		mSortedBoxes.capacity() * sizeof(SortedBox) +
+		mPending.capacity() * sizeof(uint32_t);
+	for (const std::vector<Endpoint>& endpoints : mEndpoints)
+	{
+		bytes += endpoints.capacity() * sizeof(Endpoint);
+	}
+	// A pointer per bucket, and a node per pair with a next pointer
+	bytes += mPairIndices.bucket_count() * sizeof(void*) + mPairIndices.size() *
+		(sizeof(std::pair<const uint64_t, uint32_t>) + sizeof(void*));
+	return bytes;
+}
+
+uint64_t SweepAndPrune::PairKey(uint32_t a, uint32_t b)
+{
+	if (a > b)
+	{
+		std::swap(a, b);
+	}
+	return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+void SweepAndPrune::SetEndpoints(uint32_t index)
+{
+	Proxy& p = mProxies[index];
+	if (p.mMin[0] == cNotPlaced)
+	{
+		return;
+	}
+
+	for (int axis = 0; axis < mNumAxes; axis++)
+	{
+		mEndpoints[axis][p.mMin[axis]].mValue = p.mBox.mMin.GetAsFloatPtr()[axis];
+		mEndpoints[axis][p.mMax[axis]].mValue = p.mBox.mMax.GetAsFloatPtr()[axis];
+	}
+}
+
+void SweepAndPrune::InsertionSort(int axis)
+{
+	std::vector<Endpoint>& endpoints = mEndpoints[axis];
+	for (size_t i = 1; i < endpoints.size(); i++)
+	{
+		Endpoint e = endpoints[i];
+		if (!Less(e, endpoints[i - 1]))
+		{
+			continue;
+		}
+
+		uint32_t pe = e.GetProxy();
+		// Only three axes keep pairs
+		bool trackPairs = mNumAxes == 3 && !mProxies[pe].mRemoved;
+		size_t j = i;
+		do
+		{
+			// e moves down past f
+			const Endpoint& f = endpoints[j - 1];
+			uint32_t pf = f.GetProxy();
+			Proxy& proxyF = mProxies[pf];
+			if (trackPairs && e.IsMax() != f.IsMax() && !proxyF.mRemoved)
+			{
+				if (e.IsMax())
+				{
+					// e's max is now below f's min
+					RemovePair(pe, pf);
+				}
+				else
+				{
+					// e's min is now below f's max
+					BeginOverlap(pe, pf);
+				}
+			}
+
+			if (f.IsMax())
+			{
+				proxyF.mMax[axis] = static_cast<uint32_t>(j);
+			}
+			else
+			{
+				proxyF.mMin[axis] = static_cast<uint32_t>(j);
+			}
+			endpoints[j] = f;
+			j--;
+			mNumSwaps++;
+		} while (j > 0 && Less(e, endpoints[j - 1]));
+
+		endpoints[j] = e;
+		if (e.IsMax())
+		{
+			mProxies[pe].mMax[axis] = static_cast<uint32_t>(j);
+		}
+		else
+		{
+			mProxies[pe].mMin[axis] = static_cast<uint32_t>(j);
+		}
+	}
+}
+
+void SweepAndPrune::Rebuild()
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		std::vector<Endpoint>& endpoints = mEndpoints[axis];
+		endpoints.clear();
+		if (axis >= mNumAxes)
+		{
+			continue;
+		}
+
+		for (uint32_t i = 0; i < mProxies.size(); i++)
+		{
+			const Proxy& p = mProxies[i];
+			if (!p.mRemoved)
+			{
+				endpoints.emplace_back(Endpoint{ p.mBox.mMin.GetAsFloatPtr()[axis], i << 1 });
+				endpoints.emplace_back(Endpoint{ p.mBox.mMax.GetAsFloatPtr()[axis], (i << 1) | 1 });
+			}
+		}
+		std::sort(endpoints.begin(), endpoints.end(), Less);
+		for (uint32_t j = 0; j < endpoints.size(); j++)
+		{
+			Proxy& p = mProxies[endpoints[j].GetProxy()];
+			if (endpoints[j].IsMax())
+			{
+				p.mMax[axis] = j;
+			}
+			else
+			{
+				p.mMin[axis] = j;
+			}
+		}
+	}
+
+	mPairs.clear();
+	mPairIndices.clear();
+	mNeedsRebuild = false;
+	if (mNumAxes != 3)
+	{
+		return;
+	}
+
+	// Sweep along x, keeping a list of the boxes we're inside of
+	std::vector<uint32_t> active;
+	std::vector<uint32_t> activeSlot(mProxies.size());
+	for (const Endpoint& e : mEndpoints[0])
+	{
+		uint32_t index = e.GetProxy();
+		if (!e.IsMax())
+		{
+			for (uint32_t other : active)
+			{
+				BeginOverlap(index, other);
+			}
+			activeSlot[index] = static_cast<uint32_t>(active.size());
+			active.emplace_back(index);
+		}
+		else
+		{
+			// Swap the last active box into this one's place
+			uint32_t slot = activeSlot[index];
+			active[slot] = active.back();
+			activeSlot[active[slot]] = slot;
+			active.pop_back();
+		}
+	}
+}
+
+void SweepAndPrune::BeginOverlap(uint32_t a, uint32_t b)
+{
+	const Proxy& pa = mProxies[a];
+	const Proxy& pb = mProxies[b];
+	if (!CanCollide(pa, pb))
+	{
+		return;
+	}
+	// With three axes, only keep pairs that overlap on all of them
+	if (mNumAxes == 3 && !Intersect(pa.mBox, pb.mBox))
+	{
+		return;
+	}
+	AddPair(a, b);
+}
+
+void SweepAndPrune::AddPair(uint32_t a, uint32_t b)
+{
+	auto result = mPairIndices.emplace(PairKey(a, b), static_cast<uint32_t>(mPairs.size()));
+	if (result.second)
+	{
+		mPairs.emplace_back(Pair{ a, b });
+	}
+}
+
+void SweepAndPrune::RemovePair(uint32_t a, uint32_t b)
+{
+	auto iter = mPairIndices.find(PairKey(a, b));
+	if (iter == mPairIndices.end())
+	{
+		return;
+	}
+
+	// Move the last pair into the hole
+	uint32_t hole = iter->second;
+	mPairIndices.erase(iter);
+	if (hole != mPairs.size() - 1)
+	{
+		mPairs[hole] = mPairs.back();
+		mPairIndices[PairKey(mPairs[hole].mA, mPairs[hole].mB)] = hole;
+	}
+	mPairs.pop_back();
+}
+
+void SweepAndPrune::RemovePairsWith(uint32_t proxy, bool onlyStatic)
+{
+	for (size_t i = mPairs.size(); i > 0; i--)
+	{
+		Pair pair = mPairs[i - 1];
+		if (pair.mA != proxy && pair.mB != proxy)
+		{
+			continue;
+		}
+		uint32_t other = pair.mA == proxy ? pair.mB : pair.mA;
+		if (!onlyStatic || mProxies[other].mStatic)
+		{
+			RemovePair(pair.mA, pair.mB);
+		}
+	}
+}
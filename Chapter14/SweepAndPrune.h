@@ -0,0 +1,172 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include "Math.h"
+#include "Collision.h"
+#include "SlotMap.h"
+
+// Persistent sweep and prune. The box endpoints stay sorted between
+// calls to Sync, which fixes them up with an insertion sort (cheap,
+// since boxes barely move from one frame to the next).
+//
+// With three axes, all of them are sorted. Each swap of a min and a
+// max is where two boxes start or stop overlapping on that axis, so
+// the overlapping pairs are kept up to date as it sorts. With one,
+// only x is sorted, and ForEachPair sweeps it to find the pairs (a
+// set of pairs that only overlap on x would be far too big to keep).
+class SweepAndPrune
+{
+public:
+	SweepAndPrune(bool threeAxes);
+
+	// Returns the proxy for the box
+	int Add(const AABB& box, const SlotHandle& userData, bool isStatic);
+	void Remove(int proxy);
+	// Takes effect at the next Sync
+	void Update(int proxy, const AABB& box);
+	// Pairs of static boxes aren't kept
+	void SetStatic(int proxy, bool isStatic);
+	// Two boxes are only paired if each one's layer is in the other's
+	// mask (by default every box is on layer 1 and takes every layer)
+	void SetFilter(int proxy, uint32_t layer, uint32_t mask);
+	void SetThreeAxes(bool threeAxes);
+	bool GetThreeAxes() const { return mNumAxes == 3; }
+
+	// Sorts the endpoints and updates the pairs
+	void Sync();
+
+	// Calls func(userDataA, userDataB) for each overlapping pair
+	// (as of the last Sync)
+	template <typename Func>
+	void ForEachPair(Func func) const;
+
+	// Pairs kept between calls (only with three axes)
+	size_t GetNumPairs() const { return mPairs.size(); }
+	// Endpoint swaps in the last Sync (0 if it rebuilt instead)
+	size_t GetNumSwaps() const { return mNumSwaps; }
+	// Bytes allocated (the pair map's is estimated)
+	size_t GetMemoryUsage() const;
+private:
+	struct Proxy
+	{
+		AABB mBox;
+		SlotHandle mUserData;
+		// Where this proxy's endpoints are on each axis
+		uint32_t mMin[3];
+		uint32_t mMax[3];
+		uint32_t mLayer;
+		uint32_t mMask;
+		bool mStatic;
+		bool mRemoved;
+	};
+
+	struct Endpoint
+	{
+		float mValue;
+		// Proxy index << 1, plus 1 for a max
+		uint32_t mData;
+
+		uint32_t GetProxy() const { return mData >> 1; }
+		bool IsMax() const { return (mData & 1) != 0; }
+	};
+
+	struct Pair
+	{
+		uint32_t mA;
+		uint32_t mB;
+	};
+
+	// Copy of a box, in order of min.x
+	struct SortedBox
+	{
+		AABB mBox;
+		uint32_t mProxy;
+		uint32_t mLayer;
+		uint32_t mMask;
+		bool mStatic;
+	};
+
+	// Mins sort before maxes with the same value, so touching boxes
+	// overlap (the same as Intersect)
+	static bool Less(const Endpoint& a, const Endpoint& b)
+	{
+		return a.mValue < b.mValue || (a.mValue == b.mValue && !a.IsMax() && b.IsMax());
+	}
+	static uint64_t PairKey(uint32_t a, uint32_t b);
+	// Whether the pair is worth testing at all
+	template <typename T>
+	static bool CanCollide(const T& a, const T& b)
+	{
+		return !(a.mStatic && b.mStatic) && (a.mLayer & b.mMask) != 0 &&
+			(b.mLayer & a.mMask) != 0;
+	}
+
+	void SetEndpoints(uint32_t proxy);
+	void InsertionSort(int axis);
+	// Copies the boxes in x order, for ForEachPair with one axis
+	void GatherSortedBoxes();
+	// Sorts everything from scratch, and finds the pairs with one sweep
+	void Rebuild();
+	void BeginOverlap(uint32_t a, uint32_t b);
+	void AddPair(uint32_t a, uint32_t b);
+	void RemovePair(uint32_t a, uint32_t b);
+	// Removes every pair with this proxy (and, if onlyStatic is set,
+	// another static proxy)
+	void RemovePairsWith(uint32_t proxy, bool onlyStatic);
+
+	std::vector<Proxy> mProxies;
+	std::vector<uint32_t> mFreeProxies;
+	std::vector<Endpoint> mEndpoints[3];
+	std::vector<Pair> mPairs;
+	std::vector<SortedBox> mSortedBoxes;
+	// Index of each pair in mPairs
+	std::unordered_map<uint64_t, uint32_t> mPairIndices;
+	int mNumAxes;
+	// Proxies added since the last Sync, and those whose endpoints
+	// haven't been placed yet
+	size_t mNumAdded;
+	std::vector<uint32_t> mPending;
+	bool mNeedsRebuild;
+	size_t mNumSwaps;
+};
+
+template <typename Func>
+void SweepAndPrune::ForEachPair(Func func) const
+{
+	if (mNumAxes == 3)
+	{
+		for (const Pair& pair : mPairs)
+		{
+			func(mProxies[pair.mA].mUserData, mProxies[pair.mB].mUserData);
+		}
+		return;
+	}
+
+	// Each box against the boxes that start between its min and max
+	for (size_t i = 0; i < mSortedBoxes.size(); i++)
+	{
+		const SortedBox& a = mSortedBoxes[i];
+		for (size_t j = i + 1; j < mSortedBoxes.size(); j++)
+		{
+			const SortedBox& b = mSortedBoxes[j];
+			if (b.mBox.mMin.x > a.mBox.mMax.x)
+			{
+				break;
+			}
+			else if (CanCollide(a, b) && Intersect(a.mBox, b.mBox))
+			{
+				func(mProxies[a.mProxy].mUserData, mProxies[b.mProxy].mUserData);
+			}
+		}
+	}
+}
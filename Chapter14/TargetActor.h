@@ -14,4 +14,5 @@ class TargetActor : public Actor
 public:
 	TargetActor(class Game* game);
 	TypeID GetType() const override { return TTargetActor; }
+	ACTOR_POOL(TargetActor)
 };
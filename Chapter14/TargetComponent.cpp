@@ -18,7 +18,7 @@
 TargetComponent::TargetComponent(Actor * owner)
 	:Component(owner)
 {
-	mOwner->GetGame()->GetHUD()->AddTargetComponent(this);
+	mHUDHandle = mOwner->GetGame()->GetHUD()->AddTargetComponent(this);
 }
 
 TargetComponent::~TargetComponent()
@@ -8,6 +8,7 @@
 
 #pragma once
 #include "Component.h"
+#include "SlotMap.h"
 
 class TargetComponent : public Component
 {
@@ -15,4 +16,10 @@ public:
 	TargetComponent(class Actor* owner);
 	~TargetComponent();
 	TypeID GetType() const override { return TTargetComponent; }
+	COMPONENT_POOL(TargetComponent)
+
+	const SlotHandle& GetHUDHandle() const { return mHUDHandle; }
+private:
+	// Handle from HUD::AddTargetComponent
+	SlotHandle mHUDHandle;
 };
@@ -0,0 +1,126 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "TransformBatch.h"
+#include <cstddef>
+
+// The SSE path loads position + scale, and the rotation, as four floats each
+static_assert(offsetof(TransformBatch::Input, mScale) == 12 &&
+	offsetof(TransformBatch::Input, mRotation) == 16,
+	"TransformBatch::Input must be tightly packed");
+
+Matrix4 TransformBatch::Compose(const Vector3& pos, const Quaternion& q, float scale)
+{
+	// Rotation rows as in Matrix4::CreateFromQuaternion, times scale,
+	// with the translation in the last row
+	float x2 = q.x + q.x;
+	float y2 = q.y + q.y;
+	float z2 = q.z + q.z;
+	float xx = q.x * x2;
+	float yy = q.y * y2;
+	float zz = q.z * z2;
+	float xy = q.x * y2;
+	float xz = q.x * z2;
+	float yz = q.y * z2;
+	float wx = q.w * x2;
+	float wy = q.w * y2;
+	float wz = q.w * z2;
+
+	float mat[4][4] =
+	{
+		{ (1.0f - yy - zz) * scale, (xy + wz) * scale, (xz - wy) * scale, 0.0f },
+		{ (xy - wz) * scale, (1.0f - xx - zz) * scale, (yz + wx) * scale, 0.0f },
+		{ (xz + wy) * scale, (yz - wx) * scale, (1.0f - xx - yy) * scale, 0.0f },
+		{ pos.x, pos.y, pos.z, 1.0f }
+	};
+	return Matrix4(mat);
+}
+
+void TransformBatch::ComposeBatch(const Input* inputs, Matrix4* outputs, size_t count)
+{
+	size_t i = 0;
+#ifdef MATH_SIMD
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4)
+	{
+		// Load four inputs, and transpose so each register
+		// holds one component of all four
+		__m128 px = _mm_loadu_ps(&inputs[i].mPosition.x);
+		__m128 py = _mm_loadu_ps(&inputs[i + 1].mPosition.x);
+		__m128 pz = _mm_loadu_ps(&inputs[i + 2].mPosition.x);
+		__m128 s = _mm_loadu_ps(&inputs[i + 3].mPosition.x);
+		_MM_TRANSPOSE4_PS(px, py, pz, s);
+		__m128 qx = _mm_loadu_ps(&inputs[i].mRotation.x);
+		__m128 qy = _mm_loadu_ps(&inputs[i + 1].mRotation.x);
+		__m128 qz = _mm_loadu_ps(&inputs[i + 2].mRotation.x);
+		__m128 qw = _mm_loadu_ps(&inputs[i + 3].mRotation.x);
+		_MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+		__m128 x2 = _mm_add_ps(qx, qx);
+		__m128 y2 = _mm_add_ps(qy, qy);
+		__m128 z2 = _mm_add_ps(qz, qz);
+		__m128 xx = _mm_mul_ps(qx, x2);
+		__m128 yy = _mm_mul_ps(qy, y2);
+		__m128 zz = _mm_mul_ps(qz, z2);
+		__m128 xy = _mm_mul_ps(qx, y2);
+		__m128 xz = _mm_mul_ps(qx, z2);
+		__m128 yz = _mm_mul_ps(qy, z2);
+		__m128 wx = _mm_mul_ps(qw, x2);
+		__m128 wy = _mm_mul_ps(qw, y2);
+		__m128 wz = _mm_mul_ps(qw, z2);
+
+		__m128 m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), s);
+		__m128 m01 = _mm_mul_ps(_mm_add_ps(xy, wz), s);
+		__m128 m02 = _mm_mul_ps(_mm_sub_ps(xz, wy), s);
+		__m128 m03 = zero;
+		__m128 m10 = _mm_mul_ps(_mm_sub_ps(xy, wz), s);
+		__m128 m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), s);
+		__m128 m12 = _mm_mul_ps(_mm_add_ps(yz, wx), s);
+		__m128 m13 = zero;
+		__m128 m20 = _mm_mul_ps(_mm_add_ps(xz, wy), s);
+		__m128 m21 = _mm_mul_ps(_mm_sub_ps(yz, wx), s);
+		__m128 m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), s);
+		__m128 m23 = zero;
+		__m128 m33 = one;
+
+		// Transpose back, so each register is one row of one matrix
+		_MM_TRANSPOSE4_PS(m00, m01, m02, m03);
+		_MM_TRANSPOSE4_PS(m10, m11, m12, m13);
+		_MM_TRANSPOSE4_PS(m20, m21, m22, m23);
+		_MM_TRANSPOSE4_PS(px, py, pz, m33);
+
+		_mm_storeu_ps(outputs[i].mat[0], m00);
+		_mm_storeu_ps(outputs[i].mat[1], m10);
+		_mm_storeu_ps(outputs[i].mat[2], m20);
+		_mm_storeu_ps(outputs[i].mat[3], px);
+		_mm_storeu_ps(outputs[i + 1].mat[0], m01);
+		_mm_storeu_ps(outputs[i + 1].mat[1], m11);
+		_mm_storeu_ps(outputs[i + 1].mat[2], m21);
+		_mm_storeu_ps(outputs[i + 1].mat[3], py);
+		_mm_storeu_ps(outputs[i + 2].mat[0], m02);
+		_mm_storeu_ps(outputs[i + 2].mat[1], m12);
+		_mm_storeu_ps(outputs[i + 2].mat[2], m22);
+		_mm_storeu_ps(outputs[i + 2].mat[3], pz);
+		_mm_storeu_ps(outputs[i + 3].mat[0], m03);
+		_mm_storeu_ps(outputs[i + 3].mat[1], m13);
+		_mm_storeu_ps(outputs[i + 3].mat[2], m23);
+		_mm_storeu_ps(outputs[i + 3].mat[3], m33);
+	}
+#endif
+	// Whatever's left over (or everything, without SSE)
+	ComposeBatchScalar(inputs + i, outputs + i, count - i);
+}
+
+void TransformBatch::ComposeBatchScalar(const Input* inputs, Matrix4* outputs, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		outputs[i] = Compose(inputs[i].mPosition, inputs[i].mRotation, inputs[i].mScale);
+	}
+}
@@ -0,0 +1,32 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include "Math.h"
+#include <cstddef>
+
+// Builds world transforms (scale, then rotate, then translate) straight
+// from position, rotation and scale, without multiplying matrices
+class TransformBatch
+{
+public:
+	// Everything needed for one world transform
+	struct Input
+	{
+		Vector3 mPosition;
+		float mScale;
+		Quaternion mRotation;
+	};
+
+	static Matrix4 Compose(const Vector3& pos, const Quaternion& rot, float scale);
+
+	// Compose count transforms (four at a time, when SSE is available)
+	static void ComposeBatch(const Input* inputs, Matrix4* outputs, size_t count);
+	// Same, but always one at a time
+	static void ComposeBatchScalar(const Input* inputs, Matrix4* outputs, size_t count);
+};
@@ -13,6 +13,12 @@
 #include "Renderer.h"
 #include "Font.h"
 
+namespace
+{
+	const Shader::Uniform<Matrix4> cWorldTransform =
+		Shader::GetUniform<Matrix4>("uWorldTransform");
+}
+
 UIScreen::UIScreen(Game* game)
 	:mGame(game)
 	,mTitle(nullptr)
@@ -79,8 +85,8 @@ void UIScreen::ProcessInput(const uint8_t* keys)
 	if (!mButtons.empty())
 	{
 		// Get position of mouse
-		int x, y;
-		SDL_GetMouseState(&x, &y);
+		int x = mGame->GetInput().mMouseX;
+		int y = mGame->GetInput().mMouseY;
 		// Convert to (0,0) center coordinates
 		Vector2 mousePos(static_cast<float>(x), static_cast<float>(y));
 		mousePos.x -= mGame->GetRenderer()->GetScreenWidth() * 0.5f;
@@ -173,7 +179,7 @@ void UIScreen::DrawTexture(class Shader* shader, class Texture* texture,
 
 	// Set world transform
 	Matrix4 world = scaleMat * transMat;
-	shader->SetMatrixUniform("uWorldTransform", world);
+	shader->SetUniform(cWorldTransform, world);
 	// Set current texture
 	texture->SetActive();
 	// Draw quad
@@ -0,0 +1,264 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "VectorStream.h"
+
+void VectorStream::Resize(size_t size)
+{
+	mX.resize(size);
+	mY.resize(size);
+	mZ.resize(size);
+}
+
+void VectorStream::Reserve(size_t size)
+{
+	mX.reserve(size);
+	mY.reserve(size);
+	mZ.reserve(size);
+}
+
+void VectorStream::Clear()
+{
+	mX.clear();
+	mY.clear();
+	mZ.clear();
+}
+
+void VectorStream::PushBack(const Vector3& v)
+{
+	mX.emplace_back(v.x);
+	mY.emplace_back(v.y);
+	mZ.emplace_back(v.z);
+}
+
+void VectorStream::Transform(const VectorStream& in, const Matrix4& mat,
+	VectorStream& out, float w)
+{
+	size_t count = in.GetSize();
+	out.Resize(count);
+	const float* x = in.GetX();
+	const float* y = in.GetY();
+	const float* z = in.GetZ();
+	float* ox = out.GetX();
+	float* oy = out.GetY();
+	float* oz = out.GetZ();
+	// Translation times w is the same for every point
+	float tx = w * mat.mat[3][0];
+	float ty = w * mat.mat[3][1];
+	float tz = w * mat.mat[3][2];
+
+	size_t i = 0;
+#ifdef MATH_SIMD
+	const __m128 m00 = _mm_set1_ps(mat.mat[0][0]);
+	const __m128 m01 = _mm_set1_ps(mat.mat[0][1]);
+	const __m128 m02 = _mm_set1_ps(mat.mat[0][2]);
+	const __m128 m10 = _mm_set1_ps(mat.mat[1][0]);
+	const __m128 m11 = _mm_set1_ps(mat.mat[1][1]);
+	const __m128 m12 = _mm_set1_ps(mat.mat[1][2]);
+	const __m128 m20 = _mm_set1_ps(mat.mat[2][0]);
+	const __m128 m21 = _mm_set1_ps(mat.mat[2][1]);
+	const __m128 m22 = _mm_set1_ps(mat.mat[2][2]);
+	const __m128 vtx = _mm_set1_ps(tx);
+	const __m128 vty = _mm_set1_ps(ty);
+	const __m128 vtz = _mm_set1_ps(tz);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 vx = _mm_loadu_ps(x + i);
+		__m128 vy = _mm_loadu_ps(y + i);
+		__m128 vz = _mm_loadu_ps(z + i);
+		__m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m00), _mm_mul_ps(vy, m10)),
+			_mm_add_ps(_mm_mul_ps(vz, m20), vtx));
+		__m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m01), _mm_mul_ps(vy, m11)),
+			_mm_add_ps(_mm_mul_ps(vz, m21), vty));
+		__m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m02), _mm_mul_ps(vy, m12)),
+			_mm_add_ps(_mm_mul_ps(vz, m22), vtz));
+		_mm_storeu_ps(ox + i, rx);
+		_mm_storeu_ps(oy + i, ry);
+		_mm_storeu_ps(oz + i, rz);
+	}
+#endif
+	// Whatever's left (or everything, without SIMD)
+	for (; i < count; i++)
+	{
+		float vx = x[i];
+		float vy = y[i];
+		float vz = z[i];
+		ox[i] = vx * mat.mat[0][0] + vy * mat.mat[1][0] + vz * mat.mat[2][0] + tx;
+		oy[i] = vx * mat.mat[0][1] + vy * mat.mat[1][1] + vz * mat.mat[2][1] + ty;
+		oz[i] = vx * mat.mat[0][2] + vy * mat.mat[1][2] + vz * mat.mat[2][2] + tz;
+	}
+}
+
+void VectorStream::Transform(const VectorStream& in, const Quaternion& q,
+	VectorStream& out)
+{
+	// v + 2.0*cross(q.xyz, cross(q.xyz,v) + q.w*v), as in Vector3::Transform
+	size_t count = in.GetSize();
+	out.Resize(count);
+	const float* x = in.GetX();
+	const float* y = in.GetY();
+	const float* z = in.GetZ();
+	float* ox = out.GetX();
+	float* oy = out.GetY();
+	float* oz = out.GetZ();
+
+	size_t i = 0;
+#ifdef MATH_SIMD
+	const __m128 qx = _mm_set1_ps(q.x);
+	const __m128 qy = _mm_set1_ps(q.y);
+	const __m128 qz = _mm_set1_ps(q.z);
+	const __m128 qw = _mm_set1_ps(q.w);
+	const __m128 two = _mm_set1_ps(2.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 vx = _mm_loadu_ps(x + i);
+		__m128 vy = _mm_loadu_ps(y + i);
+		__m128 vz = _mm_loadu_ps(z + i);
+		// c = cross(q.xyz, v) + q.w * v
+		__m128 cx = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(qy, vz), _mm_mul_ps(qz, vy)),
+			_mm_mul_ps(qw, vx));
+		__m128 cy = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(qz, vx), _mm_mul_ps(qx, vz)),
+			_mm_mul_ps(qw, vy));
+		__m128 cz = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(qx, vy), _mm_mul_ps(qy, vx)),
+			_mm_mul_ps(qw, vz));
+		// v + 2 * cross(q.xyz, c)
+		__m128 rx = _mm_sub_ps(_mm_mul_ps(qy, cz), _mm_mul_ps(qz, cy));
+		__m128 ry = _mm_sub_ps(_mm_mul_ps(qz, cx), _mm_mul_ps(qx, cz));
+		__m128 rz = _mm_sub_ps(_mm_mul_ps(qx, cy), _mm_mul_ps(qy, cx));
+		_mm_storeu_ps(ox + i, _mm_add_ps(vx, _mm_mul_ps(two, rx)));
+		_mm_storeu_ps(oy + i, _mm_add_ps(vy, _mm_mul_ps(two, ry)));
+		_mm_storeu_ps(oz + i, _mm_add_ps(vz, _mm_mul_ps(two, rz)));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		Vector3 v = Vector3::Transform(Vector3(x[i], y[i], z[i]), q);
+		ox[i] = v.x;
+		oy[i] = v.y;
+		oz[i] = v.z;
+	}
+}
+
+void VectorStream::Dot(const VectorStream& in, const Vector3& v, float* outValues)
+{
+	size_t count = in.GetSize();
+	const float* x = in.GetX();
+	const float* y = in.GetY();
+	const float* z = in.GetZ();
+
+	size_t i = 0;
+#ifdef MATH_SIMD
+	const __m128 dx = _mm_set1_ps(v.x);
+	const __m128 dy = _mm_set1_ps(v.y);
+	const __m128 dz = _mm_set1_ps(v.z);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 r = _mm_mul_ps(_mm_loadu_ps(x + i), dx);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(y + i), dy));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(z + i), dz));
+		_mm_storeu_ps(outValues + i, r);
+	}
+#endif
+	for (; i < count; i++)
+	{
+		outValues[i] = x[i] * v.x + y[i] * v.y + z[i] * v.z;
+	}
+}
+
+void VectorStream::DistanceSq(const VectorStream& in, const Vector3& point,
+	float* outValues)
+{
+	size_t count = in.GetSize();
+	const float* x = in.GetX();
+	const float* y = in.GetY();
+	const float* z = in.GetZ();
+
+	size_t i = 0;
+#ifdef MATH_SIMD
+	const __m128 px = _mm_set1_ps(point.x);
+	const __m128 py = _mm_set1_ps(point.y);
+	const __m128 pz = _mm_set1_ps(point.z);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), px);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), py);
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(z + i), pz);
+		__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+			_mm_mul_ps(dz, dz));
+		_mm_storeu_ps(outValues + i, r);
+	}
+#endif
+	for (; i < count; i++)
+	{
+		float dx = x[i] - point.x;
+		float dy = y[i] - point.y;
+		float dz = z[i] - point.z;
+		outValues[i] = dx * dx + dy * dy + dz * dz;
+	}
+}
+
+void VectorStream::MinMax(const VectorStream& in, Vector3& outMin, Vector3& outMax)
+{
+	size_t count = in.GetSize();
+	const float* x = in.GetX();
+	const float* y = in.GetY();
+	const float* z = in.GetZ();
+	outMin = Vector3::Infinity;
+	outMax = Vector3::NegInfinity;
+
+	size_t i = 0;
+#ifdef MATH_SIMD
+	if (count >= 4)
+	{
+		// Four running mins/maxes per axis, combined at the end
+		__m128 minX = _mm_loadu_ps(x);
+		__m128 minY = _mm_loadu_ps(y);
+		__m128 minZ = _mm_loadu_ps(z);
+		__m128 maxX = minX;
+		__m128 maxY = minY;
+		__m128 maxZ = minZ;
+		for (i = 4; i + 4 <= count; i += 4)
+		{
+			__m128 vx = _mm_loadu_ps(x + i);
+			__m128 vy = _mm_loadu_ps(y + i);
+			__m128 vz = _mm_loadu_ps(z + i);
+			minX = _mm_min_ps(minX, vx);
+			minY = _mm_min_ps(minY, vy);
+			minZ = _mm_min_ps(minZ, vz);
+			maxX = _mm_max_ps(maxX, vx);
+			maxY = _mm_max_ps(maxY, vy);
+			maxZ = _mm_max_ps(maxZ, vz);
+		}
+		float lanes[6][4];
+		_mm_storeu_ps(lanes[0], minX);
+		_mm_storeu_ps(lanes[1], minY);
+		_mm_storeu_ps(lanes[2], minZ);
+		_mm_storeu_ps(lanes[3], maxX);
+		_mm_storeu_ps(lanes[4], maxY);
+		_mm_storeu_ps(lanes[5], maxZ);
+		for (int j = 0; j < 4; j++)
+		{
+			outMin.x = Math::Min(outMin.x, lanes[0][j]);
+			outMin.y = Math::Min(outMin.y, lanes[1][j]);
+			outMin.z = Math::Min(outMin.z, lanes[2][j]);
+			outMax.x = Math::Max(outMax.x, lanes[3][j]);
+			outMax.y = Math::Max(outMax.y, lanes[4][j]);
+			outMax.z = Math::Max(outMax.z, lanes[5][j]);
+		}
+	}
+#endif
+	for (; i < count; i++)
+	{
+		outMin.x = Math::Min(outMin.x, x[i]);
+		outMin.y = Math::Min(outMin.y, y[i]);
+		outMin.z = Math::Min(outMin.z, z[i]);
+		outMax.x = Math::Max(outMax.x, x[i]);
+		outMax.y = Math::Max(outMax.y, y[i]);
+		outMax.z = Math::Max(outMax.z, z[i]);
+	}
+}
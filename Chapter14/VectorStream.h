@@ -0,0 +1,61 @@
+// ----------------------------------------------------------------
+// From Game Programming in C++ by Sanjay Madhav
+// Copyright (C) 2017 Sanjay Madhav. All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "Math.h"
+
+// Many points stored as separate x, y and z arrays (structure of
+// arrays) instead of an array of Vector3, so the kernels below can
+// process four points per SIMD instruction
+class VectorStream
+{
+public:
+	VectorStream() { }
+	explicit VectorStream(size_t size) { Resize(size); }
+
+	size_t GetSize() const { return mX.size(); }
+	void Resize(size_t size);
+	void Reserve(size_t size);
+	void Clear();
+
+	void PushBack(const Vector3& v);
+	void Set(size_t i, const Vector3& v)
+	{
+		mX[i] = v.x;
+		mY[i] = v.y;
+		mZ[i] = v.z;
+	}
+	Vector3 Get(size_t i) const { return Vector3(mX[i], mY[i], mZ[i]); }
+
+	float* GetX() { return mX.data(); }
+	float* GetY() { return mY.data(); }
+	float* GetZ() { return mZ.data(); }
+	const float* GetX() const { return mX.data(); }
+	const float* GetY() const { return mY.data(); }
+	const float* GetZ() const { return mZ.data(); }
+
+	// Kernels. out is resized to match in, and may be the same stream.
+	// Same as Vector3::Transform on every point
+	static void Transform(const VectorStream& in, const Matrix4& mat,
+		VectorStream& out, float w = 1.0f);
+	static void Transform(const VectorStream& in, const Quaternion& q,
+		VectorStream& out);
+	// outValues must have room for one float per point
+	static void Dot(const VectorStream& in, const Vector3& v, float* outValues);
+	static void DistanceSq(const VectorStream& in, const Vector3& point,
+		float* outValues);
+	// Smallest and largest x, y and z over all points
+	// (for an empty stream, min is infinity and max is -infinity)
+	static void MinMax(const VectorStream& in, Vector3& outMin, Vector3& outMax);
+private:
+	std::vector<float> mX;
+	std::vector<float> mY;
+	std::vector<float> mZ;
+};
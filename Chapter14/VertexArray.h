@@ -24,6 +24,7 @@ public:
 	void SetActive();
 	unsigned int GetNumIndices() const { return mNumIndices; }
 	unsigned int GetNumVerts() const { return mNumVerts; }
+	unsigned int GetVertexArrayID() const { return mVertexArray; }
 
 	static unsigned int GetVertexSize(VertexArray::Layout layout);
 private: